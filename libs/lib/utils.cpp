@@ -145,8 +145,16 @@ Utils::writeMatrix(double ** matrix,
 void
 Utils::fft(fftw_real* rAmp,fftw_complex* cAmp,int nt)
 {
-  rfftwnd_plan p1 = rfftwnd_create_plan(1, &nt, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
+  rfftwnd_plan p1;
+  // FFTW plan creation and destruction are not thread safe
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+  p1 = rfftwnd_create_plan(1, &nt, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
   rfftwnd_one_real_to_complex(p1, rAmp, cAmp);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   fftwnd_destroy_plan(p1);
 }
 
@@ -154,8 +162,15 @@ Utils::fft(fftw_real* rAmp,fftw_complex* cAmp,int nt)
 void
 Utils::fftInv(fftw_complex* cAmp,fftw_real* rAmp,int nt)
 {
-  rfftwnd_plan p2 = rfftwnd_create_plan(1, &nt, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
+  rfftwnd_plan p2;
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+  p2 = rfftwnd_create_plan(1, &nt, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
   rfftwnd_one_complex_to_real(p2, cAmp, rAmp);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   fftwnd_destroy_plan(p2);
   double sf = 1.0/double(nt);
   for(int i=0;i<nt;i++)
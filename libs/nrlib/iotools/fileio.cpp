@@ -27,12 +27,22 @@
 #define BOOST_FILESYSTEM_VERSION 2
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <locale>
 #include <sstream>
 #include <string>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#  define NRLIB_FILEIO_SSE2
+#  include <emmintrin.h>
+#endif
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
 using namespace NRLib::NRLibPrivate;
 using namespace NRLib;
 
@@ -666,6 +676,261 @@ float NRLib::ReadBinaryIbmFloat(std::istream& stream,
   return f;
 }
 
+
+// -----------------  Bulk conversion of 32 bit words -------------------
+
+
+static bool IsNativeByteOrder(Endianess number_representation)
+{
+  FloatAsInt tmp;
+  tmp.ui = 1;
+  bool little_endian = (*reinterpret_cast<unsigned char*>(&tmp) == 1);
+  return (number_representation == END_LITTLE_ENDIAN) == little_endian;
+}
+
+
+static inline void SwapBytes32(/*uint32_t*/ unsigned int& ui)
+{
+  ui = (ui >> 24) | ((ui >> 8) & masks[1]) | ((ui << 8) & masks[2]) | (ui << 24);
+}
+
+
+#ifdef NRLIB_FILEIO_SSE2
+
+static inline __m128i SwapBytes32(__m128i x)
+{
+  const __m128i mask1 = _mm_set1_epi32(static_cast<int>(masks[1]));
+  const __m128i mask2 = _mm_set1_epi32(static_cast<int>(masks[2]));
+
+  __m128i y = _mm_or_si128(_mm_srli_epi32(x, 24), _mm_slli_epi32(x, 24));
+  y = _mm_or_si128(y, _mm_and_si128(_mm_srli_epi32(x, 8), mask1));
+  return _mm_or_si128(y, _mm_and_si128(_mm_slli_epi32(x, 8), mask2));
+}
+
+
+// Same as Ibm2Ieee(), with the table lookups replaced by lane masks.
+static inline __m128i Ibm2Ieee(__m128i in)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi32(1);
+
+  __m128i manthi = _mm_and_si128(in, _mm_set1_epi32(0x00ffffff));
+  __m128i ix     = _mm_srli_epi32(manthi, 21);
+  __m128i is0    = _mm_cmpeq_epi32(ix, zero);
+  __m128i is1    = _mm_cmpeq_epi32(ix, one);
+  __m128i is23   = _mm_cmpeq_epi32(_mm_srli_epi32(ix, 1), one);
+
+  __m128i it = _mm_set1_epi32(0x20c00000);
+  it = _mm_add_epi32(it, _mm_and_si128(is0,  _mm_set1_epi32(0x00c00000)));
+  it = _mm_add_epi32(it, _mm_and_si128(is1,  _mm_set1_epi32(0x00800000)));
+  it = _mm_add_epi32(it, _mm_and_si128(is23, _mm_set1_epi32(0x00400000)));
+
+  __m128i iexp = _mm_slli_epi32(_mm_sub_epi32(_mm_and_si128(in, _mm_set1_epi32(0x7f000000)), it), 1);
+
+  __m128i mant = _mm_andnot_si128(_mm_or_si128(is0, _mm_or_si128(is1, is23)), manthi);
+  mant   = _mm_or_si128(mant, _mm_and_si128(is0,  _mm_slli_epi32(manthi, 3)));
+  mant   = _mm_or_si128(mant, _mm_and_si128(is1,  _mm_slli_epi32(manthi, 2)));
+  mant   = _mm_or_si128(mant, _mm_and_si128(is23, _mm_slli_epi32(manthi, 1)));
+  manthi = _mm_add_epi32(mant, iexp);
+
+  __m128i inabs    = _mm_and_si128(in, _mm_set1_epi32(0x7fffffff));
+  __m128i overflow = _mm_cmpgt_epi32(inabs, _mm_set1_epi32(static_cast<int>(IEMAXIB)));
+  manthi = _mm_or_si128(_mm_andnot_si128(overflow, manthi),
+                        _mm_and_si128(overflow, _mm_set1_epi32(static_cast<int>(IEEEMAX))));
+  manthi = _mm_or_si128(manthi, _mm_andnot_si128(_mm_set1_epi32(0x7fffffff), in));
+
+  __m128i underflow = _mm_cmplt_epi32(inabs, _mm_set1_epi32(static_cast<int>(IEMINIB)));
+  return _mm_andnot_si128(underflow, manthi);
+}
+
+
+// Same as Ieee2Ibm(), with the table lookups replaced by lane masks.
+static inline __m128i Ieee2Ibm(__m128i in)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  __m128i ix  = _mm_srli_epi32(_mm_and_si128(in, _mm_set1_epi32(0x01800000)), 23);
+  __m128i is0 = _mm_cmpeq_epi32(ix, zero);
+  __m128i is1 = _mm_cmpeq_epi32(ix, _mm_set1_epi32(1));
+  __m128i is2 = _mm_cmpeq_epi32(ix, _mm_set1_epi32(2));
+  __m128i is3 = _mm_cmpeq_epi32(ix, _mm_set1_epi32(3));
+
+  __m128i it = _mm_and_si128(is0, _mm_set1_epi32(0x21200000));
+  it = _mm_or_si128(it, _mm_and_si128(is1, _mm_set1_epi32(0x21400000)));
+  it = _mm_or_si128(it, _mm_and_si128(is2, _mm_set1_epi32(0x21800000)));
+  it = _mm_or_si128(it, _mm_and_si128(is3, _mm_set1_epi32(0x22100000)));
+
+  __m128i iexp = _mm_add_epi32(_mm_srli_epi32(_mm_and_si128(in, _mm_set1_epi32(0x7e000000)), 1), it);
+
+  // (mt*mant) >> 3 with mt = 2, 4, 8, 1
+  __m128i mant   = _mm_and_si128(in, _mm_set1_epi32(0x007fffff));
+  __m128i manthi = _mm_and_si128(is0, _mm_srli_epi32(mant, 2));
+  manthi = _mm_or_si128(manthi, _mm_and_si128(is1, _mm_srli_epi32(mant, 1)));
+  manthi = _mm_or_si128(manthi, _mm_and_si128(is2, mant));
+  manthi = _mm_or_si128(manthi, _mm_and_si128(is3, _mm_srli_epi32(mant, 3)));
+  manthi = _mm_add_epi32(manthi, iexp);
+  manthi = _mm_or_si128(manthi, _mm_andnot_si128(_mm_set1_epi32(0x7fffffff), in));
+
+  __m128i is_zero = _mm_cmpeq_epi32(_mm_and_si128(in, _mm_set1_epi32(0x7fffffff)), zero);
+  return _mm_andnot_si128(is_zero, manthi);
+}
+
+#endif
+
+
+void NRLib::NRLibPrivate::ConvertByteOrder32(/*uint32_t*/ unsigned int* buffer,
+                                             size_t                     n,
+                                             Endianess                  number_representation)
+{
+  if (IsNativeByteOrder(number_representation))
+    return;
+
+  size_t i = 0;
+#ifdef NRLIB_FILEIO_SSE2
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), SwapBytes32(x));
+  }
+#endif
+  for (; i < n; ++i)
+    SwapBytes32(buffer[i]);
+}
+
+
+void NRLib::NRLibPrivate::ParseIBMFloatArray(/*uint32_t*/ unsigned int* buffer,
+                                             size_t                     n,
+                                             Endianess                  number_representation)
+{
+  bool swap = !IsNativeByteOrder(number_representation);
+
+  size_t i = 0;
+#ifdef NRLIB_FILEIO_SSE2
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+    if (swap)
+      x = SwapBytes32(x);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), Ibm2Ieee(x));
+  }
+#endif
+  for (; i < n; ++i) {
+    if (swap)
+      SwapBytes32(buffer[i]);
+    Ibm2Ieee(buffer[i]);
+  }
+}
+
+
+void NRLib::NRLibPrivate::WriteIBMFloatArray(/*uint32_t*/ unsigned int* buffer,
+                                             size_t                     n,
+                                             Endianess                  number_representation)
+{
+  bool swap = !IsNativeByteOrder(number_representation);
+
+  size_t i = 0;
+#ifdef NRLIB_FILEIO_SSE2
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = Ieee2Ibm(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i)));
+    if (swap)
+      x = SwapBytes32(x);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), x);
+  }
+#endif
+  for (; i < n; ++i) {
+    Ieee2Ibm(buffer[i]);
+    if (swap)
+      SwapBytes32(buffer[i]);
+  }
+}
+
+
+// Number of values moved per read or write in the float buffer functions.
+static const size_t float_buffer_chunk = 1 << 20;
+
+
+void NRLib::WriteBinaryFloatBuffer(std::ostream& stream,
+                                   const float* data,
+                                   size_t n,
+                                   Endianess number_representation)
+{
+  if (number_representation != END_BIG_ENDIAN && number_representation != END_LITTLE_ENDIAN)
+    throw Exception("Invalid number representation.");
+
+  int n_chunks = static_cast<int>((n + float_buffer_chunk - 1) / float_buffer_chunk);
+
+  // Chunks are converted in parallel and written in file order
+  bool ok = true;
+#ifdef PARALLEL
+  int n_threads = std::min(omp_get_max_threads(), std::max(n_chunks, 1));
+#pragma omp parallel for schedule(static, 1) ordered num_threads(n_threads)
+#endif
+  for (int c = 0; c < n_chunks; c++) {
+    size_t start = c * float_buffer_chunk;
+    size_t n_c   = std::min(float_buffer_chunk, n - start);
+
+    std::vector<unsigned int> buffer(n_c);
+    for (size_t i = 0; i < n_c; ++i) {
+      FloatAsInt tmp;
+      tmp.f     = data[start + i];
+      buffer[i] = tmp.ui;
+    }
+    ConvertByteOrder32(&buffer[0], n_c, number_representation);
+
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
+    {
+      if (ok && !stream.write(reinterpret_cast<const char*>(&buffer[0]), static_cast<std::streamsize>(4*n_c)))
+        ok = false;
+    }
+  }
+
+  if (!ok) {
+    throw Exception("Error writing to stream.");
+  }
+}
+
+
+void NRLib::ReadBinaryFloatBuffer(std::istream& stream,
+                                  float* data,
+                                  size_t n,
+                                  Endianess number_representation)
+{
+  if (number_representation != END_BIG_ENDIAN && number_representation != END_LITTLE_ENDIAN)
+    throw Exception("Invalid number representation.");
+
+  int n_chunks = static_cast<int>((n + float_buffer_chunk - 1) / float_buffer_chunk);
+
+  // Chunks are read in file order straight into data, and converted in
+  // place while the following chunks are read
+  bool ok = true;
+#ifdef PARALLEL
+  int n_threads = std::min(omp_get_max_threads(), std::max(n_chunks, 1));
+#pragma omp parallel for schedule(static, 1) ordered num_threads(n_threads)
+#endif
+  for (int c = 0; c < n_chunks; c++) {
+    size_t start = c * float_buffer_chunk;
+    size_t n_c   = std::min(float_buffer_chunk, n - start);
+    bool   read  = false;
+
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
+    {
+      if (ok && !stream.read(reinterpret_cast<char*>(data + start), static_cast<std::streamsize>(4*n_c)))
+        ok = false;
+      read = ok;
+    }
+
+    if (read)
+      ConvertByteOrder32(reinterpret_cast<unsigned int*>(data + start), n_c, number_representation);
+  }
+
+  if (!ok) {
+    throw Exception("Error reading from stream (h).");
+  }
+}
+
+
 void NRLib::ReadNextQuoted(std::istream& stream, char quote, std::string&  s, int& line)
 {
   char c = 0;
@@ -258,6 +258,23 @@ namespace NRLib {
                          size_t n,
                          Endianess number_representation = END_BIG_ENDIAN);
 
+  /// \brief Write n 4-byte floats from contiguous memory on standard IEEE format.
+  /// \note  The data are written in large chunks, and the conversion of one
+  ///        chunk runs in parallel with the output of the previous ones,
+  ///        on at most omp_get_max_threads() threads.
+  void WriteBinaryFloatBuffer(std::ostream& stream,
+                              const float* data,
+                              size_t n,
+                              Endianess number_representation = END_BIG_ENDIAN);
+
+  /// \brief Read n 4-byte floats on standard IEEE format directly into
+  ///        contiguous memory, which must hold at least n elements.
+  /// \note  Chunks are converted on at most omp_get_max_threads() threads.
+  void ReadBinaryFloatBuffer(std::istream& stream,
+                             float* data,
+                             size_t n,
+                             Endianess number_representation = END_BIG_ENDIAN);
+
   // ---------------------------------
   // 8-byte IEEE floating point number
   // ---------------------------------
@@ -415,6 +432,18 @@ namespace NRLibPrivate {
 
   /// Write IEEE double-precision float to little-endian buffer.
   inline void WriteIBMFloatLE(char* buffer, float f);
+
+  // Bulk conversion of contiguous buffers of 4-byte words, done in place.
+  // These are used by the array functions, and are vectorised where SSE2 is available.
+
+  /// Swap byte order of the words if number_representation differs from the native one.
+  void ConvertByteOrder32(/*uint32_t*/ unsigned int* buffer, size_t n, Endianess number_representation);
+
+  /// IBM floats in number_representation to native IEEE floats.
+  void ParseIBMFloatArray(/*uint32_t*/ unsigned int* buffer, size_t n, Endianess number_representation);
+
+  /// Native IEEE floats to IBM floats in number_representation.
+  void WriteIBMFloatArray(/*uint32_t*/ unsigned int* buffer, size_t n, Endianess number_representation);
 } // namespace NRLibPrivate
 
 } // namespace NRLib
@@ -662,24 +691,23 @@ void NRLib::WriteBinaryFloatArray(std::ostream& stream,
   using namespace NRLib::NRLibPrivate;
 
   typename I::difference_type n_char = 4*std::distance(begin, end);
-  std::vector<char> buffer(n_char);
+  std::vector<unsigned int> buffer(n_char/4);
+  FloatAsInt tmp;
 
   switch (number_representation) {
   case END_BIG_ENDIAN:
-    for (int i = 0; begin != end; ++begin, ++i) {
-      WriteIEEEFloatBE(&buffer[4*i], *begin);
-    }
-    break;
   case END_LITTLE_ENDIAN:
     for (int i = 0; begin != end; ++begin, ++i) {
-      WriteIEEEFloatLE(&buffer[4*i], *begin);
+      tmp.f     = static_cast<float>(*begin);
+      buffer[i] = tmp.ui;
     }
+    ConvertByteOrder32(&buffer[0], buffer.size(), number_representation);
     break;
   default:
     throw Exception("Invalid number representation.");
   }
 
-  if (!stream.write(&buffer[0], static_cast<std::streamsize>(n_char))) {
+  if (!stream.write(reinterpret_cast<const char*>(&buffer[0]), static_cast<std::streamsize>(n_char))) {
     throw Exception("Error writing to stream.");
   }
 }
@@ -692,25 +720,20 @@ I NRLib::ReadBinaryFloatArray(std::istream& stream,
 {
   using namespace NRLib::NRLibPrivate;
 
-  std::vector<char> buffer(4*n);
-  float f;
+  std::vector<unsigned int> buffer(n);
+  FloatAsInt tmp;
 
-  if (!stream.read(&buffer[0], static_cast<std::streamsize>(4*n))) {
+  if (!stream.read(reinterpret_cast<char*>(&buffer[0]), static_cast<std::streamsize>(4*n))) {
     throw Exception("Error reading from stream (h).");
   }
 
   switch (number_representation) {
   case END_BIG_ENDIAN:
-    for (size_t i = 0; i < n; ++i) {
-      ParseIEEEFloatBE(&buffer[4*i], f);
-      *begin = static_cast<typename std::iterator_traits<I>::value_type>(f);
-      ++begin;
-    }
-    break;
   case END_LITTLE_ENDIAN:
+    ConvertByteOrder32(&buffer[0], n, number_representation);
     for (size_t i = 0; i < n; ++i) {
-      ParseIEEEFloatLE(&buffer[4*i], f);
-      *begin = static_cast<typename std::iterator_traits<I>::value_type>(f);
+      tmp.ui = buffer[i];
+      *begin = static_cast<typename std::iterator_traits<I>::value_type>(tmp.f);
       ++begin;
     }
     break;
@@ -801,24 +824,23 @@ void NRLib::WriteBinaryIbmFloatArray(std::ostream& stream,
   using namespace NRLib::NRLibPrivate;
 
   typename I::difference_type n_char = 4*std::distance(begin, end);
-  std::vector<char> buffer(n_char);
+  std::vector<unsigned int> buffer(n_char/4);
+  FloatAsInt tmp;
 
   switch (number_representation) {
   case END_BIG_ENDIAN:
-    for (int i = 0; begin != end; ++begin, ++i) {
-      WriteIBMFloatBE(&buffer[4*i], *begin);
-    }
-    break;
   case END_LITTLE_ENDIAN:
     for (int i = 0; begin != end; ++begin, ++i) {
-      WriteIBMFloatLE(&buffer[4*i], *begin);
+      tmp.f     = static_cast<float>(*begin);
+      buffer[i] = tmp.ui;
     }
+    WriteIBMFloatArray(&buffer[0], buffer.size(), number_representation);
     break;
   default:
     throw Exception("Invalid number representation.");
   }
 
-  if (!stream.write(&buffer[0], static_cast<std::streamsize>(n_char))) {
+  if (!stream.write(reinterpret_cast<const char*>(&buffer[0]), static_cast<std::streamsize>(n_char))) {
     throw Exception("Error writing to stream.");
   }
 }
@@ -832,11 +854,11 @@ I NRLib::ReadBinaryIbmFloatArray(std::istream& stream,
 {
   using namespace NRLib::NRLibPrivate;
 
-  std::vector<char> buffer(4*n);
-  float f;
+  std::vector<unsigned int> buffer(n);
+  FloatAsInt tmp;
 
   std::string error;
-  if (!stream.read(&buffer[0], static_cast<std::streamsize>(4*n))) {
+  if (!stream.read(reinterpret_cast<char*>(&buffer[0]), static_cast<std::streamsize>(4*n))) {
     if (stream.eof())
       error = "Error reading binary IBM float array. Trying to read 4*" + NRLib::ToString(n) + " elements when end-of-file was reached.\n";
     else {
@@ -846,16 +868,11 @@ I NRLib::ReadBinaryIbmFloatArray(std::istream& stream,
 
   switch (number_representation) {
   case END_BIG_ENDIAN:
-    for (size_t i = 0; i < n; ++i) {
-      ParseIBMFloatBE(&buffer[4*i], f);
-      *begin = f;
-      ++begin;
-    }
-    break;
   case END_LITTLE_ENDIAN:
+    ParseIBMFloatArray(&buffer[0], n, number_representation);
     for (size_t i = 0; i < n; ++i) {
-      ParseIBMFloatLE(&buffer[4*i], f);
-      *begin = f;
+      tmp.ui = buffer[i];
+      *begin = tmp.f;
       ++begin;
     }
     break;
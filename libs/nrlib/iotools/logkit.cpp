@@ -32,6 +32,12 @@ std::vector<LogStream*> LogKit::logstreams_(0);
 int LogKit::screenLog_ = -1;
 std::vector<BufferMessage *> * LogKit::buffer_ = NULL;
 
+// Messages held back by StartThreadBuffering, one list per thread.
+static std::vector<BufferMessage *> * thread_buffer = NULL;
+#ifdef PARALLEL
+#pragma omp threadprivate(thread_buffer)
+#endif
+
 // Making a long table to allow direct access.
 std::vector<int> LogKit::n_messages_(65, 0);
 std::vector<std::string> LogKit::prefix_(65, "");
@@ -125,21 +131,48 @@ LogKit::SetScreenLog(const std::vector<int> & levels, bool ignore_general) {
 void
 LogKit::LogMessage(int level, const std::string & message) {
   unsigned int i;
-  n_messages_[level]++;
   std::string new_message = prefix_[level] + message;
-  for (i=0;i<logstreams_.size();i++)
-    logstreams_[i]->LogMessage(level, new_message);
-  SendToBuffer(level,-1,new_message);
+  if (thread_buffer != NULL) {
+    BufferMessage * bm = new BufferMessage;
+    bm->level_ = level;
+    bm->phase_ = -1;
+    bm->text_  = new_message;
+    thread_buffer->push_back(bm);
+    return;
+  }
+  // Messages may come from several threads; keep streams and buffer consistent.
+#ifdef PARALLEL
+#pragma omp critical (logkit_message)
+#endif
+  {
+    n_messages_[level]++;
+    for (i=0;i<logstreams_.size();i++)
+      logstreams_[i]->LogMessage(level, new_message);
+    SendToBuffer(level,-1,new_message);
+  }
 }
 
 void
 LogKit::LogMessage(int level, int phase, const std::string & message) {
   unsigned int i;
-  n_messages_[level]++;
   std::string new_message = prefix_[level] + message;
-  for (i=0;i<logstreams_.size();i++)
-    logstreams_[i]->LogMessage(level, phase, new_message);
-  SendToBuffer(level,phase,new_message);
+  if (thread_buffer != NULL) {
+    BufferMessage * bm = new BufferMessage;
+    bm->level_ = level;
+    bm->phase_ = phase;
+    bm->text_  = new_message;
+    thread_buffer->push_back(bm);
+    return;
+  }
+#ifdef PARALLEL
+#pragma omp critical (logkit_message)
+#endif
+  {
+    n_messages_[level]++;
+    for (i=0;i<logstreams_.size();i++)
+      logstreams_[i]->LogMessage(level, phase, new_message);
+    SendToBuffer(level,phase,new_message);
+  }
 }
 
 void
@@ -190,6 +223,41 @@ LogKit::EndBuffering() {
   }
 }
 
+void
+LogKit::StartThreadBuffering() {
+  if (thread_buffer == NULL)
+    thread_buffer = new std::vector<BufferMessage *>;
+}
+
+void
+LogKit::EndThreadBuffering() {
+  if (thread_buffer == NULL)
+    return;
+
+  std::vector<BufferMessage *> * held = thread_buffer;
+  thread_buffer = NULL;
+
+  // Send the held messages as one block, so they are not split by other threads.
+#ifdef PARALLEL
+#pragma omp critical (logkit_message)
+#endif
+  {
+    for (unsigned int i=0;i<held->size();i++) {
+      BufferMessage * bm = (*held)[i];
+      n_messages_[bm->level_]++;
+      for (unsigned int j=0;j<logstreams_.size();j++) {
+        if (bm->phase_ < 0)
+          logstreams_[j]->LogMessage(bm->level_, bm->text_);
+        else
+          logstreams_[j]->LogMessage(bm->level_, bm->phase_, bm->text_);
+      }
+      SendToBuffer(bm->level_, bm->phase_, bm->text_);
+      delete bm;
+    }
+  }
+  delete held;
+}
+
 void
 LogKit::SendToBuffer(int level, int phase, const std::string & message) {
   if (buffer_ != NULL) {
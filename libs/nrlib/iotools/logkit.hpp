@@ -100,6 +100,12 @@ public:
   static void StartBuffering();
   static void EndBuffering();
 
+  ///Thread buffering holds back the messages from the calling thread only.
+  ///Work done in parallel can then be logged in a deterministic order by
+  ///calling EndThreadBuffering in that order, which sends the held messages.
+  static void StartThreadBuffering();
+  static void EndThreadBuffering();
+
   static void SetPrefix(const std::string & prefix, int level);
   static int GetNMessages(int level) { return n_messages_[level];}
   static void WriteHeader(const std::string & text, MessageLevels logLevel = Low);
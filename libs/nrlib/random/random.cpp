@@ -32,6 +32,7 @@ bool          Random::is_initialized_ = false;
 unsigned long Random::start_seed_     = 0;
 bool          Random::use_seed_file_  = false;
 std::string   Random::seed_file_      = "";
+dsfmt_t     * Random::thread_stream_  = NULL;
 
 void Random::Initialize() {
   unsigned long seed = static_cast<unsigned long>(time(0));
@@ -61,6 +62,16 @@ void Random::Initialize(const std::string& filename) {
   InitializeMT(start_seed_);
 }
 
+void Random::InitializeStream(dsfmt_t       * stream,
+                              unsigned long   seed,
+                              unsigned long   stream_number)
+{
+  uint32_t key[2];
+  key[0] = static_cast<uint32_t>(seed);
+  key[1] = static_cast<uint32_t>(stream_number);
+  dsfmt_init_by_array(stream, key, 2);
+}
+
 double Random::Norm01()
 {
   double u, u1, u2, u3;
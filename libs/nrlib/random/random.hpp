@@ -41,13 +41,25 @@ public:
   static void Initialize(const std::string& seed_file_);
 
   /// \return uniform number in [0,1)
-  static double Unif01()             { return dsfmt_gv_genrand_close_open(); }
+  static double Unif01()             { return (thread_stream_ == NULL ? dsfmt_gv_genrand_close_open()
+                                                                      : dsfmt_genrand_close_open(thread_stream_)); }
 
   /// \return uniform number in (0,1)
-  static double Unif01Open()             { return dsfmt_gv_genrand_open_open(); }
+  static double Unif01Open()             { return (thread_stream_ == NULL ? dsfmt_gv_genrand_open_open()
+                                                                          : dsfmt_genrand_open_open(thread_stream_)); }
 
   /// \return unsigned 32-bit integer betwen 0 and 0xFFFFFFFF
-  static unsigned long DrawUint32()  { return dsfmt_gv_genrand_uint32(); }
+  static unsigned long DrawUint32()  { return (thread_stream_ == NULL ? dsfmt_gv_genrand_uint32()
+                                                                      : dsfmt_genrand_uint32(thread_stream_)); }
+
+  /// Seeds a private stream from a base seed and a stream number. Streams with
+  /// different numbers are independent, so work can be split in numbered pieces
+  /// whose results do not depend on which thread draws them.
+  static void InitializeStream(dsfmt_t * stream, unsigned long seed, unsigned long stream_number);
+
+  /// Makes the calling thread draw from stream instead of the global generator.
+  /// Pass NULL to return to the global generator.
+  static void SetThreadStream(dsfmt_t * stream) { thread_stream_ = stream; }
 
   /// Marsaglia-Bray's method, see Ripley, p. 84.
   static double Norm01();
@@ -71,6 +83,12 @@ private:
   static bool use_seed_file_;
 
   static std::string seed_file_;
+
+  /// Stream used by the calling thread, NULL means the global generator.
+  static dsfmt_t * thread_stream_;
+#ifdef PARALLEL
+#pragma omp threadprivate(thread_stream_)
+#endif
 };
 
 }
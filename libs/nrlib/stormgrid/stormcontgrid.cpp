@@ -145,7 +145,8 @@ void StormContGrid::ReadFromFile(const std::string& filename, bool commonPath, E
     switch (file_format_) {
     case STORM_BINARY:
       DiscardRestOfLine(file, line, true);
-      ReadBinaryFloatArray(file, begin(), GetN(), number_representation);
+      if (GetN() > 0)
+        ReadBinaryFloatBuffer(file, &(*begin()), GetN(), number_representation);
       break;
     case STORM_ASCII:
       ReadAsciiArrayFast(file, begin(), GetN());
@@ -200,7 +201,8 @@ void StormContGrid::WriteToFile(const std::string& filename, const std::string&
   int n_data = 0;
   switch (file_format_) {
   case STORM_BINARY:
-    WriteBinaryFloatArray(file, begin(), end(), file_format);
+    if (GetN() > 0)
+      WriteBinaryFloatBuffer(file, &(*begin()), GetN(), file_format);
     break;
   case STORM_ASCII:
     for (const_iterator it = begin(); it != end(); ++it) {
@@ -273,7 +275,8 @@ void StormContGrid::WriteToSgriFile(const std::string & file_name,
   file.precision(14);
 
   // Data
-  WriteBinaryFloatArray(file, begin(), end(), file_format);
+  if (GetN() > 0)
+    WriteBinaryFloatBuffer(file, &(*begin()), GetN(), file_format);
 
   // Final 0 (Number of barriers)
   file << 0;
@@ -689,7 +692,8 @@ void StormContGrid::ReadSgriBinaryFile(const std::string& filename)
 {
   std::ifstream binFile(filename.c_str(),std::ios::in | std::ios::binary); //Check opening of file before calling this function
   try {
-    ReadBinaryFloatArray(binFile, begin(), GetN());
+    if (GetN() > 0)
+      ReadBinaryFloatBuffer(binFile, &(*begin()), GetN());
   }
   catch (Exception& e) {
     throw Exception("Error: Reading from binary sgri file " +filename + "." + e.what() +"\n");
@@ -6,6 +6,11 @@
 #include <stdio.h>
 #include <time.h>
 #include <assert.h>
+#include <algorithm>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
 
 #if defined(COMPILE_STORM_MODULES_FOR_RMS)
 #include <util/precompile.h>
@@ -196,6 +201,12 @@ int main(int argc, char** argv)
       return(1);
     }
 
+#ifdef PARALLEL
+    // Parallel regions that do not set their own thread count, like the grid
+    // file I/O in NRLib, keep to the <max-threads> setting.
+    omp_set_num_threads(std::max(modelSettings->getNumberOfThreads(), 1));
+#endif
+
     std::string errTxt = inputFiles->addInputPathAndCheckFiles();
     if(errTxt != "") {
       LogKit::WriteHeader("Error opening files");
@@ -216,145 +227,131 @@ int main(int argc, char** argv)
     std::vector<SeismicParametersHolder> seismicParametersIntervals(common_data->GetMultipleIntervalGrid()->GetNIntervals());
 
     if(modelSettings->getEstimationMode() == false) {
-      //Loop over intervals
-      for (int i_interval = 0; i_interval < n_intervals; i_interval++) {
-
-        modelGeneral       = NULL;
-        modelAVOstatic     = NULL;
-        modelGravityStatic = NULL;
-
-        std::string interval_text = "";
-        if (n_intervals > 1)
-          interval_text = " for interval " + NRLib::ToString(common_data->GetMultipleIntervalGrid()->GetIntervalName(i_interval));
-        LogKit::WriteHeader("Setting up model" + interval_text);
-
-        //Priormodell i 3D
-        const Simbox * simbox = common_data->GetMultipleIntervalGrid()->GetIntervalSimbox(i_interval);
-
-        //Expectationsgrids. NRLib::Grid to FFTGrid, fills in padding
-        LogKit::LogFormatted(LogKit::Low,"\nBackground model..\n");
-
-        seismicParametersIntervals[i_interval].setBackgroundParametersInterval(common_data->GetBackgroundParametersInterval(i_interval),
-                                                                               simbox->GetNXpad(),
-                                                                               simbox->GetNYpad(),
-                                                                               simbox->GetNZpad());
-
-        //Background grids are overwritten in avoinversion
-        std::string interval_name = common_data->GetMultipleIntervalGrid()->GetIntervalName(i_interval);
-        crava_result->AddBackgroundVp(seismicParametersIntervals[i_interval].GetMeanVp());
-        crava_result->AddBackgroundVs(seismicParametersIntervals[i_interval].GetMeanVs());
-        crava_result->AddBackgroundRho(seismicParametersIntervals[i_interval].GetMeanRho());
-        //Release background grids from common_data.
-        common_data->ReleaseBackgroundGrids(i_interval, 0);
-        common_data->ReleaseBackgroundGrids(i_interval, 1);
-        common_data->ReleaseBackgroundGrids(i_interval, 2);
-
-        //korrelasjonsgrid (2m)
-        float corr_grad_I = 0.0f;
-        float corr_grad_J = 0.0f;
-        common_data->GetCorrGradIJ(corr_grad_I, corr_grad_J, simbox);
-
-        float dt        = static_cast<float>(simbox->getdz());
-        float low_cut   = modelSettings->getLowCut();
-        int low_int_cut = int(floor(low_cut*(simbox->GetNZpad()*0.001*dt))); // computes the integer which corresponds to the low cut frequency.
-
-        if (!modelSettings->getForwardModeling()) {
-          LogKit::LogFormatted(LogKit::Low,"\nCorrelation parameters..\n");
-          seismicParametersIntervals[i_interval].setCorrelationParameters(common_data->GetPriorCovEst(),
-                                                                          common_data->GetPriorParamCov(i_interval),
-                                                                          common_data->GetPriorAutoCov(i_interval),
-                                                                          common_data->GetPriorCorrT(i_interval),
-                                                                          common_data->GetPriorCorrXY(i_interval),
-                                                                          low_int_cut,
-                                                                          corr_grad_I,
-                                                                          corr_grad_J,
-                                                                          simbox->getnx(),
-                                                                          simbox->getny(),
-                                                                          simbox->getnz(),
-                                                                          simbox->GetNXpad(),
-                                                                          simbox->GetNYpad(),
-                                                                          simbox->GetNZpad(),
-                                                                          simbox->getdz());
-
+      //Intervals are processed in batches. The prior models (background and
+      //correlation grids) of all intervals in a batch are set up concurrently,
+      //while static models and inversions are done interval by interval in
+      //the original order, so results are identical to a sequential run.
+      std::vector<std::vector<int> > interval_batches = scheduleIntervals(modelSettings, common_data);
+
+      for (size_t i_batch = 0; i_batch < interval_batches.size(); i_batch++) {
+        const std::vector<int> & batch = interval_batches[i_batch];
+
+        if (batch.size() > 1) {
+          LogKit::WriteHeader("Setting up prior models");
+          LogKit::LogFormatted(LogKit::Low,"\nBackground and correlation parameters for intervals");
+          for (size_t b = 0; b < batch.size(); b++)
+            LogKit::LogFormatted(LogKit::Low," "+common_data->GetMultipleIntervalGrid()->GetIntervalName(batch[b]));
+          LogKit::LogFormatted(LogKit::Low,"..\n");
+        }
+        else {
+          std::string interval_text = "";
+          if (n_intervals > 1)
+            interval_text = " for interval " + NRLib::ToString(common_data->GetMultipleIntervalGrid()->GetIntervalName(batch[0]));
+          LogKit::WriteHeader("Setting up model" + interval_text);
+          LogKit::LogFormatted(LogKit::Low,"\nBackground model..\n");
+          if (!modelSettings->getForwardModeling())
+            LogKit::LogFormatted(LogKit::Low,"\nCorrelation parameters..\n");
         }
 
-        //ModelGeneral, modelAVOstatic, modelGravityStatic, (modelTravelTimeStatic?)
-        LogKit::LogFormatted(LogKit::Low,"\nStatic models..\n");
-        setupStaticModels(modelGeneral,
-                          modelAVOstatic,
-                          //modelGravityStatic,
-                          modelSettings,
-                          inputFiles,
-                          seismicParametersIntervals[i_interval],
-                          common_data,
-                          i_interval);
-
-        //Loop over dataset
-        //i.   ModelAVODynamic
-        //ii.  Inversion
-        //iii. Move model one time-step ahead
-
-        //Do not run avoinversion if forward modelleing or estimationmode
-        //Syntetic seismic is generated in CravaResult
-        if (!modelSettings->getForwardModeling() && !modelSettings->getEstimationMode()) {
-          int  eventType;
-          int  eventIndex;
-          modelGeneral->GetTimeLine()->ReSet();
-
-          double time;
-          int time_index = 0;
-          bool first     = true;
-          while(modelGeneral->GetTimeLine()->GetNextEvent(eventType, eventIndex, time) == true) {
-            if (first == false) {
-                modelGeneral->AdvanceTime(time_index, seismicParametersIntervals[i_interval], modelSettings);
-                time_index++;
+        setupPriorModels(seismicParametersIntervals, modelSettings, common_data, batch);
+
+        for (size_t b = 0; b < batch.size(); b++) {
+          int i_interval = batch[b];
+
+          modelGeneral       = NULL;
+          modelAVOstatic     = NULL;
+          modelGravityStatic = NULL;
+
+          if (batch.size() > 1)
+            LogKit::WriteHeader("Setting up model for interval " + NRLib::ToString(common_data->GetMultipleIntervalGrid()->GetIntervalName(i_interval)));
+
+          //Background grids are overwritten in avoinversion
+          crava_result->AddBackgroundVp(seismicParametersIntervals[i_interval].GetMeanVp());
+          crava_result->AddBackgroundVs(seismicParametersIntervals[i_interval].GetMeanVs());
+          crava_result->AddBackgroundRho(seismicParametersIntervals[i_interval].GetMeanRho());
+          //Release background grids from common_data.
+          common_data->ReleaseBackgroundGrids(i_interval, 0);
+          common_data->ReleaseBackgroundGrids(i_interval, 1);
+          common_data->ReleaseBackgroundGrids(i_interval, 2);
+
+          //ModelGeneral, modelAVOstatic, modelGravityStatic, (modelTravelTimeStatic?)
+          LogKit::LogFormatted(LogKit::Low,"\nStatic models..\n");
+          setupStaticModels(modelGeneral,
+                            modelAVOstatic,
+                            //modelGravityStatic,
+                            modelSettings,
+                            inputFiles,
+                            seismicParametersIntervals[i_interval],
+                            common_data,
+                            i_interval);
+
+          //Loop over dataset
+          //i.   ModelAVODynamic
+          //ii.  Inversion
+          //iii. Move model one time-step ahead
+
+          //Do not run avoinversion if forward modelleing or estimationmode
+          //Syntetic seismic is generated in CravaResult
+          if (!modelSettings->getForwardModeling() && !modelSettings->getEstimationMode()) {
+            int  eventType;
+            int  eventIndex;
+            modelGeneral->GetTimeLine()->ReSet();
+
+            double time;
+            int time_index = 0;
+            bool first     = true;
+            while(modelGeneral->GetTimeLine()->GetNextEvent(eventType, eventIndex, time) == true) {
+              if (first == false) {
+                  modelGeneral->AdvanceTime(time_index, seismicParametersIntervals[i_interval], modelSettings);
+                  time_index++;
+              }
+              bool failed = false;
+              switch(eventType) {
+              case TimeLine::AVO : {
+                LogKit::LogFormatted(LogKit::Low,"\nAVO inversion, time lapse "+ CommonData::ConvertIntToString(time_index) +"..\n");
+                failed = doTimeLapseAVOInversion(modelSettings,
+                                                  modelGeneral,
+                                                  modelAVOstatic,
+                                                  common_data,
+                                                  seismicParametersIntervals[i_interval],
+                                                  eventIndex,
+                                                  i_interval);
+                break;
+              }
+              case TimeLine::TRAVEL_TIME : {
+                LogKit::LogFormatted(LogKit::Low,"\nTravel time inversion, time lapse "+ CommonData::ConvertIntToString(time_index) +"..\n");
+                //failed = doTimeLapseTravelTimeInversion(modelSettings,
+                //                                        modelGeneral,
+                //                                        modelTravelTimeStatic,
+                //                                        inputFiles,
+                //                                        eventIndex,
+                //                                        seismicParametersIntervals[i_interval]);
+                break;
+              }
+              case TimeLine::GRAVITY : {
+                LogKit::LogFormatted(LogKit::Low,"\nGravimetric inversion, time lapse "+ CommonData::ConvertIntToString(time_index) +"..\n");
+                //failed = doTimeLapseGravimetricInversion(modelSettings,
+                //                                          modelGeneral,
+                //                                          modelGravityStatic,
+                //                                          common_data,
+                //                                          eventIndex,
+                //                                          seismicParametersIntervals[i_interval]);
+                break;
+              }
+              default :
+                failed = true;
+                break;
+              }
+              if(failed)
+                return(1);
+
+              first = false;
             }
-            bool failed = false;
-            switch(eventType) {
-            case TimeLine::AVO : {
-              LogKit::LogFormatted(LogKit::Low,"\nAVO inversion, time lapse "+ CommonData::ConvertIntToString(time_index) +"..\n");
-              failed = doTimeLapseAVOInversion(modelSettings,
-                                                modelGeneral,
-                                                modelAVOstatic,
-                                                common_data,
-                                                seismicParametersIntervals[i_interval],
-                                                eventIndex,
-                                                i_interval);
-              break;
-            }
-            case TimeLine::TRAVEL_TIME : {
-              LogKit::LogFormatted(LogKit::Low,"\nTravel time inversion, time lapse "+ CommonData::ConvertIntToString(time_index) +"..\n");
-              //failed = doTimeLapseTravelTimeInversion(modelSettings,
-              //                                        modelGeneral,
-              //                                        modelTravelTimeStatic,
-              //                                        inputFiles,
-              //                                        eventIndex,
-              //                                        seismicParametersIntervals[i_interval]);
-              break;
-            }
-            case TimeLine::GRAVITY : {
-              LogKit::LogFormatted(LogKit::Low,"\nGravimetric inversion, time lapse "+ CommonData::ConvertIntToString(time_index) +"..\n");
-              //failed = doTimeLapseGravimetricInversion(modelSettings,
-              //                                          modelGeneral,
-              //                                          modelGravityStatic,
-              //                                          common_data,
-              //                                          eventIndex,
-              //                                          seismicParametersIntervals[i_interval]);
-              break;
-            }
-            default :
-              failed = true;
-              break;
-            }
-            if(failed)
-              return(1);
-
-            first = false;
           }
-        }
 
-        crava_result->AddBlockedLogs(modelGeneral->GetBlockedWells());
-      } //interval_loop
+          crava_result->AddBlockedLogs(modelGeneral->GetBlockedWells());
+        } //interval_loop
+      } //batch_loop
     }
     if (n_intervals == 1)
       crava_result->SetBgBlockedLogs(common_data->GetBgBlockedLogs());
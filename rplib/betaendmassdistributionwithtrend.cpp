@@ -108,7 +108,7 @@ BetaEndMassDistributionWithTrend::BetaEndMassDistributionWithTrend(const NRLib::
 }
 
 BetaEndMassDistributionWithTrend::BetaEndMassDistributionWithTrend(const BetaEndMassDistributionWithTrend & dist)
-: DistributionWithTrend(dist.share_level_,dist.current_u_,dist.resample_),
+: DistributionWithTrend(dist),
   use_trend_cube_(dist.use_trend_cube_),
   ni_(dist.ni_),
   nj_(dist.nj_),
@@ -173,12 +173,7 @@ BetaEndMassDistributionWithTrend::GetQuantileValue(double u, double s1, double s
 
   double y;
 
-  if(share_level_ > None && resample_ == false)
-    u = current_u_;
-  else {
-    current_u_ = u;
-    resample_ = false;
-  }
+  u = UpdateCurrentU(u);
 
   if(ni_ == 1 && nj_ == 1)
     y = (*beta_endmass_distribution_)(0,0)->Quantile(u);
@@ -31,7 +31,7 @@ DeltaDistributionWithTrend::DeltaDistributionWithTrend(const NRLib::Trend * mean
 }
 
 DeltaDistributionWithTrend::DeltaDistributionWithTrend(const DeltaDistributionWithTrend & dist)
-  : DistributionWithTrend(dist.share_level_,dist.current_u_,dist.resample_),
+  : DistributionWithTrend(dist),
   use_trend_cube_(dist.use_trend_cube_)
 {
   dirac_ = dist.dirac_->Clone();
@@ -4,16 +4,8 @@
 
 #include "rplib/orddiffeqsolver.h"
 
-#include <numeric>
 #include <cmath>
 
-static DEM* global_dem;
-
-static std::vector<double> WrapperGEQDEMYPrime(std::vector<double>&       y,
-                                               double                     t) {
-  return global_dem->GEQDEMYPrime(y, t);
-}
-
 
 DEM::DEM(const std::vector<double>&       bulk_modulus,
          const std::vector<double>&       shear_modulus,
@@ -28,8 +20,6 @@ DEM::DEM(const std::vector<double>&       bulk_modulus,
   aspect_ratio_(aspect_ratio),
   concentration_(concentration) {
 
-  global_dem = this;
-
 }
 
 DEM::~DEM() {
@@ -73,61 +63,39 @@ DEM::CalcEffectiveModulus(double&                    effective_bulk_modulus,
 
   }
   else {
-    std::vector<double>           y0;
-    std::vector<double>                 tout;
-    std::vector< std::vector<double> >  yout;
+    SetupInclusionFactors(sum_conc);
 
     double tfinal = sum_conc;
-    y0.resize(2);
-    y0[0] = bulk_modulus_bg_;
-    y0[1] = shear_modulus_bg_;
-
-    OrdDiffEqSolver::
-    Ode45(&WrapperGEQDEMYPrime,
-          0.0,
-          tfinal,
-          y0,
-          tout,
-          yout,
-          1e-5);
-
-    if (!yout.empty())
-      effective_bulk_modulus  = (yout.back())[0];
-    if (!yout.empty())
-      effective_shear_modulus = (yout.back())[1];
+    double y[2];
+    y[0] = bulk_modulus_bg_;
+    y[1] = shear_modulus_bg_;
+
+    OrdDiffEqSolver::Ode45<2>(*this,
+                              0.0,
+                              tfinal,
+                              y,
+                              1e-5);
+
+    effective_bulk_modulus  = y[0];
+    effective_shear_modulus = y[1];
 
   }
 
 }
 
-std::vector<double>
-DEM::GEQDEMYPrime(std::vector<double>&       y,
-                  double                     t) {
+void
+DEM::SetupInclusionFactors(double sum_conc) {
 
   size_t ninclusions = aspect_ratio_.size();
 
-  double krhs = 0;
-  double murhs = 0;
-  double sum_conc = std::accumulate(concentration_.begin(), concentration_.end(), 0.0);
-
-  std::vector<double> yprime(2, 0.0);
+  conc_fraction_.resize(ninclusions);
+  theta_.resize(ninclusions);
+  fn_.resize(ninclusions);
 
   for (size_t index = 0; index < ninclusions; index++) {
-    double k2 = bulk_modulus_[index];
-    double mu2 = shear_modulus_[index];
     double asp = aspect_ratio_[index];
 
-    double conc = concentration_[index]/sum_conc;
-
-    //double krc = bulk_modulus_bg_*k2/((1 - phic_)*k2 + phic_*bulk_modulus_bg_); //Not used
-    //double murc = shear_modulus_bg_*mu2/((1 - phic_)*mu2 + phic_*shear_modulus_bg_); //Not used
-
-    double ka = k2;
-    double mua = mu2;
-
-
-    double k = y[0];
-    double mu = y[1];
+    conc_fraction_[index] = concentration_[index]/sum_conc;
 
     // truncation
     if (asp == 1.0)
@@ -147,6 +115,40 @@ DEM::GEQDEMYPrime(std::vector<double>&       y,
       throw NRLib::Exception("DEM: asp > 1 not supported.");
     }
 
+    theta_[index] = theta;
+    fn_[index]    = fn;
+  }
+}
+
+void
+DEM::GEQDEMYPrime(const double * y,
+                  double         t,
+                  double       * yprime) const {
+
+  size_t ninclusions = aspect_ratio_.size();
+
+  double krhs = 0;
+  double murhs = 0;
+
+  for (size_t index = 0; index < ninclusions; index++) {
+    double k2 = bulk_modulus_[index];
+    double mu2 = shear_modulus_[index];
+
+    double conc = conc_fraction_[index];
+
+    //double krc = bulk_modulus_bg_*k2/((1 - phic_)*k2 + phic_*bulk_modulus_bg_); //Not used
+    //double murc = shear_modulus_bg_*mu2/((1 - phic_)*mu2 + phic_*shear_modulus_bg_); //Not used
+
+    double ka = k2;
+    double mua = mu2;
+
+
+    double k = y[0];
+    double mu = y[1];
+
+    double theta = theta_[index];
+    double fn    = fn_[index];
+
     double nu = (3*k - 2*mu)/(2*(3*k + mu));
     double r = (1 - 2*nu)/(2*(1 - nu));
     double a = mua/mu - 1;
@@ -184,8 +186,6 @@ DEM::GEQDEMYPrime(std::vector<double>&       y,
   yprime[0] = krhs/(1 - t);
   yprime[1] = murhs/(1 - t);
 
-  return yprime;
-
 }
 
 
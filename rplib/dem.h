@@ -39,16 +39,30 @@ public:
   void CalcEffectiveModulus(double&                    effective_bulk_modulus,
                             double&                    effective_shear_modulus);
 
-  std::vector<double> GEQDEMYPrime(std::vector<double>&       y,
-                                   double                     t);
+  // Right hand side of the DEM differential equations, y = [k mu].
+  // Requires the inclusion factors set up by CalcEffectiveModulus.
+  void GEQDEMYPrime(const double * y,
+                    double         t,
+                    double       * yprime) const;
+
+  void operator()(const double * y,
+                  double         t,
+                  double       * yprime) const { GEQDEMYPrime(y, t, yprime); }
 
 private:
+  void SetupInclusionFactors(double sum_conc);
+
   double                           bulk_modulus_bg_;
   double                           shear_modulus_bg_;
   const std::vector<double>&       bulk_modulus_;
   const std::vector<double>&       shear_modulus_;
   const std::vector<double>&       aspect_ratio_;
   std::vector<double>&             concentration_;
+
+  // Per inclusion factors that do not depend on the integration variable
+  std::vector<double>              conc_fraction_;
+  std::vector<double>              theta_;
+  std::vector<double>              fn_;
 };
 
 
@@ -23,6 +23,7 @@
 
 #include "src/definitions.h"
 
+#include <cassert>
 #include <cmath>
 #include <numeric>
 
@@ -31,16 +32,47 @@ DEMTools::CalcBulkModulusOfBrineFromTPS(double temperature,
                                         double pressure,
                                         double salinity) {
 
+  double bulk_modulus;
+  double density;
 
-  double vb   = CalcVelocityOfBrineFromTPS(temperature,
+  CalcBrinePropertiesFromTPS(temperature, pressure, salinity, bulk_modulus, density);
+
+  return bulk_modulus;
+}
+
+void
+DEMTools::CalcBrinePropertiesFromTPS(double   temperature,
+                                     double   pressure,
+                                     double   salinity,
+                                     double & bulk_modulus,
+                                     double & density) {
+
+  double vb = CalcVelocityOfBrineFromTPS(temperature,
+                                         pressure,
+                                         salinity);
+
+  density      = CalcDensityOfBrineFromTPS(temperature,
                                            pressure,
                                            salinity);
 
-  double rhob = CalcDensityOfBrineFromTPS(temperature,
-                                          pressure,
-                                          salinity);
+  bulk_modulus = density*(vb*vb)/1E3;
+}
+
+void
+DEMTools::CalcBrinePropertiesFromTPS(const std::vector<double> & temperature,
+                                     const std::vector<double> & pressure,
+                                     const std::vector<double> & salinity,
+                                     std::vector<double>       & bulk_modulus,
+                                     std::vector<double>       & density) {
 
-  return rhob*(vb*vb)/1E3;
+  assert(temperature.size() == pressure.size() && temperature.size() == salinity.size());
+
+  size_t n = temperature.size();
+  bulk_modulus.resize(n);
+  density.resize(n);
+
+  for (size_t i = 0; i < n; i++)
+    CalcBrinePropertiesFromTPS(temperature[i], pressure[i], salinity[i], bulk_modulus[i], density[i]);
 }
 
 double
@@ -287,38 +319,26 @@ DEMTools::CalcVelocityOfBrineFromTPS(double temperature,
 double
 DEMTools::CalcVelocityOfWaterFromTP(double temperature,
                                     double pressure) {
-  std::vector< std::vector<double> > omega(5, std::vector<double>(4, 0.0));
-
-  omega[0][0] = 1402.85;
-  omega[0][1] = 1.524;
-  omega[0][2] = 3.437E-3;
-  omega[0][3] = -1.197E-5;
-
-  omega[1][0] = 4.871;
-  omega[1][1] = -0.0111;
-  omega[1][2] = 1.739E-4;
-  omega[1][3] = -1.628E-6;
-
-  omega[2][0] = -0.04783;
-  omega[2][1] = 2.747E-4;
-  omega[2][2] = -2.135E-6;
-  omega[2][3] = 1.237E-8;
-
-  omega[3][0] = 1.487E-4;
-  omega[3][1] = -6.503E-7;
-  omega[3][2] = -1.455E-8;
-  omega[3][3] = 1.327E-10;
-
-  omega[4][0] =  -2.197E-7;
-  omega[4][1] = 7.987E-10;
-  omega[4][2] = 5.230E-11;
-  omega[4][3] = -4.614E-13;
+  static const double omega[5][4] = {
+    { 1402.85,    1.524,     3.437E-3,  -1.197E-5 },
+    { 4.871,     -0.0111,    1.739E-4,  -1.628E-6 },
+    {-0.04783,    2.747E-4, -2.135E-6,   1.237E-8 },
+    { 1.487E-4,  -6.503E-7, -1.455E-8,   1.327E-10},
+    {-2.197E-7,   7.987E-10, 5.230E-11, -4.614E-13}
+  };
+
+  double t_pow[5];
+  double p_pow[4];
+  for (int i = 0; i < 5; i++)
+    t_pow[i] = pow(temperature, i);
+  for (int j = 0; j < 4; j++)
+    p_pow[j] = pow(pressure, j);
 
   double ww = 0.0;
 
   for (int i = 0; i < 5; i++)
     for (int j = 0; j < 4; j++)
-      ww += omega[i][j]*pow(temperature, i)*pow(pressure, j);
+      ww += omega[i][j]*t_pow[i]*p_pow[j];
 
   return ww;
 }
@@ -16,6 +16,19 @@ namespace DEMTools {
                                    double pressure,
                                    double salinity);
 
+  // Bulk modulus (MPa) and density (g/ccm) of brine, sharing the density evaluation.
+  void   CalcBrinePropertiesFromTPS(double   temperature,
+                                    double   pressure,
+                                    double   salinity,
+                                    double & bulk_modulus,
+                                    double & density);
+
+  void   CalcBrinePropertiesFromTPS(const std::vector<double> & temperature,
+                                    const std::vector<double> & pressure,
+                                    const std::vector<double> & salinity,
+                                    std::vector<double>       & bulk_modulus,
+                                    std::vector<double>       & density);
+
   void   CalcCo2Prop(double& bulk_modulus,
                      double& density,
                      double ti,
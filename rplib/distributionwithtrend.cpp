@@ -1,25 +1,28 @@
 #include "rplib/distributionwithtrend.h"
 
+#include <cassert>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
 
 DistributionWithTrend::DistributionWithTrend()
-: share_level_(None),
-  current_u_(0),  //Ok since resample is true.
-  resample_(true)
+: share_level_(None)
 {
+  InitSampleState(0, true); //Ok since resample is true.
 }
 
 DistributionWithTrend::DistributionWithTrend(const int shareLevel,bool reSample)
-: share_level_(shareLevel),
-  current_u_(0),  //Shaky, should not be used with reSample = false, use the one below.
-  resample_(reSample)
+: share_level_(shareLevel)
 {
+  InitSampleState(0, reSample); //Shaky, should not be used with reSample = false, use the one below.
 }
 
 DistributionWithTrend::DistributionWithTrend(const int shareLevel,double currentU,bool reSample)
-: share_level_(shareLevel),
-  current_u_(currentU),
-  resample_(reSample)
+: share_level_(shareLevel)
 {
+  InitSampleState(currentU, reSample);
 }
 
 
@@ -45,6 +48,58 @@ double
 DistributionWithTrend::GetCurrentSample(const std::vector<double> & trend_params)
 {
   double samples;
-  samples=GetQuantileValue(current_u_, trend_params[0], trend_params[1]);
+  samples=GetQuantileValue(GetSampleState().current_u_, trend_params[0], trend_params[1]);
   return samples;
 }
+
+void
+DistributionWithTrend::TriggerNewSample(int level)
+{
+  if(share_level_<=level)
+    GetSampleState().resample_ = true;
+}
+
+double
+DistributionWithTrend::UpdateCurrentU(double u)
+{
+  SampleState & state = GetSampleState();
+  if(share_level_ > None && state.resample_ == false)
+    u = state.current_u_;
+  else {
+    state.current_u_ = u;
+    state.resample_  = false;
+  }
+  return u;
+}
+
+void
+DistributionWithTrend::InitSampleState(double currentU, bool reSample)
+{
+  // A shared variable must keep its value through all parts of one rock sample,
+  // so each thread drawing samples needs its own copy of the state.
+  SampleState state;
+  state.current_u_ = currentU;
+  state.resample_  = reSample;
+  sample_state_.assign(GetMaxSampleThreads(), state);
+}
+
+int
+DistributionWithTrend::GetMaxSampleThreads()
+{
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = omp_get_num_procs();
+#endif
+  return n_threads;
+}
+
+DistributionWithTrend::SampleState &
+DistributionWithTrend::GetSampleState()
+{
+  int thread = 0;
+#ifdef PARALLEL
+  thread = omp_get_thread_num();
+#endif
+  assert(thread < static_cast<int>(sample_state_.size()));
+  return sample_state_[thread];
+}
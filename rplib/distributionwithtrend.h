@@ -19,8 +19,7 @@ class DistributionWithTrend {
    virtual std::vector<bool>          GetUseTrendCube()                                   const = 0;
 
    //Triggers resampling for share_level_ <= level_. Not necessary for share_level_ = 0/None
-   void                       TriggerNewSample(int level)             {if(share_level_<=level)
-                                                                                 resample_ = true; }
+   void                               TriggerNewSample(int level);
 
    virtual double                     ReSample(double s1, double s2)                            = 0;
    virtual double                     GetQuantileValue(double u, double s1, double s2)          = 0;
@@ -33,11 +32,27 @@ class DistributionWithTrend {
                                                        int                 dim,
                                                        int                 reference);
 
+   // Number of threads that may draw samples concurrently.
+   static int                         GetMaxSampleThreads();
+
    enum                               ShareLevel {None, SingleSample, Full}; //Note: New levels should be inserted between SingleSample and Full.
 protected:
+  // Returns current_u_ if this is a shared variable that has already been sampled,
+  // otherwise stores u as the current sample and returns it.
+  double                              UpdateCurrentU(double u);
+
   const int                           share_level_;      // Use like in DistributionWithTrendStorage to know if we have a reservoir variable.
-  double                              current_u_;        // Quantile of current sample.
-  bool                                resample_;         // If false, and share_level_ > 0, reuse current_u_
 
+private:
+  struct SampleState {
+    double                            current_u_;        // Quantile of current sample.
+    bool                              resample_;         // If false, and share_level_ > 0, reuse current_u_
+  };
+
+  SampleState                       & GetSampleState();
+
+  void                                InitSampleState(double currentU, bool reSample);
+
+  std::vector<SampleState>            sample_state_;     // One per thread, so that samples may be drawn concurrently.
 };
 #endif
@@ -30,23 +30,22 @@ FluidBatzleWang::Clone() const {
 
 void
 FluidBatzleWang::ComputeElasticParams(double temp, double pore_pressure) {
-  k_   = ComputeBulkModulusOfFluidBatzleWangFromTPS(temp, pore_pressure, salinity_);
+  DEMTools::CalcBrinePropertiesFromTPS(temp, pore_pressure, salinity_, k_, rho_);
 
-  //unit conversion from GPa->kPa
-  k_ *= 1000000.0;
-
-  rho_ = ComputeDensityOfFluidBatzleWangFromTPS(temp, pore_pressure, salinity_);
-}
-
-double
-FluidBatzleWang::ComputeBulkModulusOfFluidBatzleWangFromTPS(double temp, double pore_pressure, double salinity) const
-{
-  return DEMTools::CalcBulkModulusOfBrineFromTPS(temp, pore_pressure, salinity) * 0.001; /*gpa*/
+  //unit conversion from MPa->kPa
+  k_ = (k_*0.001)*1000000.0;
 }
 
-double
-FluidBatzleWang::ComputeDensityOfFluidBatzleWangFromTPS(double temp, double pore_pressure, double salinity) const
-{
-  return DEMTools::CalcDensityOfBrineFromTPS(temp, pore_pressure, salinity);
+void
+FluidBatzleWang::ComputeElasticParams(const std::vector<double> & salinity,
+                                      const std::vector<double> & temp,
+                                      const std::vector<double> & pore_pressure,
+                                      std::vector<double>       & k,
+                                      std::vector<double>       & rho) {
+  DEMTools::CalcBrinePropertiesFromTPS(temp, pore_pressure, salinity, k, rho);
+
+  //unit conversion from MPa->kPa
+  for (size_t i = 0; i < k.size(); i++)
+    k[i] = (k[i]*0.001)*1000000.0;
 }
 
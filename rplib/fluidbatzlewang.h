@@ -23,11 +23,14 @@ public:
 
   void                            ComputeElasticParams(double temp, double pore_pressure);
 
-private:
-  double                          ComputeBulkModulusOfFluidBatzleWangFromTPS(double temp, double pore_pressure, double salinity) const;
-
-  double                          ComputeDensityOfFluidBatzleWangFromTPS(double temp, double pore_pressure, double salinity) const;
+                                  // Batched version for arrays of (salinity, temperature, pressure).
+  static void                     ComputeElasticParams(const std::vector<double> & salinity,
+                                                       const std::vector<double> & temp,
+                                                       const std::vector<double> & pore_pressure,
+                                                       std::vector<double>       & k,
+                                                       std::vector<double>       & rho);
 
+private:
   double                          salinity_;
 
 };
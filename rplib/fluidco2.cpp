@@ -16,6 +16,10 @@
 #include <fstream>
 #include <string>
 
+// The tables are built once during static initialisation, before any
+// threads are started, and are only read afterwards.
+static const CO2PropertyTables co2_tables;
+
 FluidCO2::FluidCO2(double                      temp,
                    double                      pore_pressure,
                    const std::vector<double> & u)
@@ -41,97 +45,99 @@ FluidCO2::Clone() const
 void
 FluidCO2::ComputeElasticParams(double temp, double pressure)
 {
-  static const NRLib::RegularSurface<double> surf_vp    = ConstDataStoredAsSurface::CreateSurfaceVP();
-  static const NRLib::RegularSurface<double> surf_rho   = ConstDataStoredAsSurface::CreateSurfaceRho();
-
-  static const NRLib::RegularSurface<double> surf_vp1   = ConstDataStoredAsSurface::CreateSurfaceVP1();
-  static const NRLib::RegularSurface<double> surf_vp2   = ConstDataStoredAsSurface::CreateSurfaceVP2();
-  static const NRLib::RegularSurface<double> surf_rho1  = ConstDataStoredAsSurface::CreateSurfaceRho1();
-  static const NRLib::RegularSurface<double> surf_rho2  = ConstDataStoredAsSurface::CreateSurfaceRho2();
+  double mu = 0.0;
+  double vp = co2_tables.GetVp(temp, pressure);
+  rho_      = co2_tables.GetRho(temp, pressure);
+  DEMTools::CalcElasticParamsFromSeismicParams(vp, 0.0, rho_, k_, mu);
+}
 
-  static std::vector<double> p_func                     = GetPFunc();
-  static double critical_temp                           = GetCritTemp();
-  static double critical_pressure                       = GetCritPressure();
+void
+FluidCO2::ComputeElasticParams(const std::vector<double> & temp,
+                               const std::vector<double> & pressure,
+                               std::vector<double>       & k,
+                               std::vector<double>       & rho)
+{
+  assert(temp.size() == pressure.size());
 
-  double scale = 100.0;
-  double inv_scale = 1.0/scale;
+  size_t n = temp.size();
+  k.resize(n);
+  rho.resize(n);
 
-  if (temp >= 1.0 && temp <= 100.0 && pressure >= 0.1 && pressure <= 100.0) { //very dense sampled table
+  double mu = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double vp = co2_tables.GetVp(temp[i], pressure[i]);
+    rho[i]    = co2_tables.GetRho(temp[i], pressure[i]);
+    DEMTools::CalcElasticParamsFromSeismicParams(vp, 0.0, rho[i], k[i], mu);
+  }
+}
 
-    //bilinear interpolation, surfaces are multiplied with 100 in x, y and z-direction
-    double vp = 0;
-    double mu = 0;
-    bool failed_getz = false;
+//--------------------------------------------------------------//
 
-    rho_  = surf_rho.GetZ(scale*pressure, scale*temp);
-    if (surf_rho.IsMissing(rho_))
-      failed_getz = true;
+CO2PropertyTables::CO2PropertyTables()
+: surf_vp_  (ConstDataStoredAsSurface::CreateSurfaceVP()),
+  surf_rho_ (ConstDataStoredAsSurface::CreateSurfaceRho()),
+  surf_vp1_ (ConstDataStoredAsSurface::CreateSurfaceVP1()),
+  surf_vp2_ (ConstDataStoredAsSurface::CreateSurfaceVP2()),
+  surf_rho1_(ConstDataStoredAsSurface::CreateSurfaceRho1()),
+  surf_rho2_(ConstDataStoredAsSurface::CreateSurfaceRho2())
+{
+}
 
-    rho_ *= inv_scale;
+const NRLib::RegularSurface<double> &
+CO2PropertyTables::FindSurface(double                                temp,
+                               double                                pressure,
+                               const NRLib::RegularSurface<double> & surf_dense,
+                               const NRLib::RegularSurface<double> & surf_gas,
+                               const NRLib::RegularSurface<double> & surf_liquid) const
+{
+  if (temp >= 1.0 && temp <= 100.0 && pressure >= 0.1 && pressure <= 100.0) //very dense sampled table
+    return surf_dense;
+
+  // Sort input data into domains
+  //Domain 1: Gas
+  //Domain 2: Liquid and supercritical fluid
+  static const double p_func[4]         = {0.000003883701221, 0.000930453898625, 0.092759127015099, 3.480623887319762};
+  static const double critical_temp     = 30.9783;
+  static const double critical_pressure = 7.3772;
+
+  double p_of_t = p_func[0]*temp*temp*temp + p_func[1]*temp*temp + p_func[2]*temp + p_func[3];
+
+  if ((temp >= critical_temp && pressure >= critical_pressure) ||
+      (temp < critical_temp && pressure >= p_of_t))
+    return surf_liquid;
+  else
+    return surf_gas;
+}
 
-    vp    = surf_vp.GetZ(scale*pressure, scale*temp);
-    if (surf_vp.IsMissing(vp))
-      failed_getz = true;
+double
+CO2PropertyTables::Interpolate(const NRLib::RegularSurface<double> & surf,
+                               double                                temp,
+                               double                                pressure) const
+{
+  //bilinear interpolation, surfaces are multiplied with 100 in x, y and z-direction
+  const double scale     = 100.0;
+  const double inv_scale = 1.0/scale;
 
-    vp   *= inv_scale;
+  double z = surf.GetZ(scale*pressure, scale*temp);
+  if (surf.IsMissing(z))
+    throw NRLib::Exception("CO2 Model: Interpolation failed.");
 
-    if (failed_getz)
-      throw NRLib::Exception("CO2 Model: Interpolation failed.");
+  return z*inv_scale;
+}
 
-    //unit conversion from km/s -> m/s
-    vp *= 1000.0;
-    DEMTools::CalcElasticParamsFromSeismicParams(vp, 0.0, rho_, k_, mu);
+double
+CO2PropertyTables::GetVp(double temp, double pressure) const
+{
+  const NRLib::RegularSurface<double> & surf = FindSurface(temp, pressure, surf_vp_, surf_vp1_, surf_vp2_);
 
-  }
-  else {
-
-    // Sort input data into domains
-    //Domain 1: Gas
-    //Domain 2: Liquid and supercritical fluid
-
-    double p_of_t             = p_func[0]*temp*temp*temp + p_func[1]*temp*temp + p_func[2]*temp + p_func[3];
-
-    int scenario              = 1;
-
-    if ((temp >= critical_temp && pressure >= critical_pressure) ||
-        (temp < critical_temp && pressure >= p_of_t))
-        scenario = 2;
-
-    //bilinear interpolation, surfaces are multiplied with 100 in x, y and z-direction
-    double vp = 0;
-    double mu = 0;
-    bool failed_getz = false;
-    if (scenario == 1) {
-      rho_      = surf_rho1.GetZ(scale*pressure, scale*temp);
-      if (surf_rho1.IsMissing(rho_))
-        failed_getz = true;
-      rho_     *= inv_scale;
-
-      vp        = surf_vp1.GetZ(scale*pressure, scale*temp);
-      if (surf_vp1.IsMissing(vp))
-        failed_getz = true;
-      vp       *= inv_scale;
-    }
-    else {
-      rho_      = surf_rho2.GetZ(scale*pressure, scale*temp);
-      if (surf_rho2.IsMissing(rho_))
-        failed_getz = true;
-      rho_     *= inv_scale;
-
-      vp        = surf_vp2.GetZ(scale*pressure, scale*temp);
-       if (surf_vp2.IsMissing(vp))
-        failed_getz = true;
-      vp       *= inv_scale;
-    }
-
-    if (failed_getz)
-      throw NRLib::Exception("CO2 Model: Interpolation failed.");
-
-    //unit conversion from km/s -> m/s
-    vp *= 1000.0;
-
-    DEMTools::CalcElasticParamsFromSeismicParams(vp, 0.0, rho_, k_, mu);
-  }
+  //unit conversion from km/s -> m/s
+  return 1000.0*Interpolate(surf, temp, pressure);
 }
 
+double
+CO2PropertyTables::GetRho(double temp, double pressure) const
+{
+  const NRLib::RegularSurface<double> & surf = FindSurface(temp, pressure, surf_rho_, surf_rho1_, surf_rho2_);
 
+  return Interpolate(surf, temp, pressure);
+}
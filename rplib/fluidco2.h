@@ -3,8 +3,41 @@
 
 #include "rplib/fluid.h"
 
+#include "nrlib/surface/regularsurface.hpp"
+
 #include <vector>
 
+// Immutable tables of CO2 velocity and density as functions of temperature
+// and pressure. A dense table covers 1-100 C and 0.1-100 MPa; outside this
+// range separate tables are used for gas and for liquid/supercritical CO2.
+// All lookups are const, so one instance may be shared by several threads.
+// FluidCO2 shares one instance, built during static initialisation.
+class CO2PropertyTables {
+public:
+  CO2PropertyTables();
+
+  double                                GetVp(double temp, double pressure)  const; ///< m/s
+  double                                GetRho(double temp, double pressure) const; ///< g/ccm
+
+private:
+  const NRLib::RegularSurface<double> & FindSurface(double                                temp,
+                                                    double                                pressure,
+                                                    const NRLib::RegularSurface<double> & surf_dense,
+                                                    const NRLib::RegularSurface<double> & surf_gas,
+                                                    const NRLib::RegularSurface<double> & surf_liquid) const;
+
+  double                                Interpolate(const NRLib::RegularSurface<double> & surf,
+                                                    double                                temp,
+                                                    double                                pressure) const;
+
+  const NRLib::RegularSurface<double>   surf_vp_;
+  const NRLib::RegularSurface<double>   surf_rho_;
+  const NRLib::RegularSurface<double>   surf_vp1_;
+  const NRLib::RegularSurface<double>   surf_vp2_;
+  const NRLib::RegularSurface<double>   surf_rho1_;
+  const NRLib::RegularSurface<double>   surf_rho2_;
+};
+
 
 
 class FluidCO2 : public Fluid {
@@ -26,9 +59,11 @@ public:
 
   void                        ComputeElasticParams(double temp, double pressure);
 
-  double                      GetCritTemp()                                                         const { return 30.9783;}
-  double                      GetCritPressure()                                                     const { return 7.3772; }
-  const std::vector<double>   GetPFunc()                                                                  { std::vector<double> pfunc(4); pfunc[0] = 0.000003883701221; pfunc[1] = 0.000930453898625; pfunc[2] = 0.092759127015099, pfunc[3] = 3.480623887319762; return pfunc;}
+                              // Batched version for arrays of (temperature, pressure).
+  static void                 ComputeElasticParams(const std::vector<double> & temp,
+                                                   const std::vector<double> & pressure,
+                                                   std::vector<double>       & k,
+                                                   std::vector<double>       & rho);
 };
 
 #endif
@@ -31,7 +31,7 @@ NormalDistributionWithTrend::NormalDistributionWithTrend(const NRLib::Trend * me
 }
 
 NormalDistributionWithTrend::NormalDistributionWithTrend(const NormalDistributionWithTrend & dist)
-: DistributionWithTrend(dist.share_level_,dist.current_u_,dist.resample_),
+: DistributionWithTrend(dist),
 use_trend_cube_(dist.use_trend_cube_)
 {
   gaussian_ = dist.gaussian_->Clone();
@@ -67,12 +67,7 @@ NormalDistributionWithTrend::GetQuantileValue(double u, double s1, double s2)
 
   double dummy = 0;
 
-  if(share_level_ > None && resample_ == false)
-    u = current_u_;
-  else {
-    current_u_ = u;
-    resample_ = false;
-  }
+  u = UpdateCurrentU(u);
 
   double z = gaussian_->Quantile(u);
 
@@ -2,29 +2,162 @@
 #define RPLIB_ORDDIFFEQSOLVER_H
 
 #include <cstring>
+#include <cmath>
 #include <vector>
 
+#include "nrlib/exception/exception.hpp"
+
 class OrdDiffEqSolver {
  public:
    OrdDiffEqSolver();
    ~OrdDiffEqSolver();
 
- //ODE45 integrates a system of ordinary differential equations using
- //4th and 5th order Runge-Kutta formulas.
- static void Ode45(std::vector<double>                 (func_ptr)(std::vector<double>&, double),
+ //ODE45 integrates a system of N ordinary differential equations using
+ //4th and 5th order Runge-Kutta-Fehlberg formulas with adaptive step size.
+ //
+ //Func is any type providing
+ //  void operator()(const double * y, double t, double * yprime) const
+ //
+ //All work space is fixed size and lives on the stack, and the coefficient
+ //tables are constant, so the solver is re-entrant and may be called from
+ //several threads at once.
+ //
+ //On return y holds the solution at tfinal.
+ template <int N, class Func>
+ static void Ode45(const Func & func,
+                   double       t0,
+                   double       tfinal,
+                   double     * y,
+                   double       tol = 1.e-6);
+
+ //Dense output version: in addition to the final solution, every accepted
+ //step (including t0) is appended to tout and yout.
+ template <int N, class Func>
+ static void Ode45(const Func                         & func,
                    double                               t0,
                    double                               tfinal,
-                   std::vector<double>&                 y0,
-                   std::vector<double>&                 tout,
-                   std::vector< std::vector<double> >&  yout,
+                   const std::vector<double>          & y0,
+                   std::vector<double>                & tout,
+                   std::vector< std::vector<double> > & yout,
                    double                               tol = 1.e-6);
 
 private:
-static void CalcVector(const std::vector< std::vector<double> >& matrix,
-                       const std::vector< std::vector<double> >& f,
-                       double                                    h,
-                       size_t                                    row,
-                       std::vector<double>&                      y);
+ template <int N, class Func>
+ static void Integrate(const Func                         & func,
+                       double                               t0,
+                       double                               tfinal,
+                       double                             * y,
+                       double                               tol,
+                       std::vector<double>                * tout,
+                       std::vector< std::vector<double> > * yout);
 
+ // Runge-Kutta-Fehlberg coefficients
+ static const double alpha_[5];
+ static const double beta_[5][6];
+ static const double gamma_[2][6];
 };
+
+template <int N, class Func>
+void
+OrdDiffEqSolver::Ode45(const Func & func,
+                       double       t0,
+                       double       tfinal,
+                       double     * y,
+                       double       tol)
+{
+  Integrate<N>(func, t0, tfinal, y, tol, NULL, NULL);
+}
+
+template <int N, class Func>
+void
+OrdDiffEqSolver::Ode45(const Func                         & func,
+                       double                               t0,
+                       double                               tfinal,
+                       const std::vector<double>          & y0,
+                       std::vector<double>                & tout,
+                       std::vector< std::vector<double> > & yout,
+                       double                               tol)
+{
+  double y[N];
+  for (int i = 0; i < N; i++)
+    y[i] = y0[i];
+  Integrate<N>(func, t0, tfinal, y, tol, &tout, &yout);
+}
+
+template <int N, class Func>
+void
+OrdDiffEqSolver::Integrate(const Func                         & func,
+                           double                               t0,
+                           double                               tfinal,
+                           double                             * y,
+                           double                               tol,
+                           std::vector<double>                * tout,
+                           std::vector< std::vector<double> > * yout)
+{
+  double t     = t0;
+  double hmax  = (tfinal - t)/16.0;
+  double h     = hmax/8.0;
+  double power = 1.0/5.0;
+
+  double f[6][N]; // Slopes
+  double y1[N];
+
+  if (tout != NULL) {
+    tout->push_back(t0);
+    yout->push_back(std::vector<double>(y, y + N));
+  }
+
+  while (t < tfinal && (t + h) > t) {
+    if (t+h > tfinal)
+      h = tfinal - t;
+
+    //Compute the slopes
+    func(y, t, f[0]);
+
+    for (int j = 0; j < 5; j++) {
+      double t1 = t + alpha_[j]*h;
+      for (int i = 0; i < N; i++) {
+        y1[i] = y[i];
+        for (int k = 0; k <= j; k++)
+          y1[i] += h*beta_[j][k]*f[k][i];
+      }
+      func(y1, t1, f[j+1]);
+    }
+
+    //estimate error and acceptable error
+    double delta = 0.0;
+    double tau   = 1.0;
+    for (int i = 0; i < N; i++) {
+      double d = 0.0;
+      for (int k = 0; k < 6; k++)
+        d += h*gamma_[1][k]*f[k][i];
+      if (std::abs(d) > delta)
+        delta = std::abs(d);
+      if (std::abs(y[i]) > tau)
+        tau = std::abs(y[i]);
+    }
+    tau *= tol;
+
+    if (delta <= tau) {
+      t += h;
+      for (int i = 0; i < N; i++)
+        for (int k = 0; k < 6; k++)
+          y[i] += h*gamma_[0][k]*f[k][i];
+      if (tout != NULL) {
+        tout->push_back(t);
+        yout->push_back(std::vector<double>(y, y + N));
+      }
+    }
+
+    if (delta != 0.0) {
+      h = 0.8*h*std::pow(tau/delta, power);
+      if (hmax < h)
+        h = hmax;
+    }
+  } // end while
+
+  if (t < tfinal)
+    throw NRLib::Exception("DEM: Singularity likely.");
+}
+
 #endif
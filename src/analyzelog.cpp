@@ -16,6 +16,10 @@
 #include "src/simbox.h"
 #include "src/io.h"
 
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
 // CRA-257: New correlation estimation routine
 /*
 Analyzelog::Analyzelog(const std::vector<NRLib::Well>                          & wells,
@@ -238,7 +242,8 @@ void  Analyzelog::EstimateCorrelation(const ModelSettings
     auto_cov_.resize(n_lags);
 
     EstimateAutoCovarianceFunction(auto_cov_, well_names, mapped_blocked_logs, interval_simboxes, log_data_vp, log_data_vs, log_data_rho,
-      all_Vs_logs_synthetic, all_Vs_logs_non_synthetic, regression_coef, residual_variance_vs, static_cast<float>(dz_min), n_lags, min_blocks_with_data_for_corr_estim_, max_lag_with_data_, err_txt);
+      all_Vs_logs_synthetic, all_Vs_logs_non_synthetic, regression_coef, residual_variance_vs, static_cast<float>(dz_min), n_lags, min_blocks_with_data_for_corr_estim_, max_lag_with_data_,
+      std::max(model_settings->getNumberOfThreads(), 1), err_txt);
 
     SetParameterCov(auto_cov_[0], var_0_, 3);
 
@@ -839,6 +844,7 @@ void            Analyzelog::EstimateAutoCovarianceFunction(std::vector<NRLib::Ma
                                                            int                                                  max_nd,
                                                            int                                                  min_blocks_with_data_for_corr_estim,
                                                            int                                                & max_lag_with_data,
+                                                           int                                                  n_threads,
                                                            std::string                                        & err_text)
 {
   time_t timestart_tot, timeend_tot;
@@ -916,42 +922,55 @@ void            Analyzelog::EstimateAutoCovarianceFunction(std::vector<NRLib::Ma
       // 2.1.2 calculate residuals for vs and the resulting residual variance for the non-synthetic vs wells
       //
       residual_variance_vs.resize(max_nd, 0);
-      std::vector<int> count_obs(vp.size(), 0);
-      //double sum_resid_square = 0.0;
-      double residual_k, residual_l;
+      std::vector<int> count_obs(max_nd, 0);
       int last_obs = 0;
-      int lag = 0;
-      for (size_t i = 0; i < well_names.size(); i++){
-        if(mapped_blocked_logs.find(well_names[i])->second->HasSyntheticVsLog() == false){
-        //int n_lags;
-          const std::vector<double> well_log_vp     = log_data_vp.find(well_names[i])->second;
-          const std::vector<double> well_log_rho    = log_data_rho.find(well_names[i])->second;
-          const std::vector<double> well_log_vs     = log_data_vs.find(well_names[i])->second;
-          const std::vector<double> & x_pos         = mapped_blocked_logs.find(well_names[i])->second->GetXposBlocked();
-          const std::vector<double> & y_pos         = mapped_blocked_logs.find(well_names[i])->second->GetYposBlocked();
-          const std::vector<double> & z_pos         = mapped_blocked_logs.find(well_names[i])->second->GetZposBlocked();
 
-          for (size_t j = 0; j<interval_simboxes.size(); j++){
-            const std::string interval_name           = interval_simboxes[j]->GetIntervalName();
-
-            for (size_t k = 0; k < well_log_vp.size(); k++){
-              for (size_t l = k; l < well_log_vp.size(); l++){
-                if (well_log_vp[k] != RMISSING && well_log_vp[l] != RMISSING
-                  && well_log_rho[k] != RMISSING && well_log_rho[l] != RMISSING
-                  && well_log_vs[k] != RMISSING && well_log_vs[l] != RMISSING){
-                  double z_k_rel = (z_pos[k] - interval_simboxes[j]->getTop(x_pos[k], y_pos[k]))/interval_simboxes[j]->getRelThick(x_pos[k], y_pos[k]);
-                  double z_l_rel = (z_pos[l] - interval_simboxes[j]->getTop(x_pos[l], y_pos[l]))/interval_simboxes[j]->getRelThick(x_pos[l], y_pos[l]);
-                  lag = static_cast<int>(std::floor(std::abs(z_k_rel - z_l_rel)/min_dz + 0.5));
-                  residual_k = regression_coef(0)*well_log_vp[k] + regression_coef(1)*well_log_rho[k] - well_log_vs[k];
-                  residual_l = regression_coef(0)*well_log_vp[l] + regression_coef(1)*well_log_rho[l] - well_log_vs[l];
-                  residual_variance_vs[lag] += residual_k*residual_l;
-                  count_obs[lag] += 1;
-                  if (lag > last_obs)
-                    last_obs = lag;
-                }
-              }
+      int n_wells = static_cast<int>(well_names.size());
+      std::vector<std::vector<double> > well_residual_sum(n_wells);
+      std::vector<std::vector<double> > well_residual_count(n_wells);
+
+      // Series 0 is the residual, series 1 its indicator
+      std::vector<LagProduct> residual_products(1, LagProduct(0, 0, 0, 0));
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+      for (int i = 0; i < n_wells; i++){
+        const BlockedLogsCommon * blocked_log = mapped_blocked_logs.find(well_names[i])->second;
+        if(blocked_log->HasSyntheticVsLog() == false){
+          const std::vector<double> & well_log_vp  = log_data_vp.find(well_names[i])->second;
+          const std::vector<double> & well_log_rho = log_data_rho.find(well_names[i])->second;
+          const std::vector<double> & well_log_vs  = log_data_vs.find(well_names[i])->second;
+          int n = static_cast<int>(well_log_vp.size());
+
+          std::vector<std::vector<double> > series(2, std::vector<double>(n, 0.0));
+          for (int k = 0; k < n; k++){
+            if (well_log_vp[k] != RMISSING && well_log_rho[k] != RMISSING && well_log_vs[k] != RMISSING){
+              series[0][k] = regression_coef(0)*well_log_vp[k] + regression_coef(1)*well_log_rho[k] - well_log_vs[k];
+              series[1][k] = 1.0;
             }
           }
+
+          std::vector<std::vector<double> > lag_sum(1, std::vector<double>(max_nd, 0.0));
+          std::vector<std::vector<double> > lag_count(1, std::vector<double>(max_nd, 0.0));
+          std::vector<double>               z_rel;
+          for (size_t j = 0; j<interval_simboxes.size(); j++){
+            CalculateRelativeDepth(blocked_log, interval_simboxes[j], n, z_rel);
+            AccumulateLaggedProducts(series, residual_products, z_rel, n, min_dz, lag_sum, lag_count);
+          }
+          well_residual_sum[i].swap(lag_sum[0]);
+          well_residual_count[i].swap(lag_count[0]);
+        }
+      }
+
+      for (int i = 0; i < n_wells; i++){
+        for (size_t lag = 0; lag < well_residual_count[i].size(); lag++){
+          if (well_residual_count[i][lag] > 0){
+            residual_variance_vs[lag] += well_residual_sum[i][lag];
+            count_obs[lag]            += static_cast<int>(well_residual_count[i][lag]);
+            if (static_cast<int>(lag) > last_obs)
+              last_obs = static_cast<int>(lag);
+          }
         }
       }
       for (int i = 0; i <= last_obs; i++){
@@ -976,179 +995,142 @@ void            Analyzelog::EstimateAutoCovarianceFunction(std::vector<NRLib::Ma
   // matrices for each time lag, i.e. cov(h)(vp, vs) != cov(h)(vs, vp)
   // but cov(h)(vp,vs) = cov(-h)(vs,vp) and cov(h)(vs,vp) = cov(-h)(vp,vs)
   //
-  for (size_t i = 0; i < well_names.size(); i++){
+  // The lagged products are found for each well separately, using masked FFT
+  // correlations where the blocks lie on a regular lag grid, and summed in well order.
+  //
+  int n_wells = static_cast<int>(well_names.size());
+  std::vector<std::vector<NRLib::Matrix> > well_auto_cov(n_wells);
+  std::vector<std::vector<NRLib::Matrix> > well_count(n_wells);
+  std::vector<int>                         well_max_lag(n_wells, 0);
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (int i = 0; i < n_wells; i++){
     time_t timestart, timeend;
     time(&timestart);
+
+    const BlockedLogsCommon   * blocked_log  = mapped_blocked_logs.find(well_names[i])->second;
+    const std::vector<double> & log_vp       = log_data_vp.find(well_names[i])->second;
+    const std::vector<double> & log_vs       = log_data_vs.find(well_names[i])->second;
+    const std::vector<double> & log_rho      = log_data_rho.find(well_names[i])->second;
+    int                         n            = static_cast<int>(log_vp.size());
+
+    //
+    // If this Vs log is synthetic and there exist real Vs logs: use regression coefficients
+    // Vs = a*Vp + b*Rho + e, where e is iid with lagged covariance residual_variance_vs
+    //
+    bool synthetic_vs = blocked_log->HasSyntheticVsLog();
+    bool regressed_vs = !all_Vs_logs_synthetic && synthetic_vs;
+
+    // Series 0-2 are Vp, Rho and Vs, series 3-5 their indicators
+    std::vector<std::vector<double> > series(6, std::vector<double>(n, 0.0));
+    for (int k = 0; k < n; k++){
+      if (log_vp[k] != RMISSING){
+        series[0][k] = log_vp[k];
+        series[3][k] = 1.0;
+      }
+      if (log_rho[k] != RMISSING){
+        series[1][k] = log_rho[k];
+        series[4][k] = 1.0;
+      }
+      if (regressed_vs){
+        if (log_vp[k] != RMISSING && log_rho[k] != RMISSING){
+          series[2][k] = regression_coef(0)*log_vp[k] + regression_coef(1)*log_rho[k];
+          series[5][k] = 1.0;
+        }
+      }
+      else if (!synthetic_vs && log_vs[k] != RMISSING){
+        series[2][k] = log_vs[k];
+        series[5][k] = 1.0;
+      }
+    }
+
+    std::vector<LagProduct> products;
+    products.push_back(LagProduct(0, 0, 0, 0));   // cov(vp_k, vp_l)
+    products.push_back(LagProduct(1, 1, 2, 2));   // cov(rho_k, rho_l)
+    products.push_back(LagProduct(0, 1, 0, 2));   // cov(vp_k, rho_l)
+    products.push_back(LagProduct(1, 0, 2, 0));   // cov(rho_k, vp_l)
+    if (regressed_vs){
+      products.push_back(LagProduct(2, 2, 1, 1)); // cov(vs_k, vs_l) + var(e)
+      products.push_back(LagProduct(0, 2, 0, 1)); // cov(vp_k, vs_l)
+      products.push_back(LagProduct(2, 0, 1, 0)); // cov(vs_k, vp_l)
+      products.push_back(LagProduct(1, 2, 1, 2)); // cov(rho_k, vs_l)
+      products.push_back(LagProduct(2, 1, 2, 1)); // cov(vs_k, rho_l)
+    }
+    else if (!synthetic_vs){
+      products.push_back(LagProduct(2, 2, 1, 1)); // cov(vs_k, vs_l)
+      products.push_back(LagProduct(0, 2, 0, 1)); // cov(vp_k, vs_l)
+      products.push_back(LagProduct(2, 0, 1, 0)); // cov(vs_k, vp_l)
+      products.push_back(LagProduct(2, 1, 1, 2)); // cov(vs_k, rho_l)
+      products.push_back(LagProduct(1, 2, 2, 1)); // cov(rho_k, vs_l)
+    }
+    int n_products = static_cast<int>(products.size());
+
+    std::vector<std::vector<double> > lag_sum(n_products, std::vector<double>(max_nd, 0.0));
+    std::vector<std::vector<double> > lag_count(n_products, std::vector<double>(max_nd, 0.0));
+    std::vector<double>               z_rel;
+
     for (size_t j = 0; j < interval_simboxes.size(); j++){
       std::string interval_name = interval_simboxes[j]->GetIntervalName();
-      size_t nd = mapped_blocked_logs.find(well_names[i])->second->GetNBlocksWithData(interval_name);
-      const std::vector<double> & x_pos = mapped_blocked_logs.find(well_names[i])->second->GetXposBlocked();
-      const std::vector<double> & y_pos = mapped_blocked_logs.find(well_names[i])->second->GetYposBlocked();
-      const std::vector<double> & z_pos = mapped_blocked_logs.find(well_names[i])->second->GetZposBlocked();
-      std::vector<double> z(nd);
-      const std::vector<double> log_vp   = log_data_vp.find(well_names[i])->second;
-      const std::vector<double> log_vs   = log_data_vs.find(well_names[i])->second;
-      const std::vector<double> log_rho  = log_data_rho.find(well_names[i])->second;
-      //
-      // 2.2.1 Add autocovariance data
-      //
-      int lag = 0;
-
-      for (size_t k = 0; k < nd; k++){
-        for (size_t l = k; l < nd; l++){
-
-          if(log_vp[k] != RMISSING || log_vs[k] != RMISSING || log_rho[k] != RMISSING){
-            if (log_vp[l] != RMISSING || log_vs[l] != RMISSING || log_rho[l] != RMISSING) {
-              double xk = x_pos[k];
-              double yk = y_pos[k];
-              double xl = x_pos[l];
-              double yl = y_pos[l];
-              double z_k_rel = (z_pos[k] - interval_simboxes[j]->getTop(xk, yk))/interval_simboxes[j]->getRelThick(xk, yk);
-              double z_l_rel = (z_pos[l] - interval_simboxes[j]->getTop(xl, yl))/interval_simboxes[j]->getRelThick(xl, yl);
-              lag = static_cast<int>(std::floor(std::abs(z_k_rel - z_l_rel)/min_dz + 0.5));
-
-              // cov(vp_k, vp_l)
-              if(log_vp[k] != RMISSING && log_vp[l] != RMISSING){
-                if (lag > max_lag_with_data)
-                  max_lag_with_data = lag;
-                temp_auto_cov[lag](0,0) += log_vp[k]*log_vp[l];
-                count[lag](0,0) += 1;
-              }
-              // cov(rho_k, rho_l)
-              if(log_rho[k] != RMISSING && log_rho[l] != RMISSING){
-                if (lag > max_lag_with_data)
-                  max_lag_with_data = lag;
-                temp_auto_cov[lag](2,2) += log_rho[k]*log_rho[l];
-                count[lag](2,2) += 1;
-              }
-              // cov(vp_k, rho_l)
-              if(log_vp[k] != RMISSING && log_rho[l] != RMISSING){
-                temp_auto_cov[lag](0,2) += log_vp[k]*log_rho[l];
-                count[lag](0,2) += 1;
-                if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                  temp_auto_cov[lag](2,0) += log_vp[k]*log_rho[l];
-                  count[lag](2,0)         += 1;
-                }
-              }
-              // cov(rho_k, vp_l)
-              if(log_rho[k] != RMISSING && log_vp[l] != RMISSING){
-                temp_auto_cov[lag](2,0) += log_rho[k]*log_vp[l];
-                count[lag](2,0) += 1;
-                if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                  temp_auto_cov[lag](0,2) += log_rho[k]*log_vp[l];
-                  count[lag](0,2)         += 1;
-                }
-              }
-              //
-              // If this Vs log is synthetic and there exist real Vs logs: use regression coefficients
-              //
-              if(!all_Vs_logs_synthetic && mapped_blocked_logs.find(well_names[i])->second->HasSyntheticVsLog() == true){
-                // Use the relation Vs = a*Vp + b*Rho + e, where e is iid
-                // cov[t](vs_i, vs_j) = cov[t](a*vp_k + b*rho_k + e_k, a*vp_l + b*rho_l + e_l) = a*a*cov(vp_k,vp_l) + a*b*cov(vp_k, rho_l) + a*b*cov(vp_l, rho_k) + b*b*cov(rho_k, rho_l) + I(k = l) var(e)
-                if(log_vp[k] != RMISSING && log_rho[k] != RMISSING && log_rho[l] != RMISSING && log_vp[l] != RMISSING){
-                  double vs_k = regression_coef(0)*log_vp[k] + regression_coef(1)*log_rho[k];
-                  double vs_l = regression_coef(0)*log_vp[l] + regression_coef(1)*log_rho[l];
-
-                  temp_auto_cov[lag](1,1) += vs_k*vs_l + residual_variance_vs[lag];
-                  //if (k == l)
-                  //  temp_auto_cov[lag](1,1) += var_vs_resid;
-                  count[lag](1,1) += 1;
-                }
-                // cov[l-k](vp, vs) = cov[l-k](vp_k, a*vp_l + b*rho_l + e_l) = a*autocov[l-k](vp_k, vp_l) + b*autocov[l-k](vp_k, rho_l)
-                if (log_vp[k] != RMISSING && log_vp[l] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](0,1) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_vp[k]*log_rho[l];
-                  count[lag](0,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,0) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_vp[k]*log_rho[l];
-                    count[lag](1,0)         += 1;
-                  }
-                }
-                // cov[l-k](vs, vp) = a*cov[l-k](vp_k, vp_l) + b*cov[l-k](rho_k, vp_l)
-                if (log_vp[k] != RMISSING && log_rho[k] != RMISSING && log_vp[l] != RMISSING){
-                  temp_auto_cov[lag](1,0) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_vp[l];
-                  count[lag](1,0)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](0,1) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_vp[l];
-                    count[lag](0,1)         += 1;
-                  }
-                }
-                // cov[l-k](rho_k, vs_l) = cov[l-k](rho_k, a*vp_l + b*rho_l + e_l) = a*cov[l-k](rho_k,vp_l) + b*cov[l-k](rho_k, rho_l)
-                if (log_rho[k] != RMISSING && log_vp[l] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](1,2) += regression_coef(0)*log_rho[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                  count[lag](1,2)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](2,1) += regression_coef(0)*log_rho[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                    count[lag](2,1)         += 1;
-                  }
-                }
-                // cov[l-k](vs_k, rho_l) = a*cov[l-k](vp_k, rho_l) + b*cov[l-k](rho_k, rho_l)
-                if (log_rho[k] != RMISSING && log_vp[k] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](2,1) += regression_coef(0)*log_vp[k]*log_rho[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                  count[lag](2,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,2) += regression_coef(0)*log_vp[k]*log_rho[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                    count[lag](1,2)         += 1;
-                  }
-                }
-              }
-              //
-              // Non-synthetic Vs log
-              //
-              else if(mapped_blocked_logs.find(well_names[i])->second->HasSyntheticVsLog() == false){
-                // cov[t](vs, vs)
-                if(log_vs[k] != RMISSING && log_vs[l] != RMISSING){
-                  if (lag > max_lag_with_data)
-                    max_lag_with_data = lag;
-                  temp_auto_cov[lag](1,1) += log_vs[k]*log_vs[l];
-                  count[lag](1,1)         += 1;
-                }
-                // cov[t](vp, vs)
-                if(log_vp[k] != RMISSING && log_vs[l] != RMISSING){
-                  temp_auto_cov[lag](0,1) += log_vp[k]*log_vs[l];
-                  count[lag](0,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,0) += log_vp[k]*log_vs[l];
-                    count[lag](1,0)         += 1;
-                  }
-                }
-                // cov[t](vs, vp)
-                if(log_vs[k] != RMISSING && log_vp[l] != RMISSING){
-                  temp_auto_cov[lag](1,0) += log_vs[k]*log_vp[l];
-                  count[lag](1,0)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](0,1) += log_vs[k]*log_vp[l];
-                    count[lag](0,1)         += 1;
-                  }
-                }
-                // cov[t](vs, rho)
-                if(log_vs[k] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](1,2) += log_vs[k]*log_rho[l];
-                  count[lag](1,2)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](2,1) += log_vs[k]*log_rho[l];
-                    count[lag](2,1)         += 1;
-                  }
-                }
-                // cov[t](rho, vs)
-                if(log_rho[k] != RMISSING && log_vs[l] != RMISSING){
-                  temp_auto_cov[lag](2,1) += log_rho[k]*log_vs[l];
-                  count[lag](2,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,2) += log_rho[k]*log_vs[l];
-                    count[lag](1,2)         += 1;
-                  }
-                }
-              }
-            }
+      int nd = std::min(blocked_log->GetNBlocksWithData(interval_name), n);
+      CalculateRelativeDepth(blocked_log, interval_simboxes[j], nd, z_rel);
+      AccumulateLaggedProducts(series, products, z_rel, nd, min_dz, lag_sum, lag_count);
+    }
+
+    well_auto_cov[i].resize(max_nd);
+    well_count[i].resize(max_nd);
+    for (int lag = 0; lag < max_nd; lag++){
+      well_auto_cov[i][lag].resize(3, 3);
+      well_count[i][lag].resize(3, 3);
+      for (int j = 0; j < 3; j++){
+        for (int k = 0; k < 3; k++){
+          well_auto_cov[i][lag](j,k) = 0.0;
+          well_count[i][lag](j,k)    = 0.0;
+        }
+      }
+    }
+
+    for (int p = 0; p < n_products; p++){
+      int  row         = products[p].row;
+      int  col         = products[p].col;
+      bool diagonal    = (row == col);
+      bool residual    = (diagonal && row == 1 && regressed_vs);
+      for (int lag = 0; lag < max_nd; lag++){
+        if (lag_count[p][lag] > 0){
+          double value = lag_sum[p][lag];
+          if (residual && lag < static_cast<int>(residual_variance_vs.size()))
+            value += lag_count[p][lag]*residual_variance_vs[lag];
+          well_auto_cov[i][lag](row,col) += value;
+          well_count[i][lag](row,col)    += lag_count[p][lag];
+          if (lag == 0 && !diagonal){ // In lag 0, the autocov matrix is symmetric
+            well_auto_cov[i][lag](col,row) += value;
+            well_count[i][lag](col,row)    += lag_count[p][lag];
           }
+          if (diagonal && !residual && lag > well_max_lag[i])
+            well_max_lag[i] = lag;
         }
       }
     }
+
     time(&timeend);
     long int time = static_cast<long int>(timeend - timestart);
     printf("\nWell %s processed in %ld seconds.",well_names[i].c_str(),time);
   }
 
+  for (int i = 0; i < n_wells; i++){
+    for (int lag = 0; lag < max_nd; lag++){
+      for (int j = 0; j < 3; j++){
+        for (int k = 0; k < 3; k++){
+          temp_auto_cov[lag](j,k) += well_auto_cov[i][lag](j,k);
+          count[lag](j,k)         += well_count[i][lag](j,k);
+        }
+      }
+    }
+    if (well_max_lag[i] > max_lag_with_data)
+      max_lag_with_data = well_max_lag[i];
+  }
+
   //
   // 2.2.2 Calculate diagonal autocovariances
   //
@@ -1441,6 +1423,141 @@ void            Analyzelog::EstimateAutoCovarianceFunction(std::vector<NRLib::Ma
 
 }
 
+void Analyzelog::CalculateRelativeDepth(const BlockedLogsCommon * blocked_log,
+                                        const Simbox            * simbox,
+                                        int                       n,
+                                        std::vector<double>     & z_rel)
+{
+  const std::vector<double> & x_pos = blocked_log->GetXposBlocked();
+  const std::vector<double> & y_pos = blocked_log->GetYposBlocked();
+  const std::vector<double> & z_pos = blocked_log->GetZposBlocked();
+
+  z_rel.resize(n);
+  for (int k = 0; k < n; k++)
+    z_rel[k] = (z_pos[k] - simbox->getTop(x_pos[k], y_pos[k]))/simbox->getRelThick(x_pos[k], y_pos[k]);
+}
+
+//
+// Add the lagged products sum_{k<=l} x_k*y_l and the number of pairs where both are
+// present, for each lag = floor(|z_rel_k - z_rel_l|/min_dz + 0.5) and each product.
+// The first half of series holds values (0 where missing), the second half indicators.
+//
+void Analyzelog::AccumulateLaggedProducts(const std::vector<std::vector<double> > & series,
+                                          const std::vector<LagProduct>           & products,
+                                          const std::vector<double>               & z_rel,
+                                          int                                       nd,
+                                          float                                     min_dz,
+                                          std::vector<std::vector<double> >       & sum,
+                                          std::vector<std::vector<double> >       & count)
+{
+  int n_values   = static_cast<int>(series.size())/2;
+  int n_products = static_cast<int>(products.size());
+  int n_lags     = static_cast<int>(sum[0].size());
+
+  if (nd == 0)
+    return;
+
+  //
+  // When the samples are ordered downwards on a regular lag grid (the normal case for
+  // blocked logs), they are put in bins and the products are found as masked
+  // cross-correlations by FFT. Small or irregular logs use the pairwise sums directly.
+  //
+  const int min_nd_fft = 128;
+
+  std::vector<int> bin(nd);
+  bool   regular = (nd >= min_nd_fft);
+  double e_min   = 0.0;
+  double e_max   = 0.0;
+  for (int k = 0; k < nd && regular; k++){
+    double u = (z_rel[k] - z_rel[0])/min_dz;
+    if (!(std::abs(u) < 1.0e+7)){
+      regular = false;
+      break;
+    }
+    bin[k]   = static_cast<int>(std::floor(u + 0.5));
+    double e = u - bin[k];
+    e_min    = std::min(e_min, e);
+    e_max    = std::max(e_max, e);
+    if ((k > 0 && bin[k] <= bin[k-1]) || e_max - e_min >= 0.25)
+      regular = false;
+  }
+
+  if (regular){
+    int n_bins = bin[nd-1] + 1;
+    int n_fft  = FFTGrid::findClosestFactorableNumber(n_bins + n_lags);
+    int n_cfft = n_fft/2 + 1;
+    int n_rfft = 2*n_cfft;
+
+    rfftwnd_plan fft_plan;
+    rfftwnd_plan ifft_plan;
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+    {
+      fft_plan  = rfftwnd_create_plan(1, &n_fft, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
+      ifft_plan = rfftwnd_create_plan(1, &n_fft, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
+    }
+
+    int n_series = static_cast<int>(series.size());
+    std::vector<std::vector<fftw_real> > spectrum(n_series, std::vector<fftw_real>(n_rfft, 0.0f));
+    for (int s = 0; s < n_series; s++){
+      for (int k = 0; k < nd; k++)
+        spectrum[s][bin[k]] = static_cast<fftw_real>(series[s][k]);
+      rfftwnd_one_real_to_complex(fft_plan, &spectrum[s][0], NULL);
+    }
+
+    // c(h) = sum_b x(b)*y(b+h) is the inverse transform of conj(X)*Y
+    int                    max_lag = std::min(n_lags, n_bins);
+    std::vector<fftw_real> work(n_rfft);
+    for (int p = 0; p < n_products; p++){
+      for (int m = 0; m < 2; m++){
+        int x = products[p].x + m*n_values;
+        int y = products[p].y + m*n_values;
+        const fftw_complex * x_c = reinterpret_cast<const fftw_complex *>(&spectrum[x][0]);
+        const fftw_complex * y_c = reinterpret_cast<const fftw_complex *>(&spectrum[y][0]);
+        fftw_complex       * w_c = reinterpret_cast<fftw_complex *>(&work[0]);
+        for (int f = 0; f < n_cfft; f++){
+          w_c[f].re = x_c[f].re*y_c[f].re + x_c[f].im*y_c[f].im;
+          w_c[f].im = x_c[f].re*y_c[f].im - x_c[f].im*y_c[f].re;
+        }
+        rfftwnd_one_complex_to_real(ifft_plan, w_c, NULL);
+        for (int h = 0; h < max_lag; h++){
+          double c = static_cast<double>(work[h])/n_fft;
+          if (m == 0)
+            sum[p][h]   += c;
+          else
+            count[p][h] += std::floor(c + 0.5);
+        }
+      }
+    }
+
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+    {
+      fftwnd_destroy_plan(fft_plan);
+      fftwnd_destroy_plan(ifft_plan);
+    }
+  }
+  else {
+    for (int k = 0; k < nd; k++){
+      for (int l = k; l < nd; l++){
+        int lag = static_cast<int>(std::floor(std::abs(z_rel[k] - z_rel[l])/min_dz + 0.5));
+        if (lag < 0 || lag >= n_lags)
+          continue;
+        for (int p = 0; p < n_products; p++){
+          int x = products[p].x;
+          int y = products[p].y;
+          if (series[x + n_values][k] > 0.0 && series[y + n_values][l] > 0.0){
+            sum[p][lag]   += series[x][k]*series[y][l];
+            count[p][lag] += 1.0;
+          }
+        }
+      }
+    }
+  }
+}
+
 //
 // Estimate auto correlation and variances. Use lag 0 to estimate variance.
 //
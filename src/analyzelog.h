@@ -108,8 +108,31 @@ private:
                                                  int                                                  max_nd,
                                                  int                                                  min_blocks_with_data_for_corr_estim,
                                                  int                                                & max_lag_with_data,
+                                                 int                                                  n_threads,
                                                  std::string                                        & err_text);
 
+  // Lagged product x_k*y_l of two series, added to element (row, col) of the autocovariance
+  struct LagProduct {
+    LagProduct(int x_in, int y_in, int row_in, int col_in) : x(x_in), y(y_in), row(row_in), col(col_in) {}
+    int x;
+    int y;
+    int row;
+    int col;
+  };
+
+  static void     CalculateRelativeDepth(const BlockedLogsCommon                          * blocked_log,
+                                         const Simbox                                     * simbox,
+                                         int                                                n,
+                                         std::vector<double>                              & z_rel);
+
+  static void     AccumulateLaggedProducts(const std::vector<std::vector<double> >        & series,
+                                           const std::vector<LagProduct>                  & products,
+                                           const std::vector<double>                      & z_rel,
+                                           int                                              nd,
+                                           float                                            min_dz,
+                                           std::vector<std::vector<double> >              & sum,
+                                           std::vector<std::vector<double> >              & count);
+
   void            SetParameterCov(const NRLib::Matrix                           & auto_cov,
                                   NRLib::Matrix                                 & var_0,
                                   int                                             n_params);
@@ -64,6 +64,11 @@ Background::SetupBackground(std::vector<NRLib::Grid<float> *>                & p
   for (int i=0 ; i<3 ; i++)
     parameters[i]->Resize(nx_pad, ny_pad, nz_pad);
 
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+
   if (bg_simbox == NULL) {
     GenerateBackgroundModel(parameters[0], parameters[1], parameters[2],
                             vertical_trends,
@@ -84,17 +89,15 @@ Background::SetupBackground(std::vector<NRLib::Grid<float> *>                & p
                             interval_name,
                             err_text);
 
+    std::vector<float> avg(3);
     ResampleBackgroundModel(parameters[0], parameters[1], parameters[2],
                             bg_simbox,
-                            simbox);
-
-    float avg = 0.0f;
-    float min = 0.0f;
-    float max = 0.0f;
-    for (int i = 0; i < 3; i++) {
-      parameters[i]->GetAvgMinMaxWithMissing(avg, min, max, RMISSING);
-      CommonData::SetUndefinedCellsToGlobalAverageGrid(parameters[i], avg);
-    }
+                            simbox,
+                            avg,
+                            n_threads);
+
+    for (int i = 0; i < 3; i++)
+      CommonData::SetUndefinedCellsToGlobalAverageGrid(parameters[i], avg[i]);
 
   }
 }
@@ -1233,24 +1236,29 @@ Background::ResampleBackgroundModel(NRLib::Grid<float>  * & bg_vp,
                                     NRLib::Grid<float>  * & bg_vs,
                                     NRLib::Grid<float>  * & bg_rho,
                                     const Simbox        *   bg_simbox,
-                                    const Simbox        *   simbox)
+                                    const Simbox        *   simbox,
+                                    std::vector<float>  &   avg,
+                                    int                     n_threads)
 {
-  NRLib::Grid<float> * res_bg_vp  = new NRLib::Grid<float>();
-  NRLib::Grid<float> * res_bg_vs  = new NRLib::Grid<float>();
-  NRLib::Grid<float> * res_bg_rho = new NRLib::Grid<float>();
+  std::vector<NRLib::Grid<float> *> p_old(3);
+  p_old[0] = bg_vp;
+  p_old[1] = bg_vs;
+  p_old[2] = bg_rho;
+
+  std::vector<NRLib::Grid<float> *> p_new(3);
+  for (int p = 0; p < 3; p++)
+    p_new[p] = new NRLib::Grid<float>();
 
   LogKit::LogFormatted(LogKit::Low,"\nResampling background model...\n");
-  ResampleParameter(res_bg_vp,  bg_vp,  simbox, bg_simbox);
-  ResampleParameter(res_bg_vs,  bg_vs,  simbox, bg_simbox);
-  ResampleParameter(res_bg_rho, bg_rho, simbox, bg_simbox);
+  ResampleParameters(p_new, p_old, simbox, bg_simbox, avg, n_threads);
 
   delete bg_vp;
   delete bg_vs;
   delete bg_rho;
 
-  bg_vp  = res_bg_vp;
-  bg_vs  = res_bg_vs;
-  bg_rho = res_bg_rho;
+  bg_vp  = p_new[0];
+  bg_vs  = p_new[1];
+  bg_rho = p_new[2];
 }
 
 void
@@ -1259,9 +1267,25 @@ Background::ResampleParameter(NRLib::Grid<float> *& p_new, // Resample to
                               const Simbox       *  simbox_new,
                               const Simbox       *  simbox_old)
 {
-  int nx = simbox_new->getnx();
-  int ny = simbox_new->getny();
-  int nz = simbox_new->getnz();
+  std::vector<NRLib::Grid<float> *> p_new_vec(1, p_new);
+  std::vector<NRLib::Grid<float> *> p_old_vec(1, p_old);
+  std::vector<float>                avg;
+
+  ResampleParameters(p_new_vec, p_old_vec, simbox_new, simbox_old, avg, 1);
+}
+
+void
+Background::ResampleParameters(std::vector<NRLib::Grid<float> *>       & p_new, // Resample to
+                               const std::vector<NRLib::Grid<float> *> & p_old, // Resample from
+                               const Simbox                            * simbox_new,
+                               const Simbox                            * simbox_old,
+                               std::vector<float>                      & avg,
+                               int                                       n_threads)
+{
+  int nx    = simbox_new->getnx();
+  int ny    = simbox_new->getny();
+  int nz    = simbox_new->getnz();
+  int n_par = static_cast<int>(p_old.size());
   //
   // Use same padding as for nonresampled cubes
   //
@@ -1277,9 +1301,11 @@ Background::ResampleParameter(NRLib::Grid<float> *& p_new, // Resample to
   //
   // k2 = dz1/dz2 * k1 + (z02 - z01)/dz2    (from dz2*k2 + z02 = dz1*k1 + z01)
   //
-  double * a       = new double[nx*ny];
-  double * b       = new double[nx*ny];
-  bool   * missing = new bool[nx*ny];
+  // The column mapping is the same for all parameters, so it is found once.
+  //
+  std::vector<double> a(nx*ny);
+  std::vector<double> b(nx*ny);
+  std::vector<bool>   missing(nx*ny);
 
   int ij = 0;
   for (int j = 0; j < ny; j++) {
@@ -1302,87 +1328,113 @@ Background::ResampleParameter(NRLib::Grid<float> *& p_new, // Resample to
   }
 
   //
-  // Resample parameter
+  // Resample parameters. Each layer is mapped and smoothed for all
+  // parameters in one go, and the layers are independent. The smoothing
+  // needs the neighbouring columns, so the parallelisation is over layers.
   //
-  p_new->Resize(nx, ny, nz);
+  for (int p = 0; p < n_par; p++)
+    p_new[p]->Resize(nx, ny, nz);
 
-  double * layer = new double[nx*ny];
+  std::vector<double> layer_sum(n_par*nz, 0.0);
+  std::vector<int>    layer_count(n_par*nz, 0);
 
+#ifdef PARALLEL
+  int chunk_size = 1;
+#pragma omp parallel for schedule(dynamic, chunk_size) num_threads(n_threads)
+#endif
   for (int k = 0; k < nz; k++) {
-    //
-    // Map a layer
-    //
-    int ij=0;
-    for (int j = 0; j < ny; j++) {
-      for (int i = 0; i < nx; i++) {
-        if (missing[ij] == false) {
-          int k_old = static_cast<int>(static_cast<double>(k)*a[ij] + b[ij]);
-          layer[ij] = p_old->GetValue(i, j, k_old);
+    std::vector<double> layer(nx*ny);
+
+    for (int p = 0; p < n_par; p++) {
+      //
+      // Map a layer
+      //
+      int ij=0;
+      for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) {
+          if (missing[ij] == false) {
+            int k_old = static_cast<int>(static_cast<double>(k)*a[ij] + b[ij]);
+            layer[ij] = p_old[p]->GetValue(i, j, k_old);
+          }
+          else
+            layer[ij] = RMISSING;
+          ij++;
         }
-        else
-          layer[ij] = RMISSING;
-        ij++;
       }
-    }
-    //
-    // Smooth the layer (equal weighting of all neighbouring cells)
-    //
-    double value = 0.0;
-    for (int j = 0; j < ny; j++) {
-      for (int i = 0; i < nx; i++) {
-        if (layer[j*nx + i] != RMISSING) {
-          int n = 1;
-          double sum = layer[j*nx + i];
-          if (i > 1) {
-            if (layer[j*nx + i - 1] != RMISSING) {
-              sum += layer[j*nx + i - 1];
-              n++;
+      //
+      // Smooth the layer (equal weighting of all neighbouring cells)
+      //
+      double value = 0.0;
+      for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) {
+          if (layer[j*nx + i] != RMISSING) {
+            int n = 1;
+            double sum = layer[j*nx + i];
+            if (i > 1) {
+              if (layer[j*nx + i - 1] != RMISSING) {
+                sum += layer[j*nx + i - 1];
+                n++;
+              }
             }
-          }
-          if (j > 1) {
-            if (layer[(j - 1)*nx + i] != RMISSING) {
-              sum += layer[(j - 1)*nx + i];
-              n++;
+            if (j > 1) {
+              if (layer[(j - 1)*nx + i] != RMISSING) {
+                sum += layer[(j - 1)*nx + i];
+                n++;
+              }
             }
-          }
-          if (i > 1 && j > 1) {
-            if (layer[(j - 1)*nx + i - 1] != RMISSING) {
-              sum += layer[(j - 1)*nx + i - 1];
-              n++;
+            if (i > 1 && j > 1) {
+              if (layer[(j - 1)*nx + i - 1] != RMISSING) {
+                sum += layer[(j - 1)*nx + i - 1];
+                n++;
+              }
             }
-          }
-          if (i < nx-1) {
-            if (layer[j*nx + i + 1] != RMISSING) {
-              sum += layer[j*nx + i + 1];
-              n++;
+            if (i < nx-1) {
+              if (layer[j*nx + i + 1] != RMISSING) {
+                sum += layer[j*nx + i + 1];
+                n++;
+              }
             }
-          }
-          if (j < ny-1) {
-            if (layer[(j + 1)*nx + i] != RMISSING) {
-              sum += layer[(j + 1)*nx + i];
-              n++;
+            if (j < ny-1) {
+              if (layer[(j + 1)*nx + i] != RMISSING) {
+                sum += layer[(j + 1)*nx + i];
+                n++;
+              }
             }
-          }
-          if (i < nx-1 && j < ny-1) {
-            if (layer[(j + 1)*nx + i + 1] != RMISSING) {
-              sum += layer[(j + 1)*nx + i + 1];
-              n++;
+            if (i < nx-1 && j < ny-1) {
+              if (layer[(j + 1)*nx + i + 1] != RMISSING) {
+                sum += layer[(j + 1)*nx + i + 1];
+                n++;
+              }
             }
+            value = sum/static_cast<double>(n);
+          }
+          else
+            value = RMISSING;
+
+          float f_value = static_cast<float>(value);
+          p_new[p]->SetValue(i, j, k, f_value);
+          if (f_value != RMISSING) {
+            layer_sum[p*nz + k] += f_value;
+            layer_count[p*nz + k]++;
           }
-          value = sum/static_cast<double>(n);
         }
-        else
-          value = RMISSING;
-
-        p_new->SetValue(i, j, k, static_cast<float>(value));
       }
     }
   }
 
-  delete [] layer;
-  delete [] a;
-  delete [] b;
-  delete [] missing;
+  //
+  // Average of the defined cells, summed layer by layer to be independent of the thread count
+  //
+  avg.resize(n_par);
+  for (int p = 0; p < n_par; p++) {
+    double sum   = 0.0;
+    int    count = 0;
+    for (int k = 0; k < nz; k++) {
+      sum   += layer_sum[p*nz + k];
+      count += layer_count[p*nz + k];
+    }
+    avg[p] = static_cast<float>(sum/static_cast<double>(count));
+  }
 }
 
 FFTGrid *
@@ -74,7 +74,17 @@ private:
                                        NRLib::Grid<float>  * & bg_vs,
                                        NRLib::Grid<float>  * & bg_rho,
                                        const Simbox        *   bg_simbox,
-                                       const Simbox        *   simbox);
+                                       const Simbox        *   simbox,
+                                       std::vector<float>  &   avg,
+                                       int                     n_threads);
+
+  static
+  void         ResampleParameters(std::vector<NRLib::Grid<float> *>       & p_new, // Resample to
+                                  const std::vector<NRLib::Grid<float> *> & p_old, // Resample from
+                                  const Simbox                            * simbox_new,
+                                  const Simbox                            * simbox_old,
+                                  std::vector<float>                      & avg,   // Average of defined cells
+                                  int                                       n_threads);
   static
   void         CalculateBackgroundTrend(std::vector<double>               & trend,
                                         std::vector<double>               & avgDev,
@@ -1049,8 +1049,13 @@ void  BlockedLogsCommon::FindSizeAndBlockPointers(const Simbox
   const int ny    = estimation_simbox->getny();
   simbox_ind[0] = nx*ny*old_K + nx*old_J + old_I;
 
+  std::vector<int> i_ind, j_ind, k_ind;
+  estimation_simbox->getIndexes(x_pos, y_pos, z_pos, i_ind, j_ind, k_ind);
+
   for (int m = first_M + 1 ; m < last_M + 1 ; m++) {
-    estimation_simbox->getIndexes(x_pos[m], y_pos[m], z_pos[m], new_I ,new_J, new_K);
+    new_I = i_ind[m];
+    new_J = j_ind[m];
+    new_K = k_ind[m];
 
     if (new_I != old_I || new_J != old_J || new_K != old_K) {
 
@@ -1801,7 +1806,7 @@ void BlockedLogsCommon::SetTimeGradientSettings(float distance, float sigma_m)
   sigma_m_ = sigma_m;
 }
 
-void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     & seismic_data,
+void BlockedLogsCommon::FindSeismicGradient(const SeismicTraceCache           & trace_cache,
                                             const Simbox                * const estimation_simbox,
                                             int                                 n_angles,
                                             std::vector<double>               & x_gradient,
@@ -1822,7 +1827,6 @@ void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     &
   std::vector<double> q_epsilon(4*n_blocks_);
   std::vector<double> q_epsilon_data(2*n_blocks_);
 
-  std::vector<float> seis_trace;
   std::vector<double> z_shift(int(nZx*nZy*n_blocks_));
 
   //seismic peak position and characteristics in well
@@ -1835,29 +1839,12 @@ void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     &
   std::vector<double> peak;
   std::vector<double> b;
 
-  int i0 = i_pos_[0];
-  int j0 = j_pos_[0];
-
-  //Check if well needs to change position in order for the whole
-  //shift region to be contained in the seismic cube
-  //NBNB marita M� testes om det fungerer for forskjellige br�nner
+  //Move the well if needed, so that the whole shift region is contained in
+  //the seismic cube
   int nx = estimation_simbox->getnx();
   int ny = estimation_simbox->getny();
-  int di_neg = 0; int di_pos = 0; int dj_neg = 0; int dj_pos = 0; //The max replacement in well in x and y direction.
-  for (k = 1; k < n_blocks_; k++) {
-    di_pos = std::max(i0 - i_pos_[k] , di_pos);
-    di_neg = std::min(i0 - i_pos_[k] , di_neg);
-    dj_pos = std::max(j0 - j_pos_[k] , dj_pos);
-    dj_neg = std::min(j0 - j_pos_[k] , dj_neg);
-  }
-  i0 = std::max(xEx, i0 + di_neg) - di_neg;
-  i0 = std::min(nx - xEx - 1, i0 + di_pos) - di_pos;
-  j0 = std::max(yEx, j0 + dj_neg) - dj_neg;
-  j0 = std::min(ny - yEx - 1, j0 + dj_pos) - dj_pos;
-
-
-  int di = i0 - i_pos_[0];
-  int dj = j0 - j_pos_[0];
+  int di, dj;
+  FindGradientWellShift(nx, ny, xEx, yEx, di, dj);
   if (di != 0 || dj != 0) {
     //adjust the well location
     for (k = 0; k < n_blocks_; k++) {
@@ -1866,37 +1853,26 @@ void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     &
     }
   }
 
-  char* buffer = new char[1000];
-  sprintf(buffer,"%s.txt", "C:/Outputfiles/traces");
-  std::ofstream out(buffer);
-  delete [] buffer;
+  int i0 = i_pos_[0];
+  int j0 = j_pos_[0];
 
   double dz, ztop, dzW, ztopW;
   for (l = 0; l < n_angles; l++) {
-    seismic_data[l]->SetRandomAccess();
+    // Smoothed traces for this well and angle, by column. A column is smoothed
+    // once, however many shifts use it.
+    std::map<int, std::vector<float> > smoothed_traces;
+
     for (j = -yEx; j <= yEx; j++) {
       for (i = -xEx; i <= xEx; i++) {
 
-        seis_trace = seismic_data[l]->GetRealTrace(estimation_simbox, i0, j0); ///H Correct values returned?
-        //seis_trace = seisCube[l]->getRealTrace2(i0, j0);
-
-        SmoothTrace(seis_trace);
-        //if (j == 0 ) {
-        //  for (int s = 0; s < seisTrace.size(); s++)
-        //    out << seisTrace[s] << std::endl;
-        //}
+        std::vector<float> & well_trace = GetSmoothedTrace(trace_cache, smoothed_traces, l, i0, j0, nx); ///H Correct values returned?
 
         dzW =  estimation_simbox->getdz(i0,j0);
         ztopW =  estimation_simbox->getTop(i0,j0);
-        FindPeakTrace(seis_trace, z_peak_well, peak_well, b_well, dzW, ztopW);
+        FindPeakTrace(well_trace, z_peak_well, peak_well, b_well, dzW, ztopW);
 
         //seis_trace = seisCube[l]->getRealTrace2(i0+i, j0+j);
-        seis_trace = seismic_data[l]->GetRealTrace(estimation_simbox, i0, j0);
-        SmoothTrace(seis_trace);
-        if (i==0) {
-          for (size_t s = 0; s < seis_trace.size(); s++)
-            out << seis_trace[s] << std::endl;
-        }
+        std::vector<float> & seis_trace = GetSmoothedTrace(trace_cache, smoothed_traces, l, i0, j0, nx);
 
         dz =  estimation_simbox->getdz(i0+i, j0+j);
         ztop =  estimation_simbox->getTop(i0+i, j0+j);
@@ -1911,19 +1887,15 @@ void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     &
             z_shift[(i+2) + (j+2)*nZx + k*(nZx*nZx)] = ComputeShift(z_peak,z_peak_well,z_pos_blocked_[k]);
           else {
             //well has changed lateral position and we adapt to the new well position
-            //seis_trace = seisCube[l]->getRealTrace2(i_pos_[k],j_pos_[k]);
-            seis_trace = seismic_data[l]->GetRealTrace(estimation_simbox, i_pos_[k], j_pos_[k]);
-            SmoothTrace(seis_trace);
+            std::vector<float> & k_well_trace = GetSmoothedTrace(trace_cache, smoothed_traces, l, i_pos_[k], j_pos_[k], nx);
             dzW = estimation_simbox->getdz(i_pos_[k],j_pos_[k]);
             ztopW = estimation_simbox->getTop(i_pos_[k],j_pos_[k]);
-            FindPeakTrace(seis_trace, z_peak_well, peak_well, b_well, dzW, ztopW);
+            FindPeakTrace(k_well_trace, z_peak_well, peak_well, b_well, dzW, ztopW);
 
-            //seis_trace = seisCube[l]->getRealTrace2(i_pos_[k]+i, j_pos_[k]+j);
-            seis_trace = seismic_data[l]->GetRealTrace(estimation_simbox, i_pos_[k]+i, j_pos_[k]+j);
-            SmoothTrace(seis_trace);
+            std::vector<float> & k_seis_trace = GetSmoothedTrace(trace_cache, smoothed_traces, l, i_pos_[k]+i, j_pos_[k]+j, nx);
             dz = estimation_simbox->getdz(i_pos_[k]+i, j_pos_[k]+j);
             ztop = estimation_simbox->getTop(i_pos_[k]+i, j_pos_[k]+j);
-            FindPeakTrace(seis_trace, z_peak, peak, b, dz, ztop);
+            FindPeakTrace(k_seis_trace, z_peak, peak, b, dz, ztop);
 
             PeakMatch(z_peak,peak,b,z_peak_well,peak_well,b_well);
 
@@ -1932,7 +1904,6 @@ void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     &
         }
       }
     }
-    seismic_data[l]->EndAccess();
     double dx = estimation_simbox->getdx();
     double dy = estimation_simbox->getdy();
 
@@ -1948,6 +1919,68 @@ void BlockedLogsCommon::FindSeismicGradient(std::vector<SeismicStorage *>     &
 
 }
 
+void BlockedLogsCommon::FindSeismicGradientColumns(const Simbox     * const estimation_simbox,
+                                                   std::vector<int> & columns) const
+{
+  int xEx = 2;
+  int yEx = 2;
+  int nx  = estimation_simbox->getnx();
+  int ny  = estimation_simbox->getny();
+  int di, dj;
+  FindGradientWellShift(nx, ny, xEx, yEx, di, dj);
+
+  for (unsigned int k = 0; k < n_blocks_; k++) {
+    for (int j = -yEx; j <= yEx; j++) {
+      for (int i = -xEx; i <= xEx; i++)
+        columns.push_back((i_pos_[k] + di + i) + (j_pos_[k] + dj + j)*nx);
+    }
+  }
+}
+
+void BlockedLogsCommon::FindGradientWellShift(int   nx,
+                                              int   ny,
+                                              int   xEx,
+                                              int   yEx,
+                                              int & di,
+                                              int & dj) const
+{
+  //Check if well needs to change position in order for the whole
+  //shift region to be contained in the seismic cube
+  //NBNB marita M� testes om det fungerer for forskjellige br�nner
+  int i0 = i_pos_[0];
+  int j0 = j_pos_[0];
+  int di_neg = 0; int di_pos = 0; int dj_neg = 0; int dj_pos = 0; //The max replacement in well in x and y direction.
+  for (unsigned int k = 1; k < n_blocks_; k++) {
+    di_pos = std::max(i0 - i_pos_[k] , di_pos);
+    di_neg = std::min(i0 - i_pos_[k] , di_neg);
+    dj_pos = std::max(j0 - j_pos_[k] , dj_pos);
+    dj_neg = std::min(j0 - j_pos_[k] , dj_neg);
+  }
+  i0 = std::max(xEx, i0 + di_neg) - di_neg;
+  i0 = std::min(nx - xEx - 1, i0 + di_pos) - di_pos;
+  j0 = std::max(yEx, j0 + dj_neg) - dj_neg;
+  j0 = std::min(ny - yEx - 1, j0 + dj_pos) - dj_pos;
+
+  di = i0 - i_pos_[0];
+  dj = j0 - j_pos_[0];
+}
+
+std::vector<float> & BlockedLogsCommon::GetSmoothedTrace(const SeismicTraceCache            & trace_cache,
+                                                         std::map<int, std::vector<float> > & smoothed_traces,
+                                                         int                                  angle,
+                                                         int                                  i,
+                                                         int                                  j,
+                                                         int                                  nx) const
+{
+  int key = i + j*nx;
+  std::map<int, std::vector<float> >::iterator it = smoothed_traces.find(key);
+  if (it == smoothed_traces.end()) {
+    it = smoothed_traces.insert(std::pair<int, std::vector<float> >(key, trace_cache.GetTrace(angle, i, j))).first;
+    SmoothTrace(it->second);
+  }
+  return it->second;
+}
+
 void BlockedLogsCommon::SmoothTrace(std::vector<float> &trace) const
 {
   float smoothing_distance = 40; //ms in each direction
@@ -2118,20 +2151,6 @@ void BlockedLogsCommon::ComputeGradient(std::vector<double>     & q_epsilon,
   std::vector<double> invcov(9);
   std::vector<double> regM(3*nx*ny);
 
-  static bool append = false;
-
-  char* buffer = new char[1000];
-  sprintf(buffer,"%s.txt", "C:/Outputfiles/gradNoSmooth");
-  std::ofstream out;
-  if (append) {
-    out.open(buffer, std::ios::app|std::ios::out);
-  }
-  else {
-    out.open(buffer);
-    append = true;
-  }
-  delete [] buffer;
-
   int ndata;
   double data;
 
@@ -2211,11 +2230,6 @@ void BlockedLogsCommon::ComputeGradient(std::vector<double>     & q_epsilon,
         sigma2 += sigmatmp*sigmatmp;
       }
 
-      double qa = sigma2*invcov[4];
-      double qb = sigma2*invcov[8];
-
-      out << beta1 << " " << beta2 << " " << qa << " " << qb << std::endl;
-
       //cov(beta) = sigma2*(ZtZ)^{-1}
       q_epsilon[counter1] += cov[4]/sigma2;
       q_epsilon[counter1+1] += cov[5]/sigma2;
@@ -286,13 +286,17 @@ public:
   void                                   SetTimeGradientSettings(float          distance,
                                                                  float          sigma_m);
 
-  void                                   FindSeismicGradient(std::vector<SeismicStorage *>     & seismic_data,
+  void                                   FindSeismicGradient(const SeismicTraceCache           & trace_cache,
                                                              const Simbox                      * const estimation_simbox,
                                                              int                                 n_angles,
                                                              std::vector<double>               & x_gradient,
                                                              std::vector<double>               & y_gradient,
                                                              std::vector<std::vector<double> > & sigma_gradient);
 
+                                         // Adds the seismic columns read by FindSeismicGradient, as i + j*nx.
+  void                                   FindSeismicGradientColumns(const Simbox     * const estimation_simbox,
+                                                                    std::vector<int> & columns) const;
+
   void                                   FindContinuousPartOfData(const std::vector<bool> & hasData,
                                                                   int                       nz,
                                                                   int                     & start,
@@ -568,6 +572,20 @@ private:
                          int                                n_facies,
                          int                                block_index) const;
 
+  void    FindGradientWellShift(int   nx,
+                                int   ny,
+                                int   xEx,
+                                int   yEx,
+                                int & di,
+                                int & dj) const;
+
+  std::vector<float> & GetSmoothedTrace(const SeismicTraceCache            & trace_cache,
+                                        std::map<int, std::vector<float> > & smoothed_traces,
+                                        int                                  angle,
+                                        int                                  i,
+                                        int                                  j,
+                                        int                                  nx) const;
+
   void    SmoothTrace(std::vector<float>                  & trace) const;
 
   void    FindPeakTrace(std::vector<float>                & trace,
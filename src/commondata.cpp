@@ -3,6 +3,7 @@
 ***************************************************************************/
 
 #include <math.h>
+#include <new>
 #define _USE_MATH_DEFINES
 
 #include "src/commondata.h"
@@ -1155,19 +1156,51 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
     std::vector<std::vector<int> >          facies_nr_wells;
     std::vector<std::vector<std::string> >  facies_names_wells;
 
+#ifdef PARALLEL
+    int n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+
+    //
+    // Wells are read and processed in parallel. Log messages, tasks, errors
+    // and results of each well are held back and passed on in well order.
+    // Running out of memory is rethrown once all wells are done.
+    //
+    bool out_of_memory = false;
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) ordered num_threads(n_threads)
+#endif
     for (int well = 0; well < n_wells; well++) {
-      valid_index[well] = false;
       std::string well_file_name = input_files->getWellFile(well);
 
+      // Written to std::vector<bool> in the ordered part, as neighbouring
+      // elements share storage.
+      bool                     is_valid            = false;
+      bool                     has_facies_log      = false;
+      bool                     has_synthetic_vs    = false;
+
+      std::string              well_err_text;
+      std::vector<std::string> well_tasks;
+      NRLib::Well            * base_well           = NULL;
+      bool                     logs_processed      = false;
+      int                      well_no_hit         = 0;
+      int                      well_empty          = 0;
+      int                      well_facies_not_ok  = 0;
+      int                      well_upwards        = 0;
+
+      std::vector<int>         cur_facies_nr;
+      std::vector<std::string> cur_facies_names;
+
+      bool                     well_out_of_memory  = false;
+
+      LogKit::StartThreadBuffering();
+
       int format = -1;
       try {
-        NRLib::Well * base_well = NRLib::Well::ReadWell(well_file_name, format);
+        base_well = NRLib::Well::ReadWell(well_file_name, format);
         NRLib::Well & new_well  = *base_well; //Convenience-variable.
         LogKit::LogFormatted(LogKit::Low, new_well.GetWellName()+" : \n");
 
-        std::vector<int>         cur_facies_nr;
-        std::vector<std::string> cur_facies_names;
-
         //Process logs. Start by finding current log names and settings.
         std::vector<std::string> well_log_names = model_settings->getWellLogNames(well);
         std::vector<bool> well_inverse_velocity = model_settings->getWellInverseVelocity(well);
@@ -1212,16 +1245,14 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
         }
 
         ProcessLogsGeneralWell(new_well, well_log_names, well_position_log_names, well_inverse_velocity, well_relative_coord, facies_log_given, porosity_log_given, format, tmp_err_text);
-        err_text += tmp_err_text;
+        well_err_text += tmp_err_text;
         if (tmp_err_text == "") {
+          logs_processed = true;
           //Store facies names.
           if (model_settings->getFaciesLogGiven()) {
             ReadFaciesNamesFromWellLogs(new_well, cur_facies_nr, cur_facies_names);
           }
 
-          facies_nr_wells.push_back(cur_facies_nr);
-          facies_names_wells.push_back(cur_facies_names);
-
           new_well.SetUseForFaciesProbabilities(model_settings->getIndicatorFacies(well));
           new_well.SetUseForFiltering(model_settings->getIndicatorFilter(well));
           new_well.SetRealVsLog(model_settings->getIndicatorRealVs(well));
@@ -1235,14 +1266,14 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
 
           if (CheckWellAgainstSimbox(full_inversion_simbox, new_well) == 1) {
             well_valid = false;
-            no_hit++;
-            TaskList::addTask("Consider increasing the inversion volume such that well "+new_well.GetWellName()+ " can be included");
+            well_no_hit++;
+            well_tasks.push_back("Consider increasing the inversion volume such that well "+new_well.GetWellName()+ " can be included");
           }
           if (new_well.GetNData() == 0) {
             LogKit::LogFormatted(LogKit::Low,"  IGNORED (no log entries found)\n");
             well_valid = false;
-            empty++;
-            TaskList::addTask("Check the log entries in well "+new_well.GetWellName()+".");
+            well_empty++;
+            well_tasks.push_back("Check the log entries in well "+new_well.GetWellName()+".");
           }
           //Check well for valid facies
           bool facies_log_in_well;
@@ -1272,23 +1303,23 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
           if (facies_ok == false) {
             LogKit::LogFormatted(LogKit::Low,"   IGNORED (facies log has wrong entries)\n");
             well_valid = false;
-            facies_log_not_ok++;
-            TaskList::addTask("Check the facies logs in well "+new_well.GetWellName()+".\n       The facies logs in this well are wrong and the well is ignored");
+            well_facies_not_ok++;
+            well_tasks.push_back("Check the facies logs in well "+new_well.GetWellName()+".\n       The facies logs in this well are wrong and the well is ignored");
           }
           bool monotonous = RemoveDuplicateLogEntriesFromWell(new_well, model_settings, full_inversion_simbox, n_merges[well]);
           if (monotonous == false) {
             LogKit::LogFormatted(LogKit::Low,"   IGNORED (well is too far from monotonous in time)\n");
             well_valid = false;
-            upwards++;
-            TaskList::addTask("Check the TWT log in well "+new_well.GetWellName()+".\n       The well is moving too much upwards, and the well is ignored");
+            well_upwards++;
+            well_tasks.push_back("Check the TWT log in well "+new_well.GetWellName()+".\n       The well is moving too much upwards, and the well is ignored");
           }
 
           well_names[well]            = new_well.GetWellName();
-          well_synthetic_vs_log[well] = new_well.HasSyntheticVsLog();
+          has_synthetic_vs            = new_well.HasSyntheticVsLog();
 
           if (well_valid == true) {
 
-            valid_index[well] = true;
+            is_valid = true;
             SetWrongLogEntriesInWellUndefined(new_well, model_settings, n_invalid_vp[well], n_invalid_vs[well], n_invalid_rho[well]);
             FilterLogs(new_well, model_settings);
             LookForSyntheticVsLog(new_well, model_settings, rank_corr[well]);
@@ -1297,18 +1328,53 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
             if (n_facies > 0)
               CountFaciesInWell(new_well, full_inversion_simbox, n_facies, cur_facies_nr, facies_count[well]);
 
-            wells.push_back(base_well);
-            facies_log_wells[well] = facies_log_in_well;
+            has_facies_log = facies_log_in_well;
           }
         }
       }
       catch (NRLib::Exception & e) {
-        err_text += e.what();
-        valid_index[well] = false;
+        well_err_text += e.what();
+        is_valid = false;
+      }
+      catch (std::bad_alloc &) {
+        well_out_of_memory = true;
+        is_valid           = false;
+      }
+      catch (std::exception & e) {
+        well_err_text += e.what();
+        is_valid = false;
       }
 
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
+      {
+        LogKit::EndThreadBuffering();
+        if (well_out_of_memory)
+          out_of_memory = true;
+        valid_index[well]           = is_valid;
+        well_synthetic_vs_log[well] = has_synthetic_vs;
+        if (is_valid)
+          facies_log_wells[well] = has_facies_log;
+        for (size_t t = 0; t < well_tasks.size(); t++)
+          TaskList::addTask(well_tasks[t]);
+        err_text          += well_err_text;
+        no_hit            += well_no_hit;
+        empty             += well_empty;
+        facies_log_not_ok += well_facies_not_ok;
+        upwards           += well_upwards;
+        if (logs_processed) {
+          facies_nr_wells.push_back(cur_facies_nr);
+          facies_names_wells.push_back(cur_facies_names);
+        }
+        if (valid_index[well])
+          wells.push_back(base_well);
+      }
     } //n_wells
 
+    if (out_of_memory)
+      throw std::bad_alloc();
+
     //Combines facies information from wells
     if (model_settings->getFaciesLogGiven() && err_text == "")
       SetFaciesNamesFromWells(model_settings, facies_nr_wells, facies_names_wells, facies_nr, facies_names, err_text);
@@ -3063,6 +3129,10 @@ bool CommonData::WaveletHandling(ModelSettings                               * m
             }
           }
 
+          int n_threads = 1;
+#ifdef PARALLEL
+          n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
           double v0=model_settings->getAverageVelocity();
           ComputeStructureDepthGradient(v0,
                                         model_settings->getGradientSmoothingRange(),
@@ -3071,13 +3141,15 @@ bool CommonData::WaveletHandling(ModelSettings                               * m
                                         full_inversion_simbox,
                                         estimation_simbox,
                                         structure_depth_grad_x,
-                                        structure_depth_grad_y);
+                                        structure_depth_grad_y,
+                                        n_threads);
           Wavelet3D::setGradientMaps(structure_depth_grad_x,
                                      structure_depth_grad_y);
           ComputeReferenceTimeGradient(&t0_surf,
                                        estimation_simbox,
                                        ref_time_grad_x,
-                                       ref_time_grad_y);
+                                       ref_time_grad_y,
+                                       n_threads);
         }
         else {
           err_text += "Problems reading reference time surface in (x,y).\n";
@@ -3086,16 +3158,36 @@ bool CommonData::WaveletHandling(ModelSettings                               * m
       bool estimate_well_gradient = model_settings->getEstimateWellGradientFromSeismic();
       float distance, sigma_m;
       model_settings->getTimeGradientSettings(distance, sigma_m, i);
-      std::vector<std::vector<double> > SigmaXY;
 
-      for (size_t w = 0; w < n_wells; w++) {
-        if (!estimate_well_gradient & ((structure_depth_grad_x.GetN()> 0) & (structure_depth_grad_y.GetN()>0))) {
-          double v0=model_settings->getAverageVelocity();
-          mapped_blocked_logs.find(wells_[w]->GetWellName())->second->SetSeismicGradient(v0, structure_depth_grad_x, structure_depth_grad_y, ref_time_grad_x_, ref_time_grad_y_, t_grad_x[w], t_grad_y[w]);
+#ifdef PARALLEL
+      int n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+
+      if (!estimate_well_gradient & ((structure_depth_grad_x.GetN()> 0) & (structure_depth_grad_y.GetN()>0))) {
+        double v0=model_settings->getAverageVelocity();
+        for (int w = 0; w < static_cast<int>(n_wells); w++) {
+          BlockedLogsCommon * blocked_log = mapped_blocked_logs.find(wells_[w]->GetWellName())->second;
+          blocked_log->SetSeismicGradient(v0, structure_depth_grad_x, structure_depth_grad_y, ref_time_grad_x_, ref_time_grad_y_, t_grad_x[w], t_grad_y[w]);
         }
-        else {
-          mapped_blocked_logs.find(wells_[w]->GetWellName())->second->SetTimeGradientSettings(distance, sigma_m);
-          mapped_blocked_logs.find(wells_[w]->GetWellName())->second->FindSeismicGradient(seismic_data[i], &estimation_simbox, n_angles, t_grad_x[w], t_grad_y[w], SigmaXY);
+      }
+      else {
+        // Wells close to each other search the same seismic columns, so the traces
+        // are read once, one angle stack at a time, and shared between the wells.
+        std::vector<int> columns;
+        for (int w = 0; w < static_cast<int>(n_wells); w++)
+          mapped_blocked_logs.find(wells_[w]->GetWellName())->second->FindSeismicGradientColumns(&estimation_simbox, columns);
+
+        SeismicTraceCache trace_cache(seismic_data[i], &estimation_simbox, columns);
+
+        // Each well is independent.
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+        for (int w = 0; w < static_cast<int>(n_wells); w++) {
+          BlockedLogsCommon * blocked_log = mapped_blocked_logs.find(wells_[w]->GetWellName())->second;
+          std::vector<std::vector<double> > SigmaXY;
+          blocked_log->SetTimeGradientSettings(distance, sigma_m);
+          blocked_log->FindSeismicGradient(trace_cache, &estimation_simbox, n_angles, t_grad_x[w], t_grad_y[w], SigmaXY);
         }
       }
     }
@@ -3656,7 +3748,8 @@ CommonData::ComputeStructureDepthGradient(double                 v0,
                                           const Simbox         & full_inversion_simbox,
                                           const Simbox         & estimation_simbox,
                                           NRLib::Grid2D<float> & structure_depth_grad_x,
-                                          NRLib::Grid2D<float> & structure_depth_grad_y) const
+                                          NRLib::Grid2D<float> & structure_depth_grad_y,
+                                          int                    n_threads) const
  {
    double ds = 12.5;
 
@@ -3666,28 +3759,36 @@ CommonData::ComputeStructureDepthGradient(double                 v0,
    structure_depth_grad_y.Resize(nx,ny);
    double mp=v0*0.001*0.5; // 0.001 is due to s vs ms convension
 
+   NRLib::Grid2D<double> t0_grad_x;
+   NRLib::Grid2D<double> t0_grad_y;
+   NRLib::Grid2D<double> top_grad_x;
+   NRLib::Grid2D<double> top_grad_y;
+   NRLib::Grid2D<double> bot_grad_x;
+   NRLib::Grid2D<double> bot_grad_y;
+
+   CalculateSmoothGrad(t0_surf, estimation_simbox, radius, ds, t0_grad_x, t0_grad_y, n_threads);
+   if (correlation_direction != NULL) {
+     CalculateSmoothGrad(correlation_direction, estimation_simbox, radius, ds, top_grad_x, top_grad_y, n_threads);
+   }
+   else {
+     CalculateSmoothGrad(&(dynamic_cast<const Surface &> (full_inversion_simbox.GetTopSurface())), estimation_simbox, radius, ds, top_grad_x, top_grad_y, n_threads);
+     CalculateSmoothGrad(&(dynamic_cast<const Surface &> (full_inversion_simbox.GetBotSurface())), estimation_simbox, radius, ds, bot_grad_x, bot_grad_y, n_threads);
+   }
+
    for (int i = 0; i < nx; i++) {
      for (int j = 0; j < ny; j++) {
-       double x,y;
-       double gx,gy,gxTmp,gyTmp;
-       gx=0.0;
-       gy=0.0;
-       estimation_simbox.getXYCoord(i,j,x,y);
-       CalculateSmoothGrad(t0_surf, x, y, radius, ds,gxTmp, gyTmp);
-       gx=-gxTmp;
-       gy=-gyTmp;
+       double gx,gy;
+       gx=-t0_grad_x(i,j);
+       gy=-t0_grad_y(i,j);
        if (correlation_direction != NULL) {
-         CalculateSmoothGrad(correlation_direction, x, y, radius, ds,gxTmp, gyTmp);
-         gx+=gxTmp;
-         gy+=gyTmp;
+         gx+=top_grad_x(i,j);
+         gy+=top_grad_y(i,j);
        }
        else {
-         CalculateSmoothGrad( &(dynamic_cast<const Surface &> (full_inversion_simbox.GetTopSurface())), x, y, radius, ds,gxTmp, gyTmp);
-         gx+=gxTmp*0.5;
-         gy+=gyTmp*0.5;
-         CalculateSmoothGrad( &(dynamic_cast<const Surface &> (full_inversion_simbox.GetBotSurface())), x, y, radius, ds,gxTmp, gyTmp);
-         gx+=gxTmp*0.5;
-         gy+=gyTmp*0.5;
+         gx+=top_grad_x(i,j)*0.5;
+         gy+=top_grad_y(i,j)*0.5;
+         gx+=bot_grad_x(i,j)*0.5;
+         gy+=bot_grad_y(i,j)*0.5;
        }
 
        gx*=mp;
@@ -3700,87 +3801,254 @@ CommonData::ComputeStructureDepthGradient(double                 v0,
 
 
 void
-CommonData::CalculateSmoothGrad(const Surface * surf, double x, double y, double radius, double ds, double& gx, double& gy) const
+CommonData::CalculateSmoothGrad(const Surface         * surf,
+                                const Simbox          & simbox,
+                                double                  radius,
+                                double                  ds,
+                                NRLib::Grid2D<double> & grad_x,
+                                NRLib::Grid2D<double> & grad_y,
+                                int                     n_threads) const
 {
-  /// Return smoothed Gradient. Computes the gradient as a regression
-  /// among points within a given distance from the central point.
-  // Returns missing if central point is outside the grid.
-  /// Returns otherwise it is ok,
-  int i,j,k,l;
-  int disc_radius = int(floor(radius/ds));
-  int n_points = (2*disc_radius+1)*(2*disc_radius+1);
-  std::vector<double> Z(3*n_points,0.0);
-  std::vector<double> Y(n_points,0.0);
-  std::vector<double> cov(9,0.0);
-  std::vector<double> invCov(9,0.0);
-  std::vector<double> proj(3,0.0);
-  double z0 = 0.0;
-  int    cy = 0;
-  int    cz = 0;
-
-  double baseDepth =surf->GetZ(x,y);
-
-  for (i=- disc_radius; i <= disc_radius; i++) {
-    for (j=- disc_radius; j <= disc_radius; j++) {
-      double dx= i*ds;
-      double dy= j*ds;
-      double foo=surf->GetZ(x+dx,y+dy);
-      Y[cy] = foo;
-      Z[cz] = 1.0;
-      Z[cz + 1] = dx;
-      Z[cz + 2] = dy;
-      cy++;
-      cz += 3;
-    }
-  }
-
-  int nData=0;
-  for (i = 0; i < n_points; i++) {
-    if (!surf->IsMissing(Y[i])) {
-      nData++;
-      for (k=0; k < 3; k++) {
-        for (l=0;l<3;l++)
-          cov[k+l*3]+=Z[k + 3*i] * Z[l + 3*i];
-
-        proj[k]+=Z[k + 3*i]*(Y[i]-baseDepth);
+  /// Return smoothed gradient in every (i,j) column of simbox. The gradient
+  /// is found by fitting a plane to the surface values in a (2r+1)x(2r+1)
+  /// window with spacing ds around the column. Missing surface values are
+  /// left out of the fit, and RMISSING is returned where no plane can be found.
+  ///
+  /// The windows are centred on the nodes of an axis-aligned lattice with
+  /// spacing ds, and the gradient in a column is interpolated bilinearly from
+  /// the four closest nodes. The lattice is handled in tiles. Each tile samples
+  /// the surface around itself and builds summed-area tables of the masked
+  /// moments, which give the normal equations of every window in the tile in
+  /// constant time. Only tiles holding columns are visited, and the moments are
+  /// taken in tile coordinates, so the sums stay small.
+  int nx = simbox.getnx();
+  int ny = simbox.getny();
+  int r  = int(floor(radius/ds));
+
+  grad_x.Resize(nx, ny, RMISSING);
+  grad_y.Resize(nx, ny, RMISSING);
+
+  double x_min =  std::numeric_limits<double>::max();
+  double x_max = -std::numeric_limits<double>::max();
+  double y_min =  std::numeric_limits<double>::max();
+  double y_max = -std::numeric_limits<double>::max();
+  for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+      double x, y;
+      simbox.getXYCoord(i, j, x, y);
+      x_min = std::min(x_min, x);
+      x_max = std::max(x_max, x);
+      y_min = std::min(y_min, y);
+      y_max = std::max(y_max, y);
+    }
+  }
+
+  // Lattice node (a,b) lies at (x_min + a*ds, y_min + b*ds). A tile owns
+  // tile_size x tile_size nodes, and its columns also need the first node
+  // of the next tile in each direction.
+  const int tile_size = 64;
+  int na       = static_cast<int>(floor((x_max - x_min)/ds)) + 1;
+  int nb       = static_cast<int>(floor((y_max - y_min)/ds)) + 1;
+  int n_tile_a = (na + tile_size - 1)/tile_size;
+  int n_tile_b = (nb + tile_size - 1)/tile_size;
+
+  std::vector<std::vector<int> > tile_columns(n_tile_a*n_tile_b);
+  for (int j = 0; j < ny; j++) {
+    for (int i = 0; i < nx; i++) {
+      double x, y;
+      simbox.getXYCoord(i, j, x, y);
+      int a0 = std::min(static_cast<int>(floor((x - x_min)/ds)), na - 1);
+      int b0 = std::min(static_cast<int>(floor((y - y_min)/ds)), nb - 1);
+      tile_columns[a0/tile_size + (b0/tile_size)*n_tile_a].push_back(i + j*nx);
+    }
+  }
+
+  std::vector<int> tiles;
+  for (int tile = 0; tile < n_tile_a*n_tile_b; tile++) {
+    if (tile_columns[tile].size() > 0)
+      tiles.push_back(tile);
+  }
+  int n_tiles = static_cast<int>(tiles.size());
+
+  const int n_mom   = 9;
+  int       n_nodes = tile_size + 1;        // Nodes evaluated per tile and direction
+  int       n_samp  = n_nodes + 2*r;        // Surface samples per tile and direction
+  int       ns      = n_samp + 1;           // Summed-area table size per direction
+
+#ifdef PARALLEL
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (int t = 0; t < n_tiles; t++) {
+    int tile    = tiles[t];
+    int a_first = (tile % n_tile_a)*tile_size;
+    int b_first = (tile / n_tile_a)*tile_size;
+
+    // Sample l in the tile is lattice node a_first - r + l
+    std::vector<double> z(n_samp*n_samp);
+    std::vector<char>   present(n_samp*n_samp);
+    double z_ref     = 0.0;
+    int    n_present = 0;
+    for (int lb = 0; lb < n_samp; lb++) {
+      for (int la = 0; la < n_samp; la++) {
+        int m      = la + lb*n_samp;
+        z[m]       = surf->GetZ(x_min + (a_first - r + la)*ds, y_min + (b_first - r + lb)*ds);
+        present[m] = !surf->IsMissing(z[m]);
+        if (present[m]) {
+          z_ref += z[m];
+          n_present++;
+        }
+      }
+    }
+    if (n_present == 0)
+      continue;
+
+    // Values are taken relative to their mean to keep the sums accurate.
+    // This does not change the fitted gradient.
+    z_ref /= n_present;
+
+    // Summed-area tables of n, a, b, a^2, b^2, ab, z, az, bz over present values,
+    // stored with the nine moments next to each other.
+    std::vector<double> sat(n_mom*ns*ns, 0.0);
+    for (int lb = 0; lb < n_samp; lb++) {
+      double row[n_mom] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+      for (int la = 0; la < n_samp; la++) {
+        int m = la + lb*n_samp;
+        if (present[m]) {
+          double zz = z[m] - z_ref;
+          row[0] += 1.0;
+          row[1] += la;
+          row[2] += lb;
+          row[3] += double(la)*la;
+          row[4] += double(lb)*lb;
+          row[5] += double(la)*lb;
+          row[6] += zz;
+          row[7] += la*zz;
+          row[8] += lb*zz;
+        }
+        double       * cur  = &sat[n_mom*((la + 1) + (lb + 1)*ns)];
+        const double * prev = &sat[n_mom*((la + 1) + lb*ns)];
+        for (int k = 0; k < n_mom; k++)
+          cur[k] = prev[k] + row[k];
+      }
+    }
+
+    // The window of node l spans samples l to l + 2r
+    std::vector<double> node_gx(n_nodes*n_nodes);
+    std::vector<double> node_gy(n_nodes*n_nodes);
+    std::vector<char>   node_ok(n_nodes*n_nodes);
+    double window_sum[n_mom];
+    for (int lb = 0; lb < n_nodes; lb++) {
+      for (int la = 0; la < n_nodes; la++) {
+        const double * s11 = &sat[n_mom*((la + 2*r + 1) + (lb + 2*r + 1)*ns)];
+        const double * s01 = &sat[n_mom*( la            + (lb + 2*r + 1)*ns)];
+        const double * s10 = &sat[n_mom*((la + 2*r + 1) +  lb*ns)];
+        const double * s00 = &sat[n_mom*( la            +  lb*ns)];
+        for (int k = 0; k < n_mom; k++)
+          window_sum[k] = s11[k] - s01[k] - s10[k] + s00[k];
+
+        int m      = la + lb*n_nodes;
+        node_ok[m] = CalculatePlaneGradient(window_sum, la + r, lb + r, ds, node_gx[m], node_gy[m]);
+      }
+    }
+
+    const std::vector<int> & columns = tile_columns[tile];
+    for (size_t c = 0; c < columns.size(); c++) {
+      int    i = columns[c] % nx;
+      int    j = columns[c] / nx;
+      double x, y;
+      simbox.getXYCoord(i, j, x, y);
+
+      double u  = (x - x_min)/ds;
+      double v  = (y - y_min)/ds;
+      int    a0 = std::min(static_cast<int>(floor(u)), na - 1);
+      int    b0 = std::min(static_cast<int>(floor(v)), nb - 1);
+      double wa = u - a0;
+      double wb = v - b0;
+
+      double w_sum  = 0.0;
+      double gx_sum = 0.0;
+      double gy_sum = 0.0;
+      for (int da = 0; da < 2; da++) {
+        for (int db = 0; db < 2; db++) {
+          int m = (a0 - a_first + da) + (b0 - b_first + db)*n_nodes;
+          if (node_ok[m]) {
+            double w = (da == 0 ? 1.0 - wa : wa) * (db == 0 ? 1.0 - wb : wb);
+            w_sum  += w;
+            gx_sum += w*node_gx[m];
+            gy_sum += w*node_gy[m];
+          }
+        }
+      }
+
+      if (w_sum > 0.0) {
+        grad_x(i, j) = gx_sum/w_sum;
+        grad_y(i, j) = gy_sum/w_sum;
       }
     }
   }
+}
+
+bool
+CommonData::CalculatePlaneGradient(const double * window_sum,
+                                   int            a,
+                                   int            b,
+                                   double         ds,
+                                   double       & gx,
+                                   double       & gy) const
+{
+  // Normal equations of the plane fit for the window around lattice node (a,b),
+  // with coordinates relative to the node. window_sum holds the sums of
+  // n, a, b, a^2, b^2, ab, z, az, bz over the present values in the window.
+  double n  = window_sum[0];
+  double sa = window_sum[1] - a*n;
+  double sb = window_sum[2] - b*n;
+
+  std::vector<double> cov(9, 0.0);
+  std::vector<double> invCov(9, 0.0);
+  std::vector<double> proj(3, 0.0);
+
+  cov[0] = n;
+  cov[1] = sa*ds;
+  cov[2] = sb*ds;
+  cov[3] = cov[1];
+  cov[4] = (window_sum[3] - 2.0*a*window_sum[1] + double(a)*a*n)*ds*ds;
+  cov[5] = (window_sum[5] - a*window_sum[2] - b*window_sum[1] + double(a)*b*n)*ds*ds;
+  cov[6] = cov[2];
+  cov[7] = cov[5];
+  cov[8] = (window_sum[4] - 2.0*b*window_sum[2] + double(b)*b*n)*ds*ds;
+
+  proj[0] = window_sum[6];
+  proj[1] = (window_sum[7] - a*window_sum[6])*ds;
+  proj[2] = (window_sum[8] - b*window_sum[6])*ds;
 
   double det = cov[0]*(cov[4]*cov[8] - cov[5]*cov[7]) - cov[1]*(cov[3]*cov[8] - cov[5]*cov[6])
                   + cov[2]*(cov[3]*cov[7] - cov[4]*cov[6]);
 
   if (det != 0) {
-      invCov[0] = (cov[4]*cov[8] - cov[5]*cov[7]) / det;
-      invCov[1] = (cov[2]*cov[7] - cov[1]*cov[8]) / det;
-      invCov[2] = (cov[1]*cov[5] - cov[2]*cov[4]) / det;
-      invCov[3] = (cov[5]*cov[6] - cov[3]*cov[8]) / det;
-      invCov[4] = (cov[0]*cov[8] - cov[2]*cov[6]) / det;
-      invCov[5] = (cov[2]*cov[3] - cov[0]*cov[5]) / det;
-      invCov[6] = (cov[3]*cov[7] - cov[4]*cov[6]) / det;
-      invCov[7] = (cov[1]*cov[6] - cov[0]*cov[7]) / det;
-      invCov[8] = (cov[0]*cov[4] - cov[1]*cov[3]) / det;
-
-      z0 = baseDepth;
-      gx = 0.0;
-      gy = 0.0;
-      for (k=0; k < 3; k++) {
-        z0 += invCov[k]*proj[k]; //NBNB check
-        gx += invCov[3+k]*proj[k];
-        gy += invCov[6+k]*proj[k];
-      }
-  }
-  else {
-   gx = RMISSING;
-   gy = RMISSING;
+    invCov[3] = (cov[5]*cov[6] - cov[3]*cov[8]) / det;
+    invCov[4] = (cov[0]*cov[8] - cov[2]*cov[6]) / det;
+    invCov[5] = (cov[2]*cov[3] - cov[0]*cov[5]) / det;
+    invCov[6] = (cov[3]*cov[7] - cov[4]*cov[6]) / det;
+    invCov[7] = (cov[1]*cov[6] - cov[0]*cov[7]) / det;
+    invCov[8] = (cov[0]*cov[4] - cov[1]*cov[3]) / det;
+
+    gx = 0.0;
+    gy = 0.0;
+    for (int k=0; k < 3; k++) {
+      gx += invCov[3+k]*proj[k];
+      gy += invCov[6+k]*proj[k];
+    }
+    return true;
   }
+  return false;
 }
 
 void
 CommonData::ComputeReferenceTimeGradient(const Surface        * t0_surf,
                                          const Simbox         & estimation_simbox,
                                          NRLib::Grid2D<float> & ref_time_grad_x,
-                                         NRLib::Grid2D<float> & ref_time_grad_y) const
+                                         NRLib::Grid2D<float> & ref_time_grad_y,
+                                         int                    n_threads) const
  {
    double radius = 50.0;
    double ds     = 12.5;
@@ -3788,14 +4056,15 @@ CommonData::ComputeReferenceTimeGradient(const Surface        * t0_surf,
    int ny        = estimation_simbox.getny();
    ref_time_grad_x.Resize(nx,ny);
    ref_time_grad_y.Resize(nx,ny);
+
+   NRLib::Grid2D<double> gx;
+   NRLib::Grid2D<double> gy;
+   CalculateSmoothGrad(t0_surf, estimation_simbox, radius, ds, gx, gy, n_threads);
+
    for (int i = 0; i < nx; i++) {
      for (int j = 0; j < ny; j++) {
-       double x,y;
-       double gx,gy;
-       estimation_simbox.getXYCoord(i,j,x,y);
-       CalculateSmoothGrad(t0_surf, x, y, radius, ds,gx, gy);
-       ref_time_grad_x(i,j) =float(gx);
-       ref_time_grad_y(i,j) =float(gy);
+       ref_time_grad_x(i,j) =float(gx(i,j));
+       ref_time_grad_y(i,j) =float(gy(i,j));
      }
    }
  }
@@ -4478,17 +4747,57 @@ bool CommonData::BlockWellsForEstimation(const ModelSettings
       LogKit::LogFormatted(LogKit::Low,"\nBlocking wells in the outer estimation simbox:\n");
     else
       LogKit::LogFormatted(LogKit::Low,"\nBlocking wells in output simbox:\n");
-    for (unsigned int i = 0; i < wells.size(); i++) {
-      bool is_inside = true;
-      BlockedLogsCommon * blocked_log = new BlockedLogsCommon(wells[i], continuous_logs_to_be_blocked, discrete_logs_to_be_blocked,
-                                                              &estimation_simbox, model_settings->getRunFromPanel(), false, is_inside, err_text);
+#ifdef PARALLEL
+    int n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+    int n_wells = static_cast<int>(wells.size());
 
-      if (is_inside == false)
-        err_text += "Well "+wells[i]->GetWellName()+" was not found within the estimation simbox surrounding the inversion intervals.\n";
+    // Wells are blocked in parallel. Messages and results are passed on in well order.
+    bool out_of_memory = false;
 
-      mapped_blocked_logs_common.insert(std::pair<std::string, BlockedLogsCommon *>(wells[i]->GetWellName(), blocked_log));
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) ordered num_threads(n_threads)
+#endif
+    for (int i = 0; i < n_wells; i++) {
+      bool        is_inside          = true;
+      bool        well_out_of_memory = false;
+      std::string well_err_text;
 
+      BlockedLogsCommon * blocked_log = NULL;
+
+      LogKit::StartThreadBuffering();
+      try {
+        blocked_log = new BlockedLogsCommon(wells[i], continuous_logs_to_be_blocked, discrete_logs_to_be_blocked,
+                                            &estimation_simbox, model_settings->getRunFromPanel(), false, is_inside, well_err_text);
+
+        if (is_inside == false)
+          well_err_text += "Well "+wells[i]->GetWellName()+" was not found within the estimation simbox surrounding the inversion intervals.\n";
+      }
+      catch(NRLib::Exception & e) {
+        well_err_text += e.what();
+      }
+      catch(std::bad_alloc &) {
+        well_out_of_memory = true;
+      }
+      catch(std::exception & e) {
+        well_err_text += e.what();
+      }
+
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
+      {
+        LogKit::EndThreadBuffering();
+        if (well_out_of_memory)
+          out_of_memory = true;
+        err_text += well_err_text;
+        if (blocked_log != NULL)
+          mapped_blocked_logs_common.insert(std::pair<std::string, BlockedLogsCommon *>(wells[i]->GetWellName(), blocked_log));
+      }
     }
+
+    if (out_of_memory)
+      throw std::bad_alloc();
   }
   catch(NRLib::Exception & e) {
     err_text += e.what();
@@ -4572,6 +4881,11 @@ CommonData::BlockLogsForInversion(const ModelSettings
       LogKit::WriteHeader("Blocking wells for inversion");
   }
   std::string err_text = "";
+
+#ifdef PARALLEL
+  int n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+
   try {
     if (n_intervals > 1)
       LogKit::LogFormatted(LogKit::Low,"\nBlocking wells in each interval simbox:\n");
@@ -4582,30 +4896,68 @@ CommonData::BlockLogsForInversion(const ModelSettings
       if (interval_name != "")
         LogKit::LogFormatted(LogKit::Low,"\nFor interval " + interval_name + " :\n");
 
-      int n_intervals_inside = 0;
-      for (size_t j = 0; j < wells.size(); j++) {
+      int  n_intervals_inside = 0;
+      int  n_wells            = static_cast<int>(wells.size());
+      bool out_of_memory      = false;
 
-        bool is_inside = true;
-        BlockedLogsCommon * bl_tmp = new BlockedLogsCommon(wells[j], continuous_logs_to_be_blocked, discrete_logs_to_be_blocked, multiple_interval_grid->GetIntervalSimbox(i),
-                                                           model_settings->getRunFromPanel(), false, is_inside, err_text);
+      // Wells are blocked in parallel. Messages and results are passed on in well order.
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) ordered num_threads(n_threads)
+#endif
+      for (int j = 0; j < n_wells; j++) {
 
+        bool        is_inside          = true;
+        bool        well_out_of_memory = false;
+        std::string well_err_text;
 
-        if (is_inside == true) {
-          blocked_log_interval.insert(std::pair<std::string, BlockedLogsCommon *>(wells[j]->GetWellName(), bl_tmp));
-          n_intervals_inside++;
-        }
-        else {
-          if (n_intervals > 1) {
-            LogKit::LogFormatted(LogKit::Low,"\nWell " + wells[j]->GetWellName() + " is not inside simbox for interval " + interval_name + ". This well is not used for inversion for this interval.\n");
-          }
-          else {
-            LogKit::LogFormatted(LogKit::Low,"\nBlocking wells failed: well " + wells[j]->GetWellName() + " is not inside the simbox.");
-            err_text += "Well " + wells[j]->GetWellName() + " was not found within the estimation simbox surrounding the inversion intervals.\n";
+        BlockedLogsCommon * bl_tmp = NULL;
+
+        LogKit::StartThreadBuffering();
+        try {
+          bl_tmp = new BlockedLogsCommon(wells[j], continuous_logs_to_be_blocked, discrete_logs_to_be_blocked, multiple_interval_grid->GetIntervalSimbox(i),
+                                         model_settings->getRunFromPanel(), false, is_inside, well_err_text);
+
+          if (is_inside == false) {
+            if (n_intervals > 1) {
+              LogKit::LogFormatted(LogKit::Low,"\nWell " + wells[j]->GetWellName() + " is not inside simbox for interval " + interval_name + ". This well is not used for inversion for this interval.\n");
+            }
+            else {
+              LogKit::LogFormatted(LogKit::Low,"\nBlocking wells failed: well " + wells[j]->GetWellName() + " is not inside the simbox.");
+              well_err_text += "Well " + wells[j]->GetWellName() + " was not found within the estimation simbox surrounding the inversion intervals.\n";
+            }
           }
         }
+        catch (NRLib::Exception & e) {
+          well_err_text += e.what();
+          is_inside = false;
+        }
+        catch (std::bad_alloc &) {
+          well_out_of_memory = true;
+          is_inside          = false;
+        }
+        catch (std::exception & e) {
+          well_err_text += e.what();
+          is_inside = false;
+        }
 
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
+        {
+          LogKit::EndThreadBuffering();
+          if (well_out_of_memory)
+            out_of_memory = true;
+          err_text += well_err_text;
+          if (is_inside == true) {
+            blocked_log_interval.insert(std::pair<std::string, BlockedLogsCommon *>(wells[j]->GetWellName(), bl_tmp));
+            n_intervals_inside++;
+          }
+        }
       }
 
+      if (out_of_memory)
+        throw std::bad_alloc();
+
       if (wells.size() > 0 && n_intervals_inside == 0) {
           LogKit::LogFormatted(LogKit::Low,"\nBlocking wells for interval " + interval_name + " failed: No wells inside the simbox.\n");
           err_text += "No wells was inside interval simbox for interval " + interval_name + ".\n";
@@ -7004,7 +7356,11 @@ bool CommonData::SetupDepthConversion(ModelSettings * model_settings,
   if (err_text == "") {
     bool failed_dummy = false;
 
-    time_depth_mapping = new GridMapping();
+    int n_threads = 1;
+#ifdef PARALLEL
+    n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+    time_depth_mapping = new GridMapping(n_threads);
 
     std::string base_depth_surface = "";
     if (input_files->getBaseDepthSurfaces().find("") != input_files->getBaseDepthSurfaces().end())
@@ -226,8 +226,16 @@ public:
     //
     // Transform to Fourier domain
     //
-    rfftwnd_plan p1 = rfftwnd_create_plan(1, &nt, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
+    rfftwnd_plan p1;
+    // FFTW plan creation and destruction are not thread safe
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+    p1 = rfftwnd_create_plan(1, &nt, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
     rfftwnd_one_real_to_complex(p1, rAmp, cAmp);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
     fftwnd_destroy_plan(p1);
 
     //for (int i=0 ; i<cnt ; i++) {
@@ -265,8 +273,15 @@ public:
     //
     // Backtransform to time domain
     //
-    rfftwnd_plan p2 = rfftwnd_create_plan(1, &nt, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
+    rfftwnd_plan p2;
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+    p2 = rfftwnd_create_plan(1, &nt, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
     rfftwnd_one_complex_to_real(p2, cAmp, rAmp);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
     fftwnd_destroy_plan(p2);
 
     float scale= float(1.0/nt);
@@ -693,14 +708,29 @@ private:
                                                    const Simbox         & full_inversion_simbox,
                                                    const Simbox         & estimation_simbox,
                                                    NRLib::Grid2D<float> & structure_depth_grad_x,
-                                                   NRLib::Grid2D<float> & structure_depth_grad_y) const;
+                                                   NRLib::Grid2D<float> & structure_depth_grad_y,
+                                                   int                    n_threads) const;
 
   void               ComputeReferenceTimeGradient(const Surface        * t0_surf,
                                                   const Simbox         & estimation_simbox,
                                                   NRLib::Grid2D<float> & ref_time_grad_x,
-                                                  NRLib::Grid2D<float> & ref_time_grad_y) const;
-
-  void               CalculateSmoothGrad(const Surface * surf, double x, double y, double radius, double ds,  double& gx, double& gy) const;
+                                                  NRLib::Grid2D<float> & ref_time_grad_y,
+                                                  int                    n_threads) const;
+
+  void               CalculateSmoothGrad(const Surface         * surf,
+                                         const Simbox          & simbox,
+                                         double                  radius,
+                                         double                  ds,
+                                         NRLib::Grid2D<double> & grad_x,
+                                         NRLib::Grid2D<double> & grad_y,
+                                         int                     n_threads) const;
+
+  bool               CalculatePlaneGradient(const double * window_sum,
+                                            int            a,
+                                            int            b,
+                                            double         ds,
+                                            double       & gx,
+                                            double       & gy) const;
 
 
   void               ResampleSurfaceToGrid2D(const Surface * surface,
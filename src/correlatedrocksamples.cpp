@@ -1,10 +1,15 @@
 #include "src/correlatedrocksamples.h"
 
 #include "rplib/rock.h"
+#include "nrlib/random/random.hpp"
+#include "nrlib/exception/exception.hpp"
 #include <nrlib/flens/nrlib_flens.hpp>
 
+#include <algorithm>
 
-CorrelatedRockSamples::CorrelatedRockSamples()
+
+CorrelatedRockSamples::CorrelatedRockSamples(int n_threads)
+: n_threads_(std::max(n_threads, 1))
 {
 }
 
@@ -17,61 +22,8 @@ CorrelatedRockSamples::CreateSamples(int
                                      TimeLine                                      & time_line,
                                      const std::vector<DistributionsRock *>        & dist_rock)
 {
-  std::list<int> time;
-  time_line.GetAllTimes(time);
-  int k_max = static_cast<int>(dist_rock.size() );
-
-  // Set up time vectors, the same for all sets of correlated samples.
-  time_line.ReSet();
-  int et_dummy, edi_dummy;
-  double dt;
-  std::vector< std::vector<double> > delta_time(k_max);
-  for (int k = 0; k < k_max; ++k){
-    time_line.GetNextEvent(et_dummy, edi_dummy, dt);// dt in days
-    for (int l = k; l < k_max; ++l)
-      delta_time[l].push_back(dt); // dt in years
-  }
-
-  // Set up data structures.
-  // The order of indices is chosen to make extraction of all samples for a given time instance easy.
-  std::vector< std::vector< std::vector<double> > > m(k_max);
-  std::vector< std::vector< Rock * > > rock(k_max);
-  for (int k = 0; k < k_max; ++k){
-    m[k].resize(i_max);
-    rock[k].resize(i_max);
-    for (int i = 0; i < i_max; ++i)
-      m[k][i].resize(3);
-  }
-
-  const std::vector<double> trend_params_dummy(2,0);
-  // Finding the sets of correlated samples.
-  // Each set of samples for a specific i are correlated in time.
-  dist_rock[0]->SetResamplingLevel(DistributionWithTrend::Full);
-  for (int i = 0; i < i_max; ++i){
-    rock[0][i] = dist_rock[0]->GenerateSample(trend_params_dummy);
-    rock[0][i]->GetSeismicParams(m[0][i][0], m[0][i][1], m[0][i][2]);
-    m[0][i][0]=std::log(m[0][i][0]);
-    m[0][i][1]=std::log(m[0][i][1]);
-    m[0][i][2]=std::log(m[0][i][2]);
-    std::vector< Rock * > rock_seen(1, rock[0][i]);
-    for (int k = 1; k < k_max; ++k){
-      dist_rock[k]->SetResamplingLevel(DistributionWithTrend::Full);
-      rock[k][i] = dist_rock[k]->EvolveSample(delta_time[k][k], *(rock[k-1][i])); // delta_time info also for the rock to be found.
-      rock[k][i]->GetSeismicParams(m[k][i][0], m[k][i][1], m[k][i][2]);
-      m[k][i][0]=std::log(m[k][i][0]);
-      m[k][i][1]=std::log(m[k][i][1]);
-      m[k][i][2]=std::log(m[k][i][2]);
-      rock_seen.push_back(rock[k][i]);
-    }
-  }
-
-  // Must delete memory allocated by classes DistributionsRock and Rock.
-  for (int k = 0; k < k_max; ++k){
-    for (int i = 0; i < i_max; ++i){
-      if (rock[k][i] != NULL)
-        delete rock[k][i];
-    }
-  }
+  std::vector< std::vector< std::vector<double> > > m;
+  SampleCorrelatedSets(m, i_max, time_line, dist_rock, false);
   return m;
 }
 
@@ -82,72 +34,105 @@ std::vector< std::vector< std::vector<double> > >
 CorrelatedRockSamples::CreateSamplesExtended(int                                      i_max,
                                              TimeLine                               & time_line,
                                              const std::vector<DistributionsRock*>  & dist_rock)
+{
+  std::vector< std::vector< std::vector<double> > > m;
+  SampleCorrelatedSets(m, i_max, time_line, dist_rock, true);
+  return m;
+}
+
+
+void
+CorrelatedRockSamples::SampleCorrelatedSets(std::vector< std::vector< std::vector<double> > > & m,
+                                            int                                                 i_max,
+                                            TimeLine                                          & time_line,
+                                            const std::vector<DistributionsRock*>             & dist_rock,
+                                            bool                                                extended) const
 {
   std::list<int> time;
   time_line.GetAllTimes(time);
   int k_max = static_cast<int>(dist_rock.size());
 
-  // Set up time vectors, the same for all sets of correlated samples.
+  // Set up time steps, the same for all sets of correlated samples.
   time_line.ReSet();
   int et_dummy, edi_dummy;
-  double dt_year;
-  std::vector< std::vector<double> > delta_time(k_max);
-  for (int k = 0; k < k_max; ++k){
-    time_line.GetNextEvent(et_dummy, edi_dummy, dt_year);
-    for (int l = k; l < k_max; ++l)
-      delta_time[l].push_back(dt_year);
-  }
+  std::vector<double> delta_time(k_max);
+  for (int k = 0; k < k_max; ++k)
+    time_line.GetNextEvent(et_dummy, edi_dummy, delta_time[k]); // dt in years
 
-  int nReservoirVariables =  dist_rock[0]->GetNumberOfReservoirVariables();
+  int nReservoirVariables = 0;
+  if (extended)
+    nReservoirVariables = dist_rock[0]->GetNumberOfReservoirVariables();
 
   // Set up data structures.
   // The order of indices is chosen to make extraction of all samples for a given time instance easy.
-  std::vector< std::vector< std::vector<double> > > m(k_max);
-  std::vector< std::vector< Rock * > > rock(k_max);
-  for (int k = 0; k < k_max; ++k){
-    m[k].resize(i_max);
-    rock[k].resize(i_max);
-    for (int i = 0; i < i_max; ++i)
-      m[k][i].resize(3+nReservoirVariables);
-  }
+  m.resize(k_max);
+  for (int k = 0; k < k_max; ++k)
+    m[k].assign(i_max, std::vector<double>(3 + nReservoirVariables));
+
+  for (int k = 0; k < k_max; ++k)
+    dist_rock[k]->SetResamplingLevel(DistributionWithTrend::Full);
+
+  // Each set of samples gets its own random stream, so the result does not depend on how sets are shared among threads.
+  unsigned long seed = NRLib::Random::DrawUint32();
+
+  std::string errTxt = "";
 
   const std::vector<double> trend_params_dummy(2,0);
-  std::vector<double>reservoirVariables(nReservoirVariables,0);
   // Finding the sets of correlated samples.
   // Each set of samples for a specific i are correlated in time.
-  dist_rock[0]->SetResamplingLevel(DistributionWithTrend::Full);
-  for (int i = 0; i < i_max; ++i){
-    rock[0][i] = dist_rock[0]->GenerateSampleAndReservoirVariables(trend_params_dummy,reservoirVariables);
-    rock[0][i]->GetSeismicParams(m[0][i][0], m[0][i][1], m[0][i][2]);
-    m[0][i][0]=std::log(m[0][i][0]);
-    m[0][i][1]=std::log(m[0][i][1]);
-    m[0][i][2]=std::log(m[0][i][2]);
-    for(int l =0;l< nReservoirVariables;l++)
-        m[0][i][l+3]=reservoirVariables[l];
-
-    std::vector< Rock * > rock_seen(1, rock[0][i]);
-    for (int k = 1; k < k_max; ++k){
-      dist_rock[k]->SetResamplingLevel(DistributionWithTrend::Full);
-      rock[k][i] = dist_rock[k]->EvolveSampleAndReservoirVaribles(delta_time[k][k], *(rock[k-1][i]),reservoirVariables); // delta_time info also for the rock to be found.
-      rock[k][i]->GetSeismicParams(m[k][i][0], m[k][i][1], m[k][i][2]);
-      m[k][i][0]=std::log(m[k][i][0]);
-      m[k][i][1]=std::log(m[k][i][1]);
-      m[k][i][2]=std::log(m[k][i][2]);
-      for(int l =0;l< nReservoirVariables;l++)
-        m[k][i][l+3]=reservoirVariables[l];
-      rock_seen.push_back(rock[k][i]);
+  // Only the rock of the previous time step is needed to evolve a sample, so older rocks are released at once.
+#ifdef PARALLEL
+  int n_threads = std::min(n_threads_, DistributionWithTrend::GetMaxSampleThreads());
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    dsfmt_t             stream;
+    std::vector<double> reservoirVariables(nReservoirVariables, 0);
+    NRLib::Random::SetThreadStream(&stream);
+
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 64)
+#endif
+    for (int i = 0; i < i_max; ++i) {
+      Rock * rock = NULL;
+      try {
+        NRLib::Random::InitializeStream(&stream, seed, i);
+        for (int k = 0; k < k_max; ++k) {
+          Rock * new_rock;
+          if (k == 0 && extended)
+            new_rock = dist_rock[0]->GenerateSampleAndReservoirVariables(trend_params_dummy, reservoirVariables);
+          else if (k == 0)
+            new_rock = dist_rock[0]->GenerateSample(trend_params_dummy);
+          else if (extended)
+            new_rock = dist_rock[k]->EvolveSampleAndReservoirVaribles(delta_time[k], *rock, reservoirVariables); // delta_time info also for the rock to be found.
+          else
+            new_rock = dist_rock[k]->EvolveSample(delta_time[k], *rock);
+
+          // Must delete memory allocated by classes DistributionsRock and Rock.
+          delete rock;
+          rock = new_rock;
+
+          std::vector<double> & m_ki = m[k][i];
+          rock->GetSeismicParams(m_ki[0], m_ki[1], m_ki[2]);
+          m_ki[0] = std::log(m_ki[0]);
+          m_ki[1] = std::log(m_ki[1]);
+          m_ki[2] = std::log(m_ki[2]);
+          for (int l = 0; l < nReservoirVariables; l++)
+            m_ki[l+3] = reservoirVariables[l];
+        }
+      }
+      catch (NRLib::Exception & e) {
+#ifdef PARALLEL
+#pragma omp critical (correlated_rock_samples)
+#endif
+        errTxt = e.what();
+      }
+      delete rock;
     }
-  }
 
-  // Must delete memory allocated by classes DistributionsRock and Rock.
-  for (int k = 0; k < k_max; ++k){
-    for (int i = 0; i < i_max; ++i){
-      if (rock[k][i] != NULL)
-        delete rock[k][i];
-    }
+    NRLib::Random::SetThreadStream(NULL);
   }
 
-  return m;
+  if (errTxt != "")
+    throw NRLib::Exception(errTxt);
 }
-
-
@@ -9,11 +9,15 @@
 // I = number of samples per time step.
 // Each sample is a 3-dim vector [vp, vs, rho].
 // Each set of samples for a specific i in [0:I-1] are correlated in time.
+//
+// The sets are independent and may be generated by several threads. Set i
+// draws from its own random stream, seeded from the global generator and i,
+// so the result for a given seed does not depend on the number of threads.
 
 class CorrelatedRockSamples {
 public:
 
-  CorrelatedRockSamples();
+  CorrelatedRockSamples(int n_threads = 1);
 
   ~CorrelatedRockSamples();
 
@@ -24,6 +28,17 @@ public:
   std::vector< std::vector< std::vector<double> > > CreateSamplesExtended(int                                     i_max,
                                                                           TimeLine                              & time_line,
                                                                           const std::vector<DistributionsRock*> & dist_rock);
+
+private:
+  // Fills m[k][i] for all time steps k. If extended, the reservoir variables
+  // of each sample are appended after [vp, vs, rho].
+  void SampleCorrelatedSets(std::vector< std::vector< std::vector<double> > > & m,
+                            int                                                 i_max,
+                            TimeLine                                          & time_line,
+                            const std::vector<DistributionsRock*>             & dist_rock,
+                            bool                                                extended) const;
+
+  int n_threads_;
 };
 
 #endif
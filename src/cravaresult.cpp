@@ -9,6 +9,10 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
 #include "src/cravaresult.h"
 #include "src/multiintervalgrid.h"
 #include "src/blockedlogscommon.h"
@@ -2264,63 +2268,162 @@ void CravaResult::ComputeSyntSeismic(const ModelSettings          * model_settin
 {
   //LogKit::WriteHeader("Compute Synthetic Seismic and Residuals");
 
-  int nx = static_cast<int>(vp->GetNI());
-  int ny = static_cast<int>(vp->GetNJ());
-  int nz = static_cast<int>(vp->GetNK());
+  int nx   = static_cast<int>(vp->GetNI());
+  int ny   = static_cast<int>(vp->GetNJ());
+  int nz   = static_cast<int>(vp->GetNK());
 
-  int nzp = simbox->GetNZpad();
+  int nzp  = simbox->GetNZpad();
+  int cnzp = nzp/2 + 1;
+  int rnzp = 2*cnzp;
 
   std::vector<float> angles = model_settings->getAngle(0); //Synt seismic only for first vintage
   int n_theta = static_cast<int>(angles.size());
 
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+
+  //
+  // All traces share one pair of FFT plans. FFTW_THREADSAFE makes the plans
+  // read-only, so they can be executed by several threads at once.
+  //
+  rfftwnd_plan fft_plan  = rfftwnd_create_plan(1, &nzp, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
+  rfftwnd_plan ifft_plan = rfftwnd_create_plan(1, &nzp, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
+
+  std::vector<SyntSeismicWorkspace> workspace(n_threads);
+  for (int t = 0; t < n_threads; t++) {
+    workspace[t].trace    = static_cast<fftw_real *>(fftw_malloc(rnzp*sizeof(fftw_real)));
+    workspace[t].spectrum.resize(cnzp);
+  }
+
   for (int l = 0; l < n_theta; l++) {
     StormContGrid * imp = ComputeSeismicImpedance(vp, vs, rho, reflection_matrix_, l);
 
-    for (int i = 0; i <nx; i++) {
-      for (int j = 0; j < ny; j++) {
-        Wavelet1D impVec(0, nz, nzp);
-        //impVec.setupAsVector();
-        int k;
-        for (k = 0; k < nz; k++) {
-          float value = imp->GetValue(i, j, k);
-          impVec.setRAmp(value, k);
+    //
+    // A 1D wavelet only varies laterally through the local shift and gain, so
+    // each thread keeps its own copy of the global wavelet spectrum. A 3D
+    // wavelet depends on the local dip and must be made for each trace.
+    //
+    bool        dip_dependent  = (wavelets[l]->getDim() == Wavelet::THREE_D);
+    Wavelet1D * global_wavelet = NULL;
+    if (!dip_dependent) {
+      global_wavelet = new Wavelet1D(wavelets[l]);
+      global_wavelet->fft1DInPlace();
+    }
+    for (int t = 0; t < n_threads; t++) {
+      workspace[t].local_wavelet = NULL;
+      if (!dip_dependent) {
+        workspace[t].local_wavelet = new Wavelet1D(wavelets[l]);
+        workspace[t].local_wavelet->fft1DInPlace();
+      }
+      workspace[t].shift = 0.0f;
+      workspace[t].gain  = 1.0f;
+      workspace[t].sf    = RMISSING;
+    }
+
+    //
+    // Each row of traces is one block. Neighbouring traces in a row usually
+    // share stretch, shift and gain, in which case the stretched wavelet
+    // spectrum of the previous trace is reused.
+    //
+#ifdef PARALLEL
+    int chunk_size = 1;
+#pragma omp parallel for schedule(dynamic, chunk_size) num_threads(n_threads)
+#endif
+    for (int j = 0; j < ny; j++) {
+      int thread = 0;
+#ifdef PARALLEL
+      thread = omp_get_thread_num();
+#endif
+      SyntSeismicWorkspace & ws = workspace[thread];
+
+      for (int i = 0; i < nx; i++) {
+        float sf;
+        bool  new_spectrum = false;
+
+        if (dip_dependent) {
+          Wavelet1D * local_wavelet;
+#ifdef PARALLEL
+#pragma omp critical (synt_seismic_local_wavelet)
+#endif
+          {
+            local_wavelet = wavelets[l]->createLocalWavelet1D(i, j);
+            sf            = static_cast<float>(simbox->getRelThick(i, j))*wavelets[l]->getLocalStretch(i, j);
+          }
+          for (int k = 0; k < cnzp; k++)
+            ws.spectrum[k] = local_wavelet->getCAmp(k, sf); // returns complex conjugate
+          delete local_wavelet;
         }
-        //Tapering:
-        float fac = 1.0f/static_cast<float>(nzp-nz-1);
-        for (; k < nzp; k++) {
-          float value = fac*((k-nz)*impVec.getRAmp(0)+(nzp-k-1)*impVec.getRAmp(nz-1));
-          impVec.setRAmp(value, k);
+        else {
+          float shift = wavelets[l]->getLocalTimeshift(i, j);
+          float gain  = wavelets[l]->getLocalGainFactor(i, j);
+          sf          = static_cast<float>(simbox->getRelThick(i, j))*wavelets[l]->getLocalStretch(i, j);
+
+          if (shift != ws.shift || gain != ws.gain) {
+            for (int k = 0; k < cnzp; k++)
+              ws.local_wavelet->setCAmp(global_wavelet->getCAmp(k), k);
+            ws.local_wavelet->shiftAndScale(shift, gain);
+            ws.shift     = shift;
+            ws.gain      = gain;
+            new_spectrum = true;
+          }
+          if (new_spectrum || sf != ws.sf) {
+            for (int k = 0; k < cnzp; k++)
+              ws.spectrum[k] = ws.local_wavelet->getCAmp(k, sf); // returns complex conjugate
+            ws.sf = sf;
+          }
         }
-        Wavelet1D resultVec(&impVec, Wavelet::FIRSTORDERBACKWARDDIFF);
-        resultVec.fft1DInPlace();
-
-        Wavelet1D * localWavelet = wavelets[l]->createLocalWavelet1D(i,j);
 
-        float sf = static_cast<float>(simbox->getRelThick(i, j))*wavelets[l]->getLocalStretch(i,j);
+        fftw_real * trace = ws.trace;
+        int k;
+        for (k = 0; k < nz; k++)
+          trace[k] = (*imp)(i, j, k);
 
-        for (int k = 0; k <(nzp/2 +1); k++) {
-          fftw_complex r = resultVec.getCAmp(k);
-          fftw_complex w = localWavelet->getCAmp(k,static_cast<float>(sf));// returns complex conjugate
-          fftw_complex s;
-          s.re = r.re*w.re+r.im*w.im; //Use complex conjugate of w
-          s.im = -r.re*w.im+r.im*w.re;
-          resultVec.setCAmp(s,k);
+        //Tapering:
+        float fac = 1.0f/static_cast<float>(nzp-nz-1);
+        for (; k < nzp; k++)
+          trace[k] = fac*((k-nz)*trace[0]+(nzp-k-1)*trace[nz-1]);
+
+        //First order backward difference, done in place from the end of the trace
+        fftw_real last = trace[nzp-1];
+        for (k = nzp-1; k > 0; k--)
+          trace[k] -= trace[k-1];
+        trace[0] -= last;
+
+        fftw_complex * c_trace = reinterpret_cast<fftw_complex *>(trace);
+        rfftwnd_one_real_to_complex(fft_plan, trace, c_trace);
+
+        for (k = 0; k < cnzp; k++) {
+          fftw_complex r = c_trace[k];
+          fftw_complex w = ws.spectrum[k];
+          c_trace[k].re = r.re*w.re+r.im*w.im; //Use complex conjugate of w
+          c_trace[k].im = -r.re*w.im+r.im*w.re;
         }
-        delete localWavelet;
 
-        resultVec.invFFT1DInPlace();
-        for (int k = 0; k < nz; k++) { //nzp
-          float value = resultVec.getRAmp(k);
-          imp->SetValue(i, j, k, value);
-        }
+        rfftwnd_one_complex_to_real(ifft_plan, c_trace, trace);
+
+        double scale = static_cast<double>(1.0/static_cast<double>(nzp));
+        for (k = 0; k < nz; k++)
+          (*imp)(i, j, k) = static_cast<fftw_real>(trace[k]*scale);
       }
     }
 
+    for (int t = 0; t < n_threads; t++)
+      delete workspace[t].local_wavelet;
+    delete global_wavelet;
+
     if (((model_settings->getOutputGridsSeismic() & IO::SYNTHETIC_SEISMIC_DATA) > 0) ||
       (model_settings->getForwardModeling() == true))
       synt_seismic_data.push_back(imp);
-
+    else
+      delete imp;
   }
+
+  for (int t = 0; t < n_threads; t++)
+    fftw_free(workspace[t].trace);
+  fftwnd_destroy_plan(fft_plan);
+  fftwnd_destroy_plan(ifft_plan);
 }
 
 StormContGrid *
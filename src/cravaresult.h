@@ -212,6 +212,15 @@ public:
   void SetBgBlockedLogs(const std::map<std::string, BlockedLogsCommon *> & bg_blocked_logs) { bg_blocked_logs_ = bg_blocked_logs ;}
 
 private:
+  struct SyntSeismicWorkspace {            // Per-thread buffers for ComputeSyntSeismic
+    fftw_real                 * trace;
+    std::vector<fftw_complex>   spectrum;      // Stretched local wavelet spectrum
+    Wavelet1D                 * local_wavelet; // Global 1D wavelet with current shift and gain
+    float                       shift;
+    float                       gain;
+    float                       sf;
+  };
+
   void CombineVerticalTrends(MultiIntervalGrid                         * multiple_interval_grid,
                              CommonData                                * common_data,
                              const NRLib::Grid2D<std::vector<double> > & vertical_trend,
@@ -1,4 +1,11 @@
 #include <time.h>
+#include <algorithm>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
+#include "nrlib/iotools/logkit.hpp"
 
 #include "src/avoinversion.h"
 #include "src/traveltimeinversion.h"
@@ -15,10 +22,117 @@
 #include "src/seismicparametersholder.h"
 #include "src/simbox.h"
 #include "src/gravimetricinversion.h"
+#include "src/commondata.h"
+#include "src/multiintervalgrid.h"
 
 #include "src/doinversion.h"
 
 
+std::vector<std::vector<int> > scheduleIntervals(const ModelSettings * modelSettings,
+                                                 CommonData          * commonData)
+{
+  // Groups consecutive intervals into batches whose prior models are set up
+  // concurrently. A batch holds at most one interval per thread, and the prior
+  // grids of its intervals must fit within the memory limit. An interval that
+  // exceeds the limit on its own forms a batch of one.
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
+  double max_memory  = 1024.0*1024.0*modelSettings->getMaxIntervalMemory();
+  int    n_intervals = commonData->GetMultipleIntervalGrid()->GetNIntervals();
+  int    n_grids     = 3;  // Background
+  if (!modelSettings->getForwardModeling())
+    n_grids += 6;          // Covariances and cross-covariances
+
+  std::vector<std::vector<int> > batches;
+  std::vector<int>               batch;
+  double                         batch_memory = 0.0;
+
+  for (int i_interval = 0; i_interval < n_intervals; i_interval++) {
+    const Simbox * simbox = commonData->GetMultipleIntervalGrid()->GetIntervalSimbox(i_interval);
+    double rsize  = 2.0*(simbox->GetNXpad()/2 + 1)*simbox->GetNYpad()*simbox->GetNZpad();
+    double memory = n_grids*rsize*sizeof(fftw_real);
+
+    bool full = static_cast<int>(batch.size()) == n_threads
+             || (max_memory > 0.0 && batch_memory + memory > max_memory);
+    if (batch.size() > 0 && full) {
+      batches.push_back(batch);
+      batch.clear();
+      batch_memory = 0.0;
+    }
+    batch.push_back(i_interval);
+    batch_memory += memory;
+  }
+  if (batch.size() > 0)
+    batches.push_back(batch);
+
+  return(batches);
+}
+
+void setupPriorModels(std::vector<SeismicParametersHolder> & seismicParametersIntervals,
+                      const ModelSettings                  * modelSettings,
+                      CommonData                           * commonData,
+                      const std::vector<int>               & intervals)
+{
+  // Sets up background and correlation grids for a batch of intervals. The
+  // intervals have independent simboxes and grids, so each one is handled by
+  // its own thread. Only data already held by commonData is read here.
+  // Messages are held per interval and logged in interval order.
+  int n_batch = static_cast<int>(intervals.size());
+
+#ifdef PARALLEL
+  int n_threads  = std::max(modelSettings->getNumberOfThreads(), 1);
+  int chunk_size = 1;
+#pragma omp parallel for schedule(dynamic, chunk_size) ordered num_threads(n_threads)
+#endif
+  for (int b = 0; b < n_batch; b++) {
+    int            i_interval = intervals[b];
+    const Simbox * simbox     = commonData->GetMultipleIntervalGrid()->GetIntervalSimbox(i_interval);
+
+    LogKit::StartThreadBuffering();
+
+    //Expectationsgrids. NRLib::Grid to FFTGrid, fills in padding
+    seismicParametersIntervals[i_interval].setBackgroundParametersInterval(commonData->GetBackgroundParametersInterval(i_interval),
+                                                                           simbox->GetNXpad(),
+                                                                           simbox->GetNYpad(),
+                                                                           simbox->GetNZpad());
+
+    if (!modelSettings->getForwardModeling()) {
+      float corr_grad_I = 0.0f;
+      float corr_grad_J = 0.0f;
+      commonData->GetCorrGradIJ(corr_grad_I, corr_grad_J, simbox);
+
+      float dt        = static_cast<float>(simbox->getdz());
+      float low_cut   = modelSettings->getLowCut();
+      int low_int_cut = int(floor(low_cut*(simbox->GetNZpad()*0.001*dt))); // computes the integer which corresponds to the low cut frequency.
+
+      seismicParametersIntervals[i_interval].setCorrelationParameters(commonData->GetPriorCovEst(),
+                                                                      commonData->GetPriorParamCov(i_interval),
+                                                                      commonData->GetPriorAutoCov(i_interval),
+                                                                      commonData->GetPriorCorrT(i_interval),
+                                                                      commonData->GetPriorCorrXY(i_interval),
+                                                                      low_int_cut,
+                                                                      corr_grad_I,
+                                                                      corr_grad_J,
+                                                                      simbox->getnx(),
+                                                                      simbox->getny(),
+                                                                      simbox->getnz(),
+                                                                      simbox->GetNXpad(),
+                                                                      simbox->GetNYpad(),
+                                                                      simbox->GetNZpad(),
+                                                                      simbox->getdz());
+    }
+
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
+    {
+      LogKit::EndThreadBuffering();
+    }
+  }
+}
+
 void setupStaticModels(ModelGeneral            *& modelGeneral,
                        ModelAVOStatic          *& modelAVOstatic,
                        //ModelGravityStatic      *& modelGravityStatic,
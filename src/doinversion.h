@@ -2,6 +2,7 @@
 #define DOINVERSION_H
 
 #include <stdio.h>
+#include <vector>
 
 class ModelSettings;
 class ModelAVODynamic;
@@ -12,6 +13,15 @@ class ModelGeneral;
 class InputFiles;
 class Simbox;
 class SeismicParametersHolder;
+class CommonData;
+
+std::vector<std::vector<int> > scheduleIntervals(const ModelSettings * modelSettings,
+                                                 CommonData          * commonData);
+
+void setupPriorModels(std::vector<SeismicParametersHolder> & seismicParametersIntervals,
+                      const ModelSettings                  * modelSettings,
+                      CommonData                           * commonData,
+                      const std::vector<int>               & intervals);
 
 void setupStaticModels(ModelGeneral            *& modelGeneral,
                        ModelAVOStatic          *& modelAVOstatic,
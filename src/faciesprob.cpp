@@ -119,6 +119,11 @@ FaciesProb::FaciesProb(FFTGrid                                            * vp,
   std::vector<std::vector<PosteriorElasticPDF *> > posteriorPdf;
   bool faciesProbFromRockPhysics = modelSettings->getFaciesProbFromRockPhysics();
 
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
+
   if(!faciesProbFromRockPhysics){
     const std::vector<NRLib::Matrix>  & sigmaEOrig = filteredRealLogs->getSigmae();
     densdim = static_cast<int>(sigmaEOrig.size());
@@ -167,7 +172,8 @@ FaciesProb::FaciesProb(FFTGrid                                            * vp,
 
 
   CalculateFaciesProbFromPosteriorElasticPDF(vp, vs, rho, posteriorPdf, volume, nDimensions,
-                      p_undef, priorFacies, priorFaciesCubes, noiseScale, seismicLH, faciesProbFromRockPhysics, trend_cubes);
+                      p_undef, priorFacies, priorFaciesCubes, noiseScale, seismicLH, faciesProbFromRockPhysics, trend_cubes,
+                      n_threads);
 
   for(int i = 0 ; i < densdim ; i++) {
     for(int j = 0 ; j < nFacies_ ; j++)
@@ -218,34 +224,22 @@ FaciesProb::makeFaciesHistAndSetPriorProb(const std::vector<double> & vp,
                                           const std::vector<double> & vs,
                                           const std::vector<double> & rho,
                                           const std::vector<int>    & faciesLog,
-                                          const Simbox              * volume)
+                                          const Simbox              * volume,
+                                          int                         n_threads)
 {
   std::vector<FFTGrid *> hist;
   hist.resize(nFacies_, NULL);
   int i,j,k,l;
-  int rnxp;
   int nx, ny, nz;
   nx = volume->getnx();
   ny = volume->getny();
   nz = volume->getnz();
-  for(i=0;i<nFacies_;i++)
-  {
-    hist[i] = new FFTGrid(nx, ny, nz, nx , ny, nz);
-    hist[i]->createRealGrid(false);
-    rnxp = hist[i]->getRNxp();
-    hist[i]->setType(FFTGrid::PARAMETER);
-    hist[i]->setAccessMode(FFTGrid::WRITE);
-    for(l=0;l<nz;l++)
-    {
-      for(k=0;k<ny;k++)
-      {
-        for(j=0;j<rnxp;j++)
-          hist[i]->setNextReal(0.0f);
-      }
-    }
-    hist[i]->endAccess();
-  }
 
+  //
+  // Count the samples in one plain array per facies. Samples outside the
+  // volume have missing indexes and are not counted.
+  //
+  std::vector<std::vector<float> > count(nFacies_);
   std::vector<int> nData(nFacies_,0);
 
   int facies;
@@ -256,29 +250,37 @@ FaciesProb::makeFaciesHistAndSetPriorProb(const std::vector<double> & vp,
       volume->getIndexes(vp[i], vs[i], rho[i], j, k, l);
       facies = faciesLog[i];
       nData[facies]++;
-      hist[facies]->setAccessMode(FFTGrid::RANDOMACCESS);
-      float value = hist[facies]->getRealValue(j, k, l) + 1.0f;
-      hist[facies]->setRealValue(j,k,l,value);
-      hist[facies]->endAccess();
+      if(j != IMISSING && k != IMISSING && l != IMISSING) {
+        if(count[facies].empty())
+          count[facies].resize(nx*ny*nz, 0.0f);
+        count[facies][j + k*nx + l*nx*ny] += 1.0f;
+      }
     }
   }
 
-  for(i=0;i<nFacies_;i++)
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for(int f=0;f<nFacies_;f++)
   {
-    hist[i]->setAccessMode(FFTGrid::READANDWRITE);
-    rnxp = hist[i]->getRNxp();
-    double nf = 1.0/double(nData[i]);
-    for(l=0;l<nz;l++)
+    hist[f] = new FFTGrid(nx, ny, nz, nx , ny, nz);
+    hist[f]->createRealGrid(false);
+    int rnxp = hist[f]->getRNxp();
+    hist[f]->setType(FFTGrid::PARAMETER);
+    hist[f]->setAccessMode(FFTGrid::WRITE);
+    double nf = 1.0/double(nData[f]);
+    for(int ll=0;ll<nz;ll++)
     {
-      for(k=0;k<ny;k++)
+      for(int kk=0;kk<ny;kk++)
       {
-        for(j=0;j<rnxp;j++) {
-          double value = static_cast<double>(hist[i]->getNextReal())*nf;
-          hist[i]->setNextReal(static_cast<float>(value));
+        for(int jj=0;jj<rnxp;jj++) {
+          float  n     = (jj < nx && !count[f].empty()) ? count[f][jj + kk*nx + ll*nx*ny] : 0.0f;
+          double value = static_cast<double>(n)*nf;
+          hist[f]->setNextReal(static_cast<float>(value));
         }
       }
     }
-    hist[i]->endAccess();
+    hist[f]->endAccess();
   }
   return hist;
 }
@@ -296,7 +298,8 @@ void FaciesProb::makeFaciesDens(int                                nfac,
                                 int                                index,
                                 NRLib::Matrix                    & G,
                                 AVOInversion                     * avoInversionResult,
-                                const std::vector<Grid2D *>      & noiseScale)
+                                const std::vector<Grid2D *>      & noiseScale,
+                                int                                n_threads)
 {
   //Note: If noVs is true, the vs dimension is mainly dummy. Due to the lookup mechanism that maps
   //      values outside the denisty table to the edge, any values should do in this dimension.
@@ -440,7 +443,7 @@ void FaciesProb::makeFaciesDens(int                                nfac,
   //Associate vp with x, vs with y and rho with z.
   *volume  = new Simbox(vpMin, vsMin, rhoMinSurf, vpMax-vpMin, vsMax-vsMin, rhoMax-rhoMin, 0, dVp, dVs, dRho);
 
-  density = makeFaciesHistAndSetPriorProb(vpFilteredNew, vsFilteredNew, rhoFilteredNew, faciesLog, *volume);
+  density = makeFaciesHistAndSetPriorProb(vpFilteredNew, vsFilteredNew, rhoFilteredNew, faciesLog, *volume, n_threads);
 
   float *smooth = new float[nbinsa*nbinsb*nbinsr];
 
@@ -507,6 +510,10 @@ void FaciesProb::makeFaciesDens(int                                nfac,
 
   smoother->fftInPlace();
 
+  // The transformed smoother is shared, and only read, by all facies
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
   for (int i=0 ; i < nFacies_ ; i++)
   {
     if (ModelSettings::getDebugLevel() >= 1)
@@ -855,10 +862,20 @@ int FaciesProb::MakePosteriorElasticPDFRockPhysics(std::vector<std::vector<Poste
 
 
 
+#ifdef PARALLEL
+  int n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
+
   if(nDimensions == 3){
+    // All facies use the same grid and smoothing kernel, so the kernel is transformed once
+    FFTGrid * smoother = PosteriorElasticPDF3D::MakeSmoother3D(sigmae, nBinsX, nBinsY, nBinsZ, xMin, xMax, yMin, yMax, zMin, zMax);
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
     for(int j=0; j<nFacies_; j++)
       posteriorPdf[0][j] = new PosteriorElasticPDF3D(vp_matrix[j], vs_matrix[j], rho_matrix[j],
-        sigmae, nBinsX, nBinsY, nBinsZ, xMin, xMax, yMin, yMax, zMin, zMax,j);
+        sigmae, nBinsX, nBinsY, nBinsZ, xMin, xMax, yMin, yMax, zMin, zMax, j, smoother);
+    delete smoother;
   }else if(nDimensions == 4){
     for(int j=0; j<nFacies_; j++){
       posteriorPdf[0][j] = new PosteriorElasticPDF3D(vp_matrix[j], vs_matrix[j], rho_matrix[j], trend1_matrix[j], v,
@@ -944,6 +961,10 @@ int FaciesProb::MakePosteriorElasticPDF3D(std::vector<std::vector<PosteriorElast
 
   avoInversionResult->computeG(G);
 
+#ifdef PARALLEL
+  int n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
+
   //Set the grid temporarily to 100*100*50
   int nbinsa = 100;
   int nbinsb = 100;
@@ -1104,6 +1125,12 @@ int FaciesProb::MakePosteriorElasticPDF3D(std::vector<std::vector<PosteriorElast
     v[2][0] = v[0][2];
     v[2][1] = v[1][2];
 
+    // All facies use the same grid and smoothing kernel, so the kernel is transformed once
+    FFTGrid * smoother = PosteriorElasticPDF3D::MakeSmoother3D(v, nbinsa, nbinsb, nbinsr, vpMin, vpMax, vsMin, vsMax, rhoMin, rhoMax);
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
     for(int j=0; j<nFacies_; j++){
       posteriorPdf3d[i][j] = new PosteriorElasticPDF3D(vp_temp[j],
                                                        vs_temp[j],
@@ -1118,9 +1145,11 @@ int FaciesProb::MakePosteriorElasticPDF3D(std::vector<std::vector<PosteriorElast
                                                        vsMax,
                                                        rhoMin,
                                                        rhoMax,
-                                                       j);
+                                                       j,
+                                                       smoother);
 
     }
+    delete smoother;
 
     for(int j=0;j<3;j++)
       delete [] v[j];
@@ -1198,6 +1227,11 @@ void FaciesProb::makeFaciesProb(int                                        nFac,
   NRLib::Matrix G(nAng, 3);
   avoInversionResult->computeG(G);
 
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
+
   for(int i=0;i<densdim;i++) {
     makeFaciesDens(nFac,
                    sigmaEOrig,
@@ -1212,7 +1246,8 @@ void FaciesProb::makeFaciesProb(int                                        nFac,
                    i,
                    G,
                    avoInversionResult,
-                   noiseScale);
+                   noiseScale,
+                   n_threads);
 
     if(((modelSettings->getOtherOutputFlag() & IO::ROCK_PHYSICS) > 0) && (i == 0 || i == densdim-1)) {
       Simbox * expVol = createExpVol(volume[i]);
@@ -1262,46 +1297,52 @@ void FaciesProb::makeFaciesProb(int                                        nFac,
   }
 }
 
-float FaciesProb::FindDensityFromPosteriorPDF(const double                                           & vp,
-                                              const double                                           & vs,
-                                              const double                                           & rho,
-                                              const double                                           & s1,
-                                              const double                                           & s2,
-                                              const std::vector<std::vector<PosteriorElasticPDF*> >  & posteriorPDF,
-                                              const int                                                facies,
-                                              const std::vector<Simbox *>                            & volume,
-                                              const std::vector<float>                               & t,
-                                              int                                                      nAng,
-                                              bool                                                     faciesProbFromRockPhysics)
+void FaciesProb::FindDensitiesFromPosteriorPDF(const double                                           & vp,
+                                               const double                                           & vs,
+                                               const double                                           & rho,
+                                               const double                                           & s1,
+                                               const double                                           & s2,
+                                               const std::vector<std::vector<PosteriorElasticPDF*> >  & posteriorPDF,
+                                               const std::vector<Simbox *>                            & volume,
+                                               const std::vector<float>                               & t,
+                                               int                                                      nAng,
+                                               bool                                                     faciesProbFromRockPhysics,
+                                               std::vector<double>                                    & pdf_values,
+                                               float                                                  * density) const
 {
+  // The facies densities of one dimension share grid, so they are found together
   int dim = static_cast<int>(posteriorPDF.size());
-  std::vector<float> value(dim);
   for(int i=0;i<dim;i++){
-    value[i] = static_cast<float>(posteriorPDF[i][facies]->FindDensity(vp, vs, rho, s1, s2, volume[i]));
+    posteriorPDF[i][0]->FindDensities(&posteriorPDF[i][0], nFacies_, vp, vs, rho, s1, s2, volume[i],
+                                      &pdf_values[i*nFacies_]);
   }
 
-  int factor = 1;
-  float valuesum = 0;
-  for(int i=0;i<dim;i++)
+  for(int facies=0;facies<nFacies_;facies++)
   {
-    factor = 1;
-    if (!faciesProbFromRockPhysics){
-      for(int j=0;j<nAng;j++){
-        if(j>0)
-          factor*=2;
-        if((i & factor) > 0)
-          value[i]*=t[j];
-        else
-          value[i]*=(1-t[j]);
+    int factor = 1;
+    float valuesum = 0;
+    for(int i=0;i<dim;i++)
+    {
+      float value = static_cast<float>(pdf_values[i*nFacies_ + facies]);
+      factor = 1;
+      if (!faciesProbFromRockPhysics){
+        for(int j=0;j<nAng;j++){
+          if(j>0)
+            factor*=2;
+          if((i & factor) > 0)
+            value*=t[j];
+          else
+            value*=(1-t[j]);
+        }
       }
+      valuesum += value;
     }
-    valuesum += value[i];
-  }
 
-  if (valuesum > 0.0)
-    return(valuesum);
-  else
-    return 0.0;
+    if (valuesum > 0.0)
+      density[facies] = valuesum;
+    else
+      density[facies] = 0.0;
+  }
 }
 
 float FaciesProb::findDensity(float                                       vp,
@@ -2087,15 +2128,14 @@ void FaciesProb::CalculateFaciesProbFromPosteriorElasticPDF(FFTGrid
                                                             const std::vector<Grid2D *>                               & noiseScale,
                                                             FFTGrid                                                   * seismicLH,
                                                             bool                                                        faciesProbFromRockPhysics,
-                                                            CravaTrend                                                & trend_cubes)
+                                                            CravaTrend                                                & trend_cubes,
+                                                            int                                                         n_threads)
 {
   assert (nDimensions == 3 || nDimensions == 4 || nDimensions == 5);
   float * value = new float[nFacies_];
   //int i,j,k,l;
   int nx, ny, nz, rnxp, nyp, nzp, smallrnxp;
-  float vp, vs, rho, sum;
-  float t1 = 0;
-  float t2 = 0;
+  float sum;
 
   rnxp = vpgrid->getRNxp();
   nyp  = vpgrid->getNyp();
@@ -2144,7 +2184,6 @@ void FaciesProb::CalculateFaciesProbFromPosteriorElasticPDF(FFTGrid
   int                  nAng = 0;
   double               maxS;
   double               minS;
-  std::vector<float>   t(noiseScale.size());
   std::vector<Grid2D*> tgrid(noiseScale.size());
 
   if(!faciesProbFromRockPhysics){
@@ -2185,34 +2224,64 @@ void FaciesProb::CalculateFaciesProbFromPosteriorElasticPDF(FFTGrid
     undefSum = p_undefined/(nBinsTrend_*nBinsTrend_*volume[0]->getnx()*volume[0]->getny());
   }
 
+  //
+  // The grids are read and written sequentially one layer at a time, while the
+  // densities of a layer, which is where the time goes, are found row by row in parallel.
+  //
+  std::vector<float> vp_layer(nyp*rnxp);
+  std::vector<float> vs_layer(nyp*rnxp);
+  std::vector<float> rho_layer(nyp*rnxp);
+  std::vector<float> dens_layer(ny*nx*nFacies_);
+
   for(int i=0;i<nzp;i++)
   {
-    for(int j=0;j<nyp;j++)
+    for(int jk=0;jk<nyp*rnxp;jk++)
+    {
+      vp_layer[jk]  = vpgrid->getNextReal();
+      vs_layer[jk]  = vsgrid->getNextReal();
+      rho_layer[jk] = rhogrid->getNextReal();
+    }
+
+    if(i<nz)
     {
-      for(int k=0;k<rnxp;k++)
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+      for(int j=0;j<ny;j++)
       {
-        vp = vpgrid->getNextReal();
-        vs = vsgrid->getNextReal();
-        rho = rhogrid->getNextReal();
-        if(faciesProbFromRockPhysics && nDimensions>3){
-          int ii, jj, kk;
-          ii = std::min(i, trendGridSize[2]-1);
-          jj = std::min(j, trendGridSize[1]-1);
-          kk = std::min(k, trendGridSize[0]-1);
-          std::vector<double> trend_values = trend_cubes.GetTrendPosition(kk,jj,ii);
-          t1 = static_cast<float>(trend_values[0]);
-          t2 = static_cast<float>(trend_values[1]);
+        std::vector<float>  t(noiseScale.size());
+        std::vector<double> pdf_values(posteriorPdf.size()*nFacies_);
+        float t1 = 0;
+        float t2 = 0;
+        for(int k=0;k<nx;k++)
+        {
+          if(faciesProbFromRockPhysics && nDimensions>3){
+            int ii, jj, kk;
+            ii = std::min(i, trendGridSize[2]-1);
+            jj = std::min(j, trendGridSize[1]-1);
+            kk = std::min(k, trendGridSize[0]-1);
+            std::vector<double> trend_values = trend_cubes.GetTrendPosition(kk,jj,ii);
+            t1 = static_cast<float>(trend_values[0]);
+            t2 = static_cast<float>(trend_values[1]);
+          }
+          if(!faciesProbFromRockPhysics){
+            for(int angle = 0; angle<nAng; angle++)
+              t[angle] = float((*tgrid[angle])(k,j));
+          }
+          FindDensitiesFromPosteriorPDF(vp_layer[j*rnxp + k], vs_layer[j*rnxp + k], rho_layer[j*rnxp + k], t1, t2,
+                                        posteriorPdf, volume, t, nAng, faciesProbFromRockPhysics,
+                                        pdf_values, &dens_layer[(j*nx + k)*nFacies_]);
         }
-        if(k<smallrnxp && j<ny && i<nz){
+      }
+
+      for(int j=0;j<ny;j++)
+      {
+        for(int k=0;k<smallrnxp;k++)
+        {
           sum = undefSum;
           for(int l=0;l<nFacies_;l++){
-            if(k<nx){
-              if(!faciesProbFromRockPhysics){
-                for(int angle = 0; angle<nAng; angle++)
-                  t[angle] = float((*tgrid[angle])(k,j));
-              }
-              dens = FindDensityFromPosteriorPDF(vp, vs, rho, t1, t2, posteriorPdf, l, volume, t, nAng, faciesProbFromRockPhysics);
-            }
+            if(k<nx)
+              dens = dens_layer[(j*nx + k)*nFacies_ + l];
             else
               dens = 1.0;
             if(priorFaciesCubes.size() != 0)
@@ -155,7 +155,8 @@ private:
                                                                     const std::vector<Grid2D *>                               & noiseScale,
                                                                     FFTGrid                                                   * seismicLH,
                                                                     bool                                                        faciesProbFromRockPhysics,
-                                                                    CravaTrend                                                & trend_cubes);
+                                                                    CravaTrend                                                & trend_cubes,
+                                                                    int                                                         n_threads);
 
 
   void                   makeFaciesProb(int                                 nFac,
@@ -182,7 +183,8 @@ private:
                                                        const std::vector<double> & vs,
                                                        const std::vector<double> & rho,
                                                        const std::vector<int>   & facies,
-                                                       const Simbox             * volume);
+                                                       const Simbox             * volume,
+                                                       int                        n_threads);
 
   void                   makeFaciesDens(int                                nfac,
                                         const std::vector<NRLib::Matrix> & sigmaEOrig,
@@ -197,7 +199,8 @@ private:
                                         int                                index,
                                         NRLib::Matrix                    & G,
                                         AVOInversion                     * avoInversionResult,
-                                        const std::vector<Grid2D *>      & noiseScale);
+                                        const std::vector<Grid2D *>      & noiseScale,
+                                        int                                n_threads);
 
   void                   setNeededLogsSpatial(std::map<std::string, BlockedLogsCommon *> blocked_wells,
                                               const std::vector<Surface *> & faciesEstimInterval,
@@ -227,17 +230,18 @@ private:
                                      const std::vector<float>                  & t,
                                      int                                         nAng);
 
-  float                  FindDensityFromPosteriorPDF(const double                                          & vp,
-                                                     const double                                          & vs,
-                                                     const double                                          & rho,
-                                                     const double                                          & s1,
-                                                     const double                                          & s2,
-                                                     const std::vector<std::vector<PosteriorElasticPDF*> > & posteriorPDF,
-                                                     const int                                               facies,
-                                                     const std::vector<Simbox *>                           & volume,
-                                                     const std::vector<float>                              & t,
-                                                     int                                                     nAng,
-                                                     bool                                                    faciesProbFromRockPhysics);
+  void                   FindDensitiesFromPosteriorPDF(const double                                          & vp,
+                                                       const double                                          & vs,
+                                                       const double                                          & rho,
+                                                       const double                                          & s1,
+                                                       const double                                          & s2,
+                                                       const std::vector<std::vector<PosteriorElasticPDF*> > & posteriorPDF,
+                                                       const std::vector<Simbox *>                           & volume,
+                                                       const std::vector<float>                              & t,
+                                                       int                                                     nAng,
+                                                       bool                                                    faciesProbFromRockPhysics,
+                                                       std::vector<double>                                   & pdf_values,  // Work space, dim*nFacies_
+                                                       float                                                 * density) const;  // nFacies_ values
 
   void                   resampleAndWriteDensity(const FFTGrid     * const density,
                                                  const std::string & fileName,
@@ -312,13 +312,19 @@ FFTGrid::~FFTGrid()
 {
   if (rvalue_!=NULL)
   {
-    if(add_==true)
-      nGrids_ = nGrids_ - 1;
-
     fftw_free(rvalue_); //delete rvalue_;
 
-    FFTMemUse_ -= rsize_ * sizeof(fftw_real);
-    LogKit::LogFormatted(LogKit::DebugLow,"\nFFTGrid Destructor: nGrids_ = %d",nGrids_);
+    int n_grids;
+#ifdef PARALLEL
+#pragma omp critical (fftgrid_count)
+#endif
+    {
+      if(add_==true)
+        nGrids_ = nGrids_ - 1;
+      FFTMemUse_ -= rsize_ * sizeof(fftw_real);
+      n_grids = nGrids_;
+    }
+    LogKit::LogFormatted(LogKit::DebugLow,"\nFFTGrid Destructor: nGrids_ = %d",n_grids);
   }
 }
 
@@ -369,108 +375,14 @@ double FFTGrid::InterpolateTrilinear(double x_min,
                                      double y,
                                      double z)
 {
-  int i1,j1,k1,i2,j2,k2;
+  int    index[8];
+  double weight[8];
+  int    n_corners;
 
-  double dx = (x_max - x_min)/nx_;
-  double dy = (y_max - y_min)/ny_;
-  double dz = (z_max - z_min)/nz_;
-
-  // If values are outside definition area return MISSING
-  if (z_min == z_max){
-    return InterpolateBilinearXY(x_min, x_max, y_min, y_max, x, y);
-  }
-  else if(x < x_min || x > x_max || y < y_min || y > y_max  || z<z_min || z> z_max){
+  if (FindInterpolationWeights(x_min, x_max, y_min, y_max, z_min, z_max, x, y, z, index, weight, n_corners) == false)
     return RMISSING;
-  // Can only interpolate from x_min+dx/2 to x_max-dx/2 etc.
-  } /*else if (x<x_min+dx/2 || x>x_max-dx/2 || y<y_min+dy/2 || y>y_max-dy/2 || z<z_min+dz/2 || z>z_max-dz/2 ){
-    return 0;
-  }*/
-  else{
-    // i1,j1,k1 can take values in the interval [0,nx],[0,ny],[0,nz]
-    i1 = static_cast<int>(floor((x-x_min-dx/2)/dx));
-    j1 = static_cast<int>(floor((y-y_min-dy/2)/dy));
-    k1 = static_cast<int>(floor((z-z_min-dz/2)/dz));
-    // i2,j2,k2 can take values in the interval [1,nx+1],[1,ny+1],[1,nz+1]
-    i2 = i1+1;
-    j2 = j1+1;
-    k2 = k1+1;
-  }
-  // TRILINEAR INTERPOLATION
-  double wi = (x - i1*dx-x_min-dx/2)/dx;
-  double wj = (y - j1*dy-y_min-dy/2)/dy;
-  double wk = (z - k1*dz-z_min-dz/2)/dz;
-
-  assert (wi>=0 && wi<=1 && wj>=0 && wj<=1 && wk>=0 && wk<=1);
-
-
-  double *value = new double[8];
-  value[0] = 0;
-  value[1] = 0;
-  value[2] = 0;
-  value[3] = 0;
-  value[4] = 0;
-  value[5] = 0;
-  value[6] = 0;
-  value[7] = 0;
-
-  if(i1<0 && j1<0 && k1<0){
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1<0 && j1<0 && k1>=0){
-    value[6] = std::max<double>(0,this->getRealValue(i2,j2,k1));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1<0 && j1>=0 && k1>=0){
-    value[4] = std::max<double>(0,this->getRealValue(i2,j1,k1));
-    value[5] = std::max<double>(0,this->getRealValue(i2,j1,k2));
-    value[6] = std::max<double>(0,this->getRealValue(i2,j2,k1));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1<0 && j1>=0 && k1<0){
-    value[5] = std::max<double>(0,this->getRealValue(i2,j1,k2));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1>=0 && j1<0 && k1<0){
-    value[3] = std::max<double>(0,this->getRealValue(i1,j2,k2));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1>=0 && j1>=0 && k1<0){
-    value[1] = std::max<double>(0,this->getRealValue(i1,j1,k2));
-    value[3] = std::max<double>(0,this->getRealValue(i1,j2,k2));
-    value[5] = std::max<double>(0,this->getRealValue(i2,j1,k2));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1>=0 && j1<0 && k1>=0){
-    value[2] = std::max<double>(0,this->getRealValue(i1,j2,k1));
-    value[3] = std::max<double>(0,this->getRealValue(i1,j2,k2));
-    value[6] = std::max<double>(0,this->getRealValue(i2,j2,k1));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-  else if(i1>=0 && j1>=0 && k1>=0){
-    value[0] = std::max<double>(0,this->getRealValue(i1,j1,k1));
-    value[1] = std::max<double>(0,this->getRealValue(i1,j1,k2));
-    value[2] = std::max<double>(0,this->getRealValue(i1,j2,k1));
-    value[3] = std::max<double>(0,this->getRealValue(i1,j2,k2));
-    value[4] = std::max<double>(0,this->getRealValue(i2,j1,k1));
-    value[5] = std::max<double>(0,this->getRealValue(i2,j1,k2));
-    value[6] = std::max<double>(0,this->getRealValue(i2,j2,k1));
-    value[7] = std::max<double>(0,this->getRealValue(i2,j2,k2));
-  }
-
-  //float value=0;
-  double returnvalue = 0;
-  returnvalue += (1.0f-wi)*(1.0f-wj)*(1.0f-wk)*value[0];
-  returnvalue += (1.0f-wi)*(1.0f-wj)*(     wk)*value[1];
-  returnvalue += (1.0f-wi)*(     wj)*(1.0f-wk)*value[2];
-  returnvalue += (1.0f-wi)*(     wj)*(     wk)*value[3];
-  returnvalue += (     wi)*(1.0f-wj)*(1.0f-wk)*value[4];
-  returnvalue += (     wi)*(1.0f-wj)*(     wk)*value[5];
-  returnvalue += (     wi)*(     wj)*(1.0f-wk)*value[6];
-  returnvalue += (     wi)*(     wj)*(     wk)*value[7];
-
-  delete [] value;
 
-  return returnvalue;
+  return InterpolateWithWeights(index, weight, n_corners);
 }
 
 double FFTGrid::InterpolateBilinearXY(double x_min,
@@ -480,95 +392,120 @@ double FFTGrid::InterpolateBilinearXY(double x_min,
                                       double x,
                                       double y)
 {
-  int i1,j1,i2,j2;
+  int    index[8];
+  double weight[8];
+  int    n_corners;
 
+  if (FindInterpolationWeights(x_min, x_max, y_min, y_max, 0.0, 0.0, x, y, 0.0, index, weight, n_corners) == false)
+    return RMISSING;
+
+  return InterpolateWithWeights(index, weight, n_corners);
+}
+
+bool FFTGrid::FindInterpolationWeights(double   x_min,
+                                       double   x_max,
+                                       double   y_min,
+                                       double   y_max,
+                                       double   z_min,
+                                       double   z_max,
+                                       double   x,
+                                       double   y,
+                                       double   z,
+                                       int    * index,
+                                       double * weight,
+                                       int    & n_corners) const
+{
   double dx = (x_max - x_min)/nx_;
   double dy = (y_max - y_min)/ny_;
 
-  // If values are outside definition area return RMISSING
-  if(x < x_min || x > x_max || y < y_min || y > y_max){
-    return RMISSING;
-  // Can only interpolate from x_min+dx/2 to x_max-dx/2 etc.
-  }
-  else{
-    // i1,j1,k1 can take values in the interval [-1,nx-1],[-1,ny-1]
-    i1 = static_cast<int>(floor((x-x_min-dx/2)/dx));
-    j1 = static_cast<int>(floor((y-y_min-dy/2)/dy));
-    // i2,j2,k2 can take values in the interval [0,nx],[0,ny]
-    i2 = i1+1;
-    j2 = j1+1;
-  }
-  // BILINEAR INTERPOLATION
+  // If values are outside definition area return false
+  if (x < x_min || x > x_max || y < y_min || y > y_max)
+    return false;
+
+  // Can only interpolate from x_min+dx/2 to x_max-dx/2 etc. Corners outside the
+  // grid get index -1, and negative grid values count as zero.
+  //
+  // i1,j1,k1 can take values in the interval [-1,nx-1],[-1,ny-1],[-1,nz-1]
+  // i2,j2,k2 can take values in the interval [0,nx],[0,ny],[0,nz]
+  int i1 = static_cast<int>(floor((x-x_min-dx/2)/dx));
+  int j1 = static_cast<int>(floor((y-y_min-dy/2)/dy));
+  int i2 = i1+1;
+  int j2 = j1+1;
+
   double wi = (x - i1*dx-x_min-dx/2)/dx;
   double wj = (y - j1*dy-y_min-dy/2)/dy;
 
-  assert (wi>=0 && wi<=1 && wj>=0 && wj<=1);
-
-  double *value = new double[4];
-  value[0] = 0;
-  value[1] = 0;
-  value[2] = 0;
-  value[3] = 0;
+  if (z_min == z_max) {
+    // BILINEAR INTERPOLATION in the first layer
+    assert (wi>=0 && wi<=1 && wj>=0 && wj<=1);
 
-  // all indexes inside grid
-  if(i1>=0 && j1>=0 && i2<nx_ && j2<ny_){
-    value[0] = std::max<double>(0,this->getRealValue(i1,j1,0));
-    value[1] = std::max<double>(0,this->getRealValue(i1,j2,0));
-    value[2] = std::max<double>(0,this->getRealValue(i2,j1,0));
-    value[3] = std::max<double>(0,this->getRealValue(i2,j2,0));
-  }
-  // i1 and j1 outside grid
-  else if(i1<0 && j1<0 && i2<nx_ && j2<ny_){
-    value[3] = std::max<double>(0,this->getRealValue(i2,j2,0));
-  }
-  // j1 outside grid
-  else if(i1>=0 && j1<0 && i2<nx_ && j2<ny_){
-    value[1] = std::max<double>(0,this->getRealValue(i1,j2,0));
-    value[3] = std::max<double>(0,this->getRealValue(i2,j2,0));
-  }
-  // j1 and i2 outside grid
-  else if(i1>=0 && j1<0 && i2>=nx_ && j2<ny_){
-    value[1] = std::max<double>(0,this->getRealValue(i1,j2,0));
-  }
-  // i1 outside grid
-  else if(i1<0 && j1>=0 && i2<nx_ && j2<ny_){
-    value[2] = std::max<double>(0,this->getRealValue(i2,j1,0));
-    value[3] = std::max<double>(0,this->getRealValue(i2,j2,0));
-  }
-
-  // i2 outside grid
-  else if(i1>=0 && j1>=0 && i2>=nx_ && j2<ny_){
-    value[0] = std::max<double>(0,this->getRealValue(i1,j1,0));
-    value[1] = std::max<double>(0,this->getRealValue(i1,j2,0));
-  }
-  // i1 and j2 outside grid
-  else if(i1<0 && j1>=0 && i2<nx_ && j2>=ny_){
-    value[2] = std::max<double>(0,this->getRealValue(i2,j1,0));
-  }
-  // j2 outside grid
-  else if(i1>=0 && j1>=0 && i2<nx_ && j2>=ny_){
-    value[0] = std::max<double>(0,this->getRealValue(i1,j1,0));
-    value[2] = std::max<double>(0,this->getRealValue(i2,j1,0));
-  }
-  // i2 and j2 outside grid
-  else if(i1>=0 && j1>=0 && i2>=nx_ && j2>=ny_ ){
-    value[0] = std::max<double>(0,this->getRealValue(i1,j1,0));
+    n_corners = 4;
+    index[0]  = getRealIndex(i1,j1,0);
+    index[1]  = getRealIndex(i1,j2,0);
+    index[2]  = getRealIndex(i2,j1,0);
+    index[3]  = getRealIndex(i2,j2,0);
+    weight[0] = (1.0f-wi)*(1.0f-wj);
+    weight[1] = (1.0f-wi)*(     wj);
+    weight[2] = (     wi)*(1.0f-wj);
+    weight[3] = (     wi)*(     wj);
   }
   else {
-    // something is wrong
-  }
+    if (z < z_min || z > z_max)
+      return false;
+
+    // TRILINEAR INTERPOLATION
+    double dz = (z_max - z_min)/nz_;
+    int    k1 = static_cast<int>(floor((z-z_min-dz/2)/dz));
+    int    k2 = k1+1;
+    double wk = (z - k1*dz-z_min-dz/2)/dz;
+
+    assert (wi>=0 && wi<=1 && wj>=0 && wj<=1 && wk>=0 && wk<=1);
+
+    n_corners = 8;
+    index[0]  = getRealIndex(i1,j1,k1);
+    index[1]  = getRealIndex(i1,j1,k2);
+    index[2]  = getRealIndex(i1,j2,k1);
+    index[3]  = getRealIndex(i1,j2,k2);
+    index[4]  = getRealIndex(i2,j1,k1);
+    index[5]  = getRealIndex(i2,j1,k2);
+    index[6]  = getRealIndex(i2,j2,k1);
+    index[7]  = getRealIndex(i2,j2,k2);
+    weight[0] = (1.0f-wi)*(1.0f-wj)*(1.0f-wk);
+    weight[1] = (1.0f-wi)*(1.0f-wj)*(     wk);
+    weight[2] = (1.0f-wi)*(     wj)*(1.0f-wk);
+    weight[3] = (1.0f-wi)*(     wj)*(     wk);
+    weight[4] = (     wi)*(1.0f-wj)*(1.0f-wk);
+    weight[5] = (     wi)*(1.0f-wj)*(     wk);
+    weight[6] = (     wi)*(     wj)*(1.0f-wk);
+    weight[7] = (     wi)*(     wj)*(     wk);
+  }
+
+  return true;
+}
+
+double FFTGrid::InterpolateWithWeights(const int    * index,
+                                       const double * weight,
+                                       int            n_corners) const
+{
+  assert(istransformed_==false);
 
   double returnvalue = 0;
-  returnvalue += (1.0f-wi)*(1.0f-wj)*value[0];
-  returnvalue += (1.0f-wi)*(     wj)*value[1];
-  returnvalue += (     wi)*(1.0f-wj)*value[2];
-  returnvalue += (     wi)*(     wj)*value[3];
-
-  delete [] value;
+  for (int c = 0; c < n_corners; c++) {
+    if (index[c] >= 0)
+      returnvalue += weight[c]*std::max<double>(0, static_cast<float>(rvalue_[index[c]]));
+  }
 
   return returnvalue;
 }
 
+int FFTGrid::getRealIndex(int i, int j, int k) const
+{
+  if (i > -1 && j > -1 && k > -1 && i < nx_ && j < ny_ && k < nz_)
+    return i+rnxp_*j+k*rnxp_*nyp_;
+  else
+    return -1;
+}
+
 void
 FFTGrid::interpolateGridValues(std::vector<float> & grid_trace,
                                float                z0_grid,
@@ -1054,8 +991,12 @@ FFTGrid::createRealGrid(bool add)
 {
   istransformed_=false;
   add_ = add;
-  if(add==true)
+  if(add==true) {
+#ifdef PARALLEL
+#pragma omp critical (fftgrid_count)
+#endif
     nGrids_ += 1;
+  }
   createGrid();
 }
 
@@ -1063,6 +1004,9 @@ void
 FFTGrid::createComplexGrid()
 {
   istransformed_  = true;
+#ifdef PARALLEL
+#pragma omp critical (fftgrid_count)
+#endif
   nGrids_        += 1;
   createGrid();
 }
@@ -1076,8 +1020,24 @@ void FFTGrid::createGrid()
   counterForGet_  = 0;
   counterForSet_  = 0;
 
+  // Grids may be allocated from several threads when intervals are set up concurrently
+  int   n_grids;
+  float mem_peak = 0.0f;
+#ifdef PARALLEL
+#pragma omp critical (fftgrid_count)
+#endif
+  {
+    n_grids            = nGrids_;
+    maxAllocatedGrids_ = std::max(nGrids_, maxAllocatedGrids_);
+    FFTMemUse_        += rsize_ * sizeof(fftw_real);
+    if(FFTMemUse_ > maxFFTMemUse_) {
+      maxFFTMemUse_ = FFTMemUse_;
+      mem_peak      = FFTMemUse_;
+    }
+  }
+
  // LogKit::LogFormatted(LogKit::Error,"\nFFTGrid createGrid : nGrids = %d    maxGrids = %d\n",nGrids_,maxAllowedGrids_);
-  if (nGrids_ > maxAllowedGrids_) {
+  if (n_grids > maxAllowedGrids_) {
     std::string text;
     text += "\n\nERROR in FFTGrid createGrid. You have allocated too many FFTGrids. The fix";
     text += "\nis to increase the nGrids variable calculated in Model::checkAvailableMemory().\n";
@@ -1088,18 +1048,13 @@ void FFTGrid::createGrid()
       LogKit::LogFormatted(LogKit::Error, text);
       exit(1);
     }
-    else if(nGrids_ == maxAllowedGrids_+1) {
+    else if(n_grids == maxAllowedGrids_+1) {
       //NBNB-PAL: Commented out until memory handling is fixed in 4.0 release
       //TaskList::addTask("Crava needs more memory than expected. The results are still correct. \n Norwegian Computing Center would like to have a look at your project.");
     }
   }
-  maxAllocatedGrids_ = std::max(nGrids_, maxAllocatedGrids_);
-
-  FFTMemUse_ += rsize_ * sizeof(fftw_real);
-  if(FFTMemUse_ > maxFFTMemUse_) {
-    maxFFTMemUse_ = FFTMemUse_;
-    LogKit::LogFormatted(LogKit::DebugLow,"\nNew FFT-grid memory peak (%2d): %10.2f MB\n",nGrids_, FFTMemUse_/(1024.f*1024.f));
-  }
+  if(mem_peak > 0.0f)
+    LogKit::LogFormatted(LogKit::DebugLow,"\nNew FFT-grid memory peak (%2d): %10.2f MB\n",n_grids, mem_peak/(1024.f*1024.f));
 
 
 
@@ -1614,8 +1569,15 @@ FFTGrid::fftInPlace()
   int flag;
   rfftwnd_plan plan;
   flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
+  // FFTW plan creation and destruction are not thread safe
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   plan= rfftw3d_create_plan(nzp_,nyp_,nxp_,FFTW_REAL_TO_COMPLEX,flag);
   rfftwnd_one_real_to_complex(plan,rvalue_,cvalue_);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   fftwnd_destroy_plan(plan);
   istransformed_=true;
   time(&timeend);
@@ -1645,8 +1607,14 @@ FFTGrid::invFFTInPlace()
     scale=float( 1.0/sqrt(float(nxp_*nyp_*nzp_)));
 
   flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   plan= rfftw3d_create_plan(nzp_,nyp_,nxp_,FFTW_COMPLEX_TO_REAL,flag);
   rfftwnd_one_complex_to_real(plan,cvalue_,rvalue_);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   fftwnd_destroy_plan(plan);
   istransformed_=false;
 
@@ -1806,8 +1774,14 @@ FFTGrid::fft1DzInPlace(fftw_real*  in, int nzp)
   out = reinterpret_cast<fftw_complex*>(in);
 
   flag    = FFTW_ESTIMATE | FFTW_IN_PLACE;
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   plan    = rfftwnd_create_plan(1, &nzp ,FFTW_REAL_TO_COMPLEX,flag);
   rfftwnd_one_real_to_complex(plan,in ,out);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   fftwnd_destroy_plan(plan);
 
   return out;
@@ -1825,8 +1799,14 @@ FFTGrid::invFFT1DzInPlace(fftw_complex* in, int nzp)
   out = reinterpret_cast<fftw_real*>(in);
 
   flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   plan= rfftwnd_create_plan(1,&nzp,FFTW_COMPLEX_TO_REAL,flag);
   rfftwnd_one_complex_to_real(plan,in,out);
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
   fftwnd_destroy_plan(plan);
   return out;
 }
@@ -2079,22 +2059,24 @@ FFTGrid::writeResampledStormCube(const GridMapping * gridmapping,
 {
   // simbox is related to the cube we resample from. gridmapping contains simbox for the cube we resample to.
 
-  float time, kindex;
   StormContGrid *mapping = gridmapping->getMapping();
   StormContGrid *outgrid = new StormContGrid(*mapping);
 
-  double x,y;
-  int nz = static_cast<int>(mapping->GetNK());
+  int    nz = static_cast<int>(mapping->GetNK());
+  double dz = simbox->getdz();
+#ifdef PARALLEL
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(gridmapping->getNumberOfThreads())
+#endif
   for(int i=0;i<nx_;i++)
   {
     for(int j=0;j<ny_;j++)
     {
-      simbox->getXYCoord(i,j,x,y);
+      float top = static_cast<float>(simbox->getTop(i,j));
       for(int k=0;k<nz;k++)
       {
-        time = (*mapping)(i,j,k);
-        kindex = float((time - static_cast<float>(simbox->getTop(x,y)))/simbox->getdz());
-        float value = getRealValueInterpolated(i,j,kindex);
+        float time   = (*mapping)(i,j,k);
+        float kindex = float((time - top)/dz);
+        float value  = getRealValueInterpolated(i,j,kindex);
         (*outgrid)(i,j,k) = value;
       }
     }
@@ -2174,14 +2156,13 @@ FFTGrid::writeSgriFile(const std::string & fileName, const Simbox *simbox, const
   NRLib::OpenWrite(binFile, fName, std::ios::out | std::ios::binary);
 
   int i,j,k;
-  double x, y, z, zTop, zBot;
+  double z, zTop, zBot;
   float value;
   for(k=0;k<nz;k++) {
     for (j=0; j<ny; j++) {
       for (i=0; i<nx; i++) {
-        simbox->getXYCoord(i, j, x, y);
-        zTop = simbox->getTop(x, y);
-        zBot = simbox->getBot(x, y);
+        zTop = simbox->getTop(i, j);
+        zBot = simbox->getBot(i, j);
         z = zMin + k*dz;
         if (z < zTop || z > zBot)
           value = RMISSING;
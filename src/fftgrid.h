@@ -60,6 +60,26 @@ public:
                                             double x,
                                             double y);
 
+  // Corners and weights used by InterpolateTrilinear (bilinear in the first layer when
+  // z_min == z_max). Grids of equal size can share them to interpolate at the same point.
+  // Returns false if the point is outside the definition area.
+  bool                FindInterpolationWeights(double   x_min,
+                                               double   x_max,
+                                               double   y_min,
+                                               double   y_max,
+                                               double   z_min,
+                                               double   z_max,
+                                               double   x,
+                                               double   y,
+                                               double   z,
+                                               int    * index,     // 8 elements
+                                               double * weight,    // 8 elements
+                                               int    & n_corners) const;
+
+  double              InterpolateWithWeights(const int    * index,
+                                             const double * weight,
+                                             int            n_corners) const;
+
   void                 interpolateGridValues(std::vector<float> & grid_trace,
                                              float                z0_grid,
                                              float                dz_grid,
@@ -229,6 +249,8 @@ protected:
   int                  getYSimboxIndex(int j) { return (getFillNumber(j, ny_, nyp_ )) ;}
   int                  getZSimboxIndex(int k);
 
+  int                  getRealIndex(int i, int j, int k) const;  // Index in rvalue_, -1 outside simbox
+
   //Interpolation into SegY and sgri
   float                getRegularZInterpolatedRealValue(int i, int j, double z0Reg,
                                                          double dzReg, int kReg,
@@ -44,7 +44,6 @@ GravimetricInversion::GravimetricInversion(ModelGeneral            *  modelGener
   TimeKit::getTime(wall,cpu);
 
   State4D * state4d = modelGeneral->getState4D();
-  lag_index_              = modelGravityStatic->GetLagIndex();
 
   int nxp               = state4d->getMuVpStatic()->getNxp();
   int nyp               = state4d->getMuVpStatic()->getNyp();
@@ -59,6 +58,8 @@ GravimetricInversion::GravimetricInversion(ModelGeneral            *  modelGener
   int nzp_upscaled      = modelGravityStatic->GetNzp_upscaled();
   int Np_up             = nxp_upscaled*nyp_upscaled*nzp_upscaled;
 
+  MakeLagIndex(nxp_upscaled, nyp_upscaled, nzp_upscaled); // Including padded region!
+
   bool   include_level_shift = true;
   double shift_parameter    = 0;
   double level_shift        = 0;
@@ -697,6 +698,64 @@ void
   grid->endAccess();
 }
 
+void
+  GravimetricInversion::MakeLagIndex(int nx_upscaled, int ny_upscaled, int nz_upscaled)
+{
+  int N_up = nx_upscaled*ny_upscaled*nz_upscaled;
+  lag_index_.resize(N_up);
+  for (int i = 0; i < N_up; ++i) {
+    lag_index_[i].resize(N_up);
+
+    for (int j = 0; j < N_up; ++j)
+      lag_index_[i][j].resize(3);
+  }
+
+  int I, J;
+  for(int k1 = 1; k1 <= nz_upscaled; k1++)
+    for(int j1 = 1; j1 <= ny_upscaled; j1++)
+      for(int i1 = 1; i1 <= nx_upscaled; i1++){
+        I =  i1 + (j1-1)*nx_upscaled + (k1-1)*nx_upscaled*ny_upscaled;
+
+        for(int k2 = 1; k2 <= nz_upscaled; k2++)
+          for(int j2 = 1; j2 <= ny_upscaled; j2++)
+            for(int i2 = 1; i2 <= nx_upscaled; i2++){
+              J = i2 + (j2-1)*nx_upscaled + (k2-1)*nx_upscaled*ny_upscaled;
+
+              int lag_i = i2 - i1;
+              int lag_j = j2 - j1;
+              int lag_k = k2 - k1;
+
+              int ind1, ind2, ind3;
+              if(abs(lag_i) <= nx_upscaled/2 && abs(lag_j) <= ny_upscaled/2 && abs(lag_k) <= nz_upscaled/2) {
+                if(lag_i >= 0)
+                  ind1 = lag_i + 1;
+                else
+                  ind1 = nx_upscaled + lag_i + 1;
+
+                if(lag_j >= 0)
+                  ind2 = lag_j + 1;
+                else
+                  ind2 = ny_upscaled + lag_j + 1;
+
+                if(lag_k >= 0)
+                  ind3 = lag_k + 1;
+                else
+                  ind3 = nz_upscaled + lag_k + 1;
+
+                lag_index_[I-1][J-1][0] = ind1 - 1;   // NB: -1
+                lag_index_[I-1][J-1][1] = ind2 - 1;
+                lag_index_[I-1][J-1][2] = ind3 - 1;
+              }
+              else
+              {
+                lag_index_[I-1][J-1][0] = -1;
+                lag_index_[I-1][J-1][1] = -1;
+                lag_index_[I-1][J-1][2] = -1;
+              }
+            }
+      }
+}
+
 void
   GravimetricInversion::ReshapeCovAccordingToLag(NRLib::Matrix &CovMatrix, FFTGrid * covGrid)
 {
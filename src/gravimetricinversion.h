@@ -56,6 +56,7 @@ private:
   void                   Backsample(FFTGrid * upscaled_grid, FFTGrid * new_full_grid);
   void                   VectorizeFFTGrid(NRLib::Vector &vec, FFTGrid * grid, bool with_padding = true);
   void                   ReshapeVectorToFFTGrid(FFTGrid * grid, NRLib::Vector vec);
+  void                   MakeLagIndex(int nx_upscaled, int ny_upscaled, int nz_upscaled);
   void                   ReshapeCovAccordingToLag(NRLib::Matrix &cov_matrix, FFTGrid * cov_grid);
   void                   ReshapeCovMatrixToFFTGrid(FFTGrid * cov_grid, NRLib::Matrix cov_matrix);
 
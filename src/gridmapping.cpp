@@ -8,6 +8,11 @@
 #include <string.h>
 #include <time.h>
 #include <assert.h>
+#include <vector>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
 
 #include "src/modelgeneral.h"
 #include "src/definitions.h"
@@ -21,12 +26,13 @@
 #include "nrlib/stormgrid/stormcontgrid.hpp"
 
 
-GridMapping::GridMapping()
+GridMapping::GridMapping(int n_threads)
   : mapping_(NULL),
     simbox_(NULL),
     z0Grid_(NULL),
     z1Grid_(NULL),
-    surfaceMode_(NONEGIVEN)
+    surfaceMode_(NONEGIVEN),
+    n_threads_(std::max(n_threads, 1))
 {
 }
 
@@ -55,10 +61,8 @@ GridMapping::makeTimeTimeMapping(const Simbox * timeCutSimbox)
   {
     for(int j=0;j<ny;j++)
     {
-      double x,y;
-      timeCutSimbox->getXYCoord(i,j,x,y);
-      double tTop   = timeCutSimbox->getTop(x,y);
-      double tBase  = timeCutSimbox->getBot(x,y);
+      double tTop   = timeCutSimbox->getTop(i,j);
+      double tBase  = timeCutSimbox->getBot(i,j);
       double deltaT = (tBase-tTop)/static_cast<double>(nz);
       for(int k=0;k<nz;k++)
         (*mapping_)(i,j,k) = static_cast<float>(tTop + static_cast<double>(k)*deltaT);
@@ -72,47 +76,44 @@ GridMapping::makeTimeDepthMapping(FFTGrid      * velocity,
 {
   Simbox * depthSimbox = simbox_; // For readability
 
-  int nx  = depthSimbox->getnx();
-  int ny  = depthSimbox->getny();
-  int nz  = depthSimbox->getnz();
+  int nx     = depthSimbox->getnx();
+  int ny     = depthSimbox->getny();
+  int nz     = depthSimbox->getnz();
+  int nzTime = timeSimbox->getnz();
+  int nTrace = std::max(nz, nzTime);
+  int nv     = std::min(velocity->getNz(), nTrace);
   mapping_ = new StormContGrid(*depthSimbox, nx, ny, nz);
- // velocity->setAccessMode(FFTGrid::RANDOMACCESS);
-  for(int i=0;i<nx;i++)
+
+  //
+  // The columns are independent. Each thread extracts whole velocity traces
+  // and integrates them, so the grid is only visited once per column.
+  //
+#ifdef PARALLEL
+  #pragma omp parallel num_threads(n_threads_)
+#endif
   {
-    for(int j=0;j<ny;j++)
+    std::vector<float> vTrace(nTrace, RMISSING);
+    std::vector<float> tTrace(nz);
+#ifdef PARALLEL
+    #pragma omp for schedule(dynamic, 1)
+#endif
+    for(int i=0;i<nx;i++)
     {
-      double x,y;
-      depthSimbox->getXYCoord(i,j,x,y);
-      double tTop   = timeSimbox->getTop(x,y);
-      double tBase  = timeSimbox->getBot(x,y);
-      double zTop   = depthSimbox->getTop(x,y);
-      double zBase  = depthSimbox->getBot(x,y);
-      double deltaT = (tBase-tTop)/(static_cast<double>(2000*timeSimbox->getnz()));
-      double deltaZ = (zBase-zTop)/static_cast<double>(nz);
-      double sum    = 0.0;
-      double sumz   = 0.0;
-      for(int k=0 ; k<timeSimbox->getnz() ; k++)
-        sumz +=deltaT*velocity->getRealValue(i,j,k);
-      double c = (zBase-zTop)/sumz;
-      (*mapping_)(i,j,0) = static_cast<float>(tTop);
-      int kk = 0;
-      for(int k=1;k<nz;k++)
+      for(int j=0;j<ny;j++)
       {
-        double z = k*deltaZ;
-        while(sum<z && kk<nz)
-        {
-          kk++;
-          sum+=deltaT*c*velocity->getRealValue(i,j,kk-1);
-        }
-        double v   = velocity->getRealValue(i,j,kk-1);
-        double z0  = tTop;
-        double dz1 = 2000.0*static_cast<double>(kk-1)*deltaT;
-        double dz2 = 2000.0*(z - sum + deltaT*c*v)/(c*v);
-        (*mapping_)(i,j,k) = static_cast<float>(z0 + dz1 + dz2);
+        double tTop   = timeSimbox->getTop(i,j);
+        double tBase  = timeSimbox->getBot(i,j);
+        double zTop   = depthSimbox->getTop(i,j);
+        double zBase  = depthSimbox->getBot(i,j);
+        double deltaT = (tBase-tTop)/(static_cast<double>(2000*nzTime));
+        for(int k=0;k<nv;k++)
+          vTrace[k] = velocity->getRealValue(i,j,k);
+        integrateVelocityTrace(vTrace, nzTime, tTop, deltaT, zTop, zBase, tTrace);
+        for(int k=0;k<nz;k++)
+          (*mapping_)(i,j,k) = tTrace[k];
       }
     }
   }
- // velocity->endAccess();
 }
 
 void
@@ -121,47 +122,79 @@ GridMapping::makeTimeDepthMapping(NRLib::Grid<float> * velocity,
 {
   Simbox * depthSimbox = simbox_; // For readability
 
-  int nx  = depthSimbox->getnx();
-  int ny  = depthSimbox->getny();
-  int nz  = depthSimbox->getnz();
+  int nx     = depthSimbox->getnx();
+  int ny     = depthSimbox->getny();
+  int nz     = depthSimbox->getnz();
+  int nzTime = timeSimbox->getnz();
+  int nTrace = std::max(nz, nzTime);
+  int nv     = std::min(static_cast<int>(velocity->GetNK()), nTrace);
   mapping_ = new StormContGrid(*depthSimbox, nx, ny, nz);
 
-  for(int i=0;i<nx;i++)
+#ifdef PARALLEL
+  #pragma omp parallel num_threads(n_threads_)
+#endif
   {
-    for(int j=0;j<ny;j++)
+    std::vector<float> vTrace(nTrace, RMISSING);
+    std::vector<float> tTrace(nz);
+#ifdef PARALLEL
+    #pragma omp for schedule(dynamic, 1)
+#endif
+    for(int i=0;i<nx;i++)
     {
-      double x,y;
-      depthSimbox->getXYCoord(i,j,x,y);
-      double tTop   = timeSimbox->getTop(x,y);
-      double tBase  = timeSimbox->getBot(x,y);
-      double zTop   = depthSimbox->getTop(x,y);
-      double zBase  = depthSimbox->getBot(x,y);
-      double deltaT = (tBase-tTop)/(static_cast<double>(2000*timeSimbox->getnz()));
-      double deltaZ = (zBase-zTop)/static_cast<double>(nz);
-      double sum    = 0.0;
-      double sumz   = 0.0;
-      for(int k=0 ; k<timeSimbox->getnz() ; k++)
-        sumz +=deltaT*static_cast<double>(velocity->GetValue(i,j,k));
-      double c = (zBase-zTop)/sumz;
-      (*mapping_)(i,j,0) = static_cast<float>(tTop);
-      int kk = 0;
-      for(int k=1;k<nz;k++)
+      for(int j=0;j<ny;j++)
       {
-        double z = k*deltaZ;
-        while(sum<z && kk<nz)
-        {
-          kk++;
-          sum+=deltaT*c*static_cast<double>(velocity->GetValue(i,j,kk-1));
-        }
-        double v   = velocity->GetValue(i,j,kk-1);
-        double z0  = tTop;
-        double dz1 = 2000.0*static_cast<double>(kk-1)*deltaT;
-        double dz2 = 2000.0*(z - sum + deltaT*c*v)/(c*v);
-        (*mapping_)(i,j,k) = static_cast<float>(z0 + dz1 + dz2);
+        double tTop   = timeSimbox->getTop(i,j);
+        double tBase  = timeSimbox->getBot(i,j);
+        double zTop   = depthSimbox->getTop(i,j);
+        double zBase  = depthSimbox->getBot(i,j);
+        double deltaT = (tBase-tTop)/(static_cast<double>(2000*nzTime));
+        for(int k=0;k<nv;k++)
+          vTrace[k] = velocity->GetValue(i,j,k);
+        integrateVelocityTrace(vTrace, nzTime, tTop, deltaT, zTop, zBase, tTrace);
+        for(int k=0;k<nz;k++)
+          (*mapping_)(i,j,k) = tTrace[k];
       }
     }
   }
- // velocity->endAccess();
+}
+
+void
+GridMapping::integrateVelocityTrace(const std::vector<float> & velocity,
+                                    int                        nzTime,
+                                    double                     tTop,
+                                    double                     deltaT,
+                                    double                     zTop,
+                                    double                     zBase,
+                                    std::vector<float>       & timeTrace)
+{
+  //
+  // Integrates the velocity trace to depth, scales it to fit between zTop
+  // and zBase, and inverts the result to get the time of each depth cell.
+  // Velocities outside the trace are RMISSING, as for FFTGrid::getRealValue().
+  //
+  int    nz     = static_cast<int>(timeTrace.size());
+  double deltaZ = (zBase-zTop)/static_cast<double>(nz);
+  double sum    = 0.0;
+  double sumz   = 0.0;
+  for(int k=0 ; k<nzTime ; k++)
+    sumz += deltaT*static_cast<double>(velocity[k]);
+  double c   = (zBase-zTop)/sumz;
+  double dtc = deltaT*c;
+  timeTrace[0] = static_cast<float>(tTop);
+  int kk = 0;
+  for(int k=1;k<nz;k++)
+  {
+    double z = k*deltaZ;
+    while(sum<z && kk<nz)
+    {
+      kk++;
+      sum += dtc*static_cast<double>(velocity[kk-1]);
+    }
+    double v   = (kk > 0 ? velocity[kk-1] : RMISSING);
+    double dz1 = 2000.0*static_cast<double>(kk-1)*deltaT;
+    double dz2 = 2000.0*(z - sum + dtc*v)/(c*v);
+    timeTrace[k] = static_cast<float>(tTop + dz1 + dz2);
+  }
 }
 
 
@@ -261,7 +294,15 @@ GridMapping::calculateSurfaceFromVelocity(FFTGrid      * velocity,
     double dx = 0.5*isochore->GetDX();
     double dy = 0.5*isochore->GetDY();
 
-    for(int j=0 ; j<static_cast<int>(isochore->GetNJ()) ; j++)
+    //
+    // Each node only reads the velocity and writes its own isochore value,
+    // so the rows can be done in parallel.
+    //
+    int nj = static_cast<int>(isochore->GetNJ());
+#ifdef PARALLEL
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads_)
+#endif
+    for(int j=0 ; j<nj ; j++)
     {
       for(int i=0 ; i<static_cast<int>(isochore->GetNI()) ; i++)
       {
@@ -360,7 +401,11 @@ GridMapping::calculateSurfaceFromVelocity(NRLib::Grid<float> * velocity,
     double dx = 0.5*isochore->GetDX();
     double dy = 0.5*isochore->GetDY();
 
-    for(int j=0 ; j<static_cast<int>(isochore->GetNJ()) ; j++)
+    int nj = static_cast<int>(isochore->GetNJ());
+#ifdef PARALLEL
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads_)
+#endif
+    for(int j=0 ; j<nj ; j++)
     {
       for(int i=0 ; i<static_cast<int>(isochore->GetNI()) ; i++)
       {
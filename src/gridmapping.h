@@ -18,10 +18,11 @@ class FFTGrid;
 class GridMapping
 {
 public:
-  GridMapping();
+  GridMapping(int n_threads = 1);
   ~GridMapping(void);
-  StormContGrid * getMapping(void)  const { return mapping_ ;}
-  Simbox        * getSimbox(void)   const { return simbox_  ;}
+  StormContGrid * getMapping(void)         const { return mapping_   ;}
+  Simbox        * getSimbox(void)          const { return simbox_    ;}
+  int             getNumberOfThreads(void) const { return n_threads_ ;} // Also used when resampling output cubes with this mapping
   void            setDepthSurfaces(const std::string & topSurfFile,
                                    const std::string & baseSurfFiles,
                                    bool              & failed,
@@ -53,6 +54,14 @@ public:
 
 
 private:
+  static void     integrateVelocityTrace(const std::vector<float> & velocity,
+                                         int                        nzTime,
+                                         double                     tTop,
+                                         double                     deltaT,
+                                         double                     zTop,
+                                         double                     zBase,
+                                         std::vector<float>       & timeTrace);
+
   StormContGrid * mapping_;
   Simbox        * simbox_;
 
@@ -60,5 +69,7 @@ private:
   Surface       * z1Grid_;
 
   int             surfaceMode_;
+
+  int             n_threads_;
 };
 #endif
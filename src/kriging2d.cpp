@@ -15,7 +15,8 @@
 void Kriging2D::krigSurface(Grid2D              & trend,
                             const KrigingData2D & krigingData,
                             const CovGrid2D     & cov,
-                            bool                  getResiduals)
+                            bool                  getResiduals,
+                            int                   n_threads)
 {
   //
   // This routine by default returns z(x) = m(x) + k(x)K^{-1}(d - m). If only
@@ -33,10 +34,6 @@ void Kriging2D::krigSurface(Grid2D              & trend,
 
     NRLib::Vector residual(md);
 
-    NRLib::SymmetricMatrix K;
-    NRLib::Vector k;
-    NRLib::Vector x;
-
     subtractTrend(residual, data, trend, indexi, indexj);
 
 
@@ -52,21 +49,28 @@ void Kriging2D::krigSurface(Grid2D              & trend,
         filled(indexi[i],indexj[i])=1.0;
       }
     }
-    bool first=true;
+
+    if (!hasUnfilledNodes(filled))
+      return;
+
+    NRLib::SymmetricMatrix K(md);
+    NRLib::Vector          x(md);
+
+    fillKrigingMatrix(K, cov, indexi, indexj);
+    NRLib::CholeskySolve(K, residual, x);
+
+    //
+    // Each node only depends on the solved system, so the
+    // grid columns are filled in parallel.
+    //
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
     for (int i = 0 ; i < nx ; i++) {
+      NRLib::Vector k(md);
       for (int j = 0 ; j < ny ; j++) {
         if(!(filled(i,j) > 0.0)) // if this is not a datapoint
         {
-          if(first)
-          {
-             K.resize(md);
-             k.resize(md);
-             x.resize(md);
-
-             fillKrigingMatrix(K, cov, indexi, indexj);
-             NRLib::CholeskySolve(K, residual, x);
-             first = false;
-          }
           fillKrigingVector(k, cov, indexi, indexj, i, j);
 
           if (getResiduals) {  // Only get the residuals
@@ -81,6 +85,92 @@ void Kriging2D::krigSurface(Grid2D              & trend,
   }
 }
 
+void Kriging2D::krigSurfaces(std::vector<Grid2D *>            & trends,
+                             const std::vector<KrigingData2D> & krigingData,
+                             const CovGrid2D                  & cov,
+                             int                                n_threads)
+{
+  int nSurfaces = static_cast<int>(trends.size());
+  if (nSurfaces == 0)
+    return;
+
+  const std::vector<int> & indexi = krigingData[0].getIndexI();
+  const std::vector<int> & indexj = krigingData[0].getIndexJ();
+
+  int md = krigingData[0].getNumberOfData();
+  int nx = static_cast<int>(trends[0]->GetNI());
+  int ny = static_cast<int>(trends[0]->GetNJ());
+
+  bool shared = true;
+  for (int s = 1 ; s < nSurfaces ; s++) {
+    shared = shared && krigingData[s].getIndexI() == indexi
+                    && krigingData[s].getIndexJ() == indexj
+                    && static_cast<int>(trends[s]->GetNI()) == nx
+                    && static_cast<int>(trends[s]->GetNJ()) == ny;
+  }
+  if (!shared) {
+    for (int s = 0 ; s < nSurfaces ; s++)
+      krigSurface(*trends[s], krigingData[s], cov, false, n_threads);
+    return;
+  }
+
+  if (md > 0 && md <= nx*ny) {
+
+    NRLib::Matrix residuals(md, nSurfaces);
+    NRLib::Vector residual(md);
+
+    for (int s = 0 ; s < nSurfaces ; s++) {
+      Grid2D & trend = *trends[s];
+      subtractTrend(residual, krigingData[s].getData(), trend, indexi, indexj);
+      for (int i = 0 ; i < md ; i++) {
+        trend(indexi[i],indexj[i]) += residual(i);
+        residuals(i,s) = residual(i);
+      }
+    }
+
+    Grid2D filled(nx,ny,0);
+    for (int i = 0 ; i < md ; i++)
+      filled(indexi[i],indexj[i]) = 1.0;
+
+    if (!hasUnfilledNodes(filled))
+      return;
+
+    NRLib::SymmetricMatrix K(md);
+    fillKrigingMatrix(K, cov, indexi, indexj);
+    NRLib::CholeskySolve(K, residuals);
+
+    std::vector<NRLib::Vector> x(nSurfaces);
+    for (int s = 0 ; s < nSurfaces ; s++) {
+      x[s].resize(md);
+      x[s] = residuals(flens::_, s);
+    }
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+    for (int i = 0 ; i < nx ; i++) {
+      NRLib::Vector k(md);
+      for (int j = 0 ; j < ny ; j++) {
+        if(!(filled(i,j) > 0.0)) {
+          fillKrigingVector(k, cov, indexi, indexj, i, j);
+          for (int s = 0 ; s < nSurfaces ; s++)
+            (*trends[s])(i,j) += k * x[s];
+        }
+      }
+    }
+  }
+}
+
+bool
+Kriging2D::hasUnfilledNodes(const Grid2D & filled)
+{
+  for (size_t i = 0 ; i < filled.GetN() ; i++) {
+    if (!(filled(i) > 0.0))
+      return true;
+  }
+  return false;
+}
+
 void
 Kriging2D::subtractTrend(NRLib::Vector            & residual,
                          const std::vector<float> & data,
@@ -21,13 +21,23 @@ public:
   static void  krigSurface(Grid2D              & trend,
                            const KrigingData2D & krigingData,
                            const CovGrid2D     & cov,
-                           bool                  getResiduals = false);
+                           bool                  getResiduals = false,
+                           int                   n_threads    = 1);
+
+  // Krig several surfaces. Surfaces with data at identical locations share
+  // one factorisation of the kriging matrix.
+  static void  krigSurfaces(std::vector<Grid2D *>            & trends,
+                            const std::vector<KrigingData2D> & krigingData,
+                            const CovGrid2D                  & cov,
+                            int                                n_threads = 1);
 
   static CovGrid2D & makeCovGrid2D(const Simbox * simbox,
                                    Vario        * vario,
                                    int            debugFlag);
 
 private:
+  static bool  hasUnfilledNodes(const Grid2D & filled);
+
   static void  subtractTrend(NRLib::Vector            & d,
                              const std::vector<float> & data,
                              const Grid2D             & trend,
@@ -126,7 +126,11 @@ ModelGeneral::ModelGeneral(ModelSettings           *& model_settings,
 
         SetupState4D(seismic_parameters, simbox_, state4d_, initial_mean, initial_cov);
 
-        time_evolution_ = TimeEvolution(10000, *time_line_, rock_distributions_.begin()->second); //NBNB OK 10000->1000 for speed during testing
+        int n_threads = 1;
+#ifdef PARALLEL
+        n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+        time_evolution_ = TimeEvolution(10000, *time_line_, rock_distributions_.begin()->second, n_threads); //NBNB OK 10000->1000 for speed during testing
         time_evolution_.SetInitialMean(initial_mean);
         time_evolution_.SetInitialCov(initial_cov);
       }
@@ -413,7 +417,11 @@ ModelGeneral::updateState4DMu(FFTGrid * mu_vp_static,
 bool
 ModelGeneral::Do4DRockPhysicsInversion(ModelSettings* model_settings)
 {
-  std::vector<FFTGrid*> predictions = state4d_.doRockPhysicsInversion(*time_line_, rock_distributions_.begin()->second,  time_evolution_);
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+  std::vector<FFTGrid*> predictions = state4d_.doRockPhysicsInversion(*time_line_, rock_distributions_.begin()->second,  time_evolution_, n_threads);
   int nParamOut = static_cast<int>(predictions.size());
 
   std::vector<std::string> labels(nParamOut);
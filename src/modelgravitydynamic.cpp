@@ -58,7 +58,6 @@ ModelGravityDynamic::ModelGravityDynamic(const ModelSettings          * modelSet
   bool failedReadingFile  = false;
   std::string errText("");
 
-  int nObs = 30;     // should this be given in input file
   int nColumns = 5;  // We require data files to have five columns
 
   // Check that timeLapse is ok
@@ -73,15 +72,9 @@ ModelGravityDynamic::ModelGravityDynamic(const ModelSettings          * modelSet
     // Find first gravity data file
     std::string fileName = inputFiles->getGravimetricData(thisTimeLapse_);
 
-    observation_location_utmx_ .resize(nObs);
-    observation_location_utmy_ .resize(nObs);
-    observation_location_depth_.resize(nObs);
-    gravity_response_.resize(nObs);
-    gravity_std_dev_ .resize(nObs);
-
     ModelGravityStatic::ReadGravityDataFile(fileName,
                                             "gravimetric survey ",
-                                            nObs, nColumns,
+                                            nColumns,
                                             observation_location_utmx_,
                                             observation_location_utmy_,
                                             observation_location_depth_,
@@ -153,7 +146,7 @@ void ModelGravityDynamic::BuildGMatrix(ModelGravityStatic      * modelGravitySta
   int N_upscaled = nx_upscaled*ny_upscaled*nz_upscaled;
   int N_fullsize = nx*ny*nz;
 
-  int nObs = 30;
+  int nObs = static_cast<int>(observation_location_utmx_.size());
 
   G_         .resize(nObs, N_upscaled);
   G_fullsize_.resize(nObs, N_fullsize);
@@ -205,10 +198,11 @@ void ModelGravityDynamic::BuildGMatrix(ModelGravityStatic      * modelGravitySta
 
      J = 0; I = 0;
 
-    // Loop through upscaled simbox to get x, y, z for each grid cell
-    for(int ii = 0; ii < nx_upscaled; ii++){
+    // Loop through upscaled simbox to get x, y, z for each grid cell. Cells are
+    // numbered with i running fastest, as in GravimetricInversion.
+    for(int kk = 0; kk < nz_upscaled; kk++){
       for(int jj = 0; jj < ny_upscaled; jj++){
-        for(int kk = 0; kk < nz_upscaled; kk++){
+        for(int ii = 0; ii < nx_upscaled; ii++){
           double x, y, z;
           vp = upscaledMeanAlpha->getRealValue(ii,jj,kk);
 
@@ -273,9 +267,9 @@ void ModelGravityDynamic::BuildGMatrix(ModelGravityStatic      * modelGravitySta
       }
     }
     // Loop through full size simbox to get x, y, z for each grid cell
-    for(int ii = 0; ii < nx; ii++){
+    for(int kk = 0; kk < nz; kk++){
       for(int jj = 0; jj < ny; jj++){
-        for(int kk = 0; kk < nz; kk++){
+        for(int ii = 0; ii < nx; ii++){
           double x, y, z;
           fullSizeTimeSimbox->getCoord(ii, jj, kk, x, y, z); // assuming these are center positions...
           vp = meanAlphaFullSize->getRealValue(ii, jj, kk);
@@ -66,17 +66,10 @@ ModelGravityStatic::ModelGravityStatic(ModelSettings        *& modelSettings,
     // Find first gravity data file
     std::string fileName = inputFiles->getGravimetricData(0);
 
-    int nObs = 30;     //user input
     int nColumns = 5;  // We require data files to have five columns
 
-    observation_location_utmx_.resize(nObs);
-    observation_location_utmy_.resize(nObs);
-    observation_location_depth_.resize(nObs);
-    gravity_response_.resize(nObs);
-    gravity_std_dev_.resize(nObs);
-
     ReadGravityDataFile(fileName, "gravimetric base survey",
-                        nObs, nColumns,
+                        nColumns,
                         observation_location_utmx_,
                         observation_location_utmy_,
                         observation_location_depth_,
@@ -101,12 +94,6 @@ ModelGravityStatic::ModelGravityStatic(ModelSettings        *& modelSettings,
     LogKit::LogFormatted(LogKit::Low, "Generating smoothing kernel ...");
     MakeUpscalingKernel(modelSettings, fullTimeSimbox);
     LogKit::LogFormatted(LogKit::Low, "ok.\n");
-
-    LogKit::LogFormatted(LogKit::Low, "Generating lag index table (size " + NRLib::ToString(nxp_upscaled_) + " x "
-                                                                          + NRLib::ToString(nyp_upscaled_) + " x "
-                                                                          + NRLib::ToString(nzp_upscaled_) + ") ...");
-    MakeLagIndex(nxp_upscaled_, nyp_upscaled_, nzp_upscaled_); // Including padded region!
-    LogKit::LogFormatted(LogKit::Low, "ok.\n");
   }
 
   if (failedLoadingModel) {
@@ -127,48 +114,52 @@ ModelGravityStatic::~ModelGravityStatic(void)
 void
 ModelGravityStatic::ReadGravityDataFile(const std::string   & fileName,
                                         const std::string   & readReason,
-                                        int                   nObs,
                                         int                   nColumns,
                                         std::vector <float> & obs_loc_utmx,
                                         std::vector <float> & obs_loc_utmy,
                                         std::vector <float> & obs_loc_depth,
                                         std::vector <float> & gravity_response,
                                         std::vector <float> & gravity_std_dev,
-                                        bool                  failed,
+                                        bool                & failed,
                                         std::string         & errText)
 {
-  float * tmpRes = new float[nObs*nColumns+1];
+  std::vector<float> tmpRes;
   std::ifstream inFile;
   NRLib::OpenRead(inFile,fileName);
   std::string text = "Reading "+readReason+" from file "+fileName+" ... ";
   LogKit::LogFormatted(LogKit::Low,text);
   std::string storage;
-  int index = 0;
   failed = false;
 
   while(failed == false && inFile >> storage) {
-    if(index < nObs*nColumns) {
-      try {
-        tmpRes[index] = NRLib::ParseType<float>(storage);
-      }
-      catch (NRLib::Exception & e) {
-        errText += "Error in "+fileName+"\n";
-        errText += e.what();
-        failed = true;
-      }
+    try {
+      tmpRes.push_back(NRLib::ParseType<float>(storage));
+    }
+    catch (NRLib::Exception & e) {
+      errText += "Error in "+fileName+"\n";
+      errText += e.what();
+      failed = true;
     }
-    index++;
   }
+  int nValues = static_cast<int>(tmpRes.size());
   if(failed == false) {
-    if(index != nObs*nColumns) {
+    if(nValues == 0 || nValues % nColumns != 0) {
       failed = true;
-      errText += "Found "+NRLib::ToString(index)+" in file "+fileName+", expected "+NRLib::ToString(nObs*nColumns)+".\n";
+      errText += "Found "+NRLib::ToString(nValues)+" values in file "+fileName+", expected a positive multiple of "+NRLib::ToString(nColumns)+".\n";
     }
   }
 
   if(failed == false) {
-    LogKit::LogFormatted(LogKit::Low,"ok.\n");
-    index = 0;
+    int nObs = nValues/nColumns;
+    LogKit::LogFormatted(LogKit::Low,"ok (" + NRLib::ToString(nObs) + " observations).\n");
+
+    obs_loc_utmx    .resize(nObs);
+    obs_loc_utmy    .resize(nObs);
+    obs_loc_depth   .resize(nObs);
+    gravity_response.resize(nObs);
+    gravity_std_dev .resize(nObs);
+
+    int index = 0;
     for(int i=0;i<nObs;i++) {
       obs_loc_utmx[i] = tmpRes[index];
       index++;
@@ -184,8 +175,6 @@ ModelGravityStatic::ReadGravityDataFile(const std::string   & fileName,
   }
   else
     LogKit::LogFormatted(LogKit::Low,"failed.\n");
-
-  delete [] tmpRes;
 }
 
 void
@@ -215,62 +204,6 @@ ModelGravityStatic::MakeUpscalingKernel(ModelSettings * modelSettings, const Sim
   upscaling_kernel_->multiplyByScalar(static_cast<float>(nxp_upscaled_*nyp_upscaled_*nzp_upscaled_)/static_cast<float>(nxp*nyp*nzp));
 }
 
-void ModelGravityStatic::MakeLagIndex(int nx_upscaled, int ny_upscaled, int nz_upscaled)
-{
-  int N_up = nx_upscaled*ny_upscaled*nz_upscaled;
-  lag_index_.resize(N_up);
-  for (int i = 0; i < N_up; ++i) {
-    lag_index_[i].resize(N_up);
-
-    for (int j = 0; j < N_up; ++j)
-      lag_index_[i][j].resize(3);
-  }
-
-  int I, J;
-  for(int k1 = 1; k1 <= nz_upscaled; k1++)
-    for(int j1 = 1; j1 <= ny_upscaled; j1++)
-      for(int i1 = 1; i1 <= nx_upscaled; i1++){
-        I =  i1 + (j1-1)*nx_upscaled + (k1-1)*nx_upscaled*ny_upscaled;
-
-        for(int k2 = 1; k2 <= nz_upscaled; k2++)
-          for(int j2 = 1; j2 <= ny_upscaled; j2++)
-            for(int i2 = 1; i2 <= nx_upscaled; i2++){
-              J = i2 + (j2-1)*nx_upscaled + (k2-1)*nx_upscaled*ny_upscaled;
-
-              int lag_i = i2 - i1;
-              int lag_j = j2 - j1;
-              int lag_k = k2 - k1;
-
-              int ind1, ind2, ind3;
-              if(abs(lag_i) <= nx_upscaled/2 && abs(lag_j) <= ny_upscaled/2 && abs(lag_k) <= nz_upscaled/2) {
-                if(lag_i >= 0)
-                  ind1 = lag_i + 1;
-                else
-                  ind1 = nx_upscaled + lag_i + 1;
-
-                if(lag_j >= 0)
-                  ind2 = lag_j + 1;
-                else
-                  ind2 = ny_upscaled + lag_j + 1;
-
-                if(lag_k >= 0)
-                  ind3 = lag_k + 1;
-                else
-                  ind3 = nz_upscaled + lag_k + 1;
-
-                lag_index_[I-1][J-1][0] = ind1 - 1;   // NB: -1
-                lag_index_[I-1][J-1][1] = ind2 - 1;
-                lag_index_[I-1][J-1][2] = ind3 - 1;
-              }
-              else
-              {
-                lag_index_[I-1][J-1][0] = -1;
-                lag_index_[I-1][J-1][1] = -1;
-                lag_index_[I-1][J-1][2] = -1;
-              }
-            }
-      }
-}
 void
 ModelGravityStatic::SetUpscaledPaddingSize(const Simbox * fullTimeSimbox)
 {
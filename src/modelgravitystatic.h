@@ -22,7 +22,6 @@ public:
   std::vector<float>            GetGravityStdDev()         const { return gravity_std_dev_        ;}
 
   FFTGrid *                     GetUpscalingKernel()       const { return upscaling_kernel_       ;}
-  std::vector<std::vector<std::vector<int> > > GetLagIndex() const { return lag_index_            ;}
 
   int                           GetNx_upscaled()            const { return nx_upscaled_           ;}
   int                           GetNy_upscaled()            const { return ny_upscaled_           ;}
@@ -37,16 +36,16 @@ public:
   double                        GetDz_upscaled()            const { return dz_upscaled_           ;}
 
   // To be used by ModelGravityDynamic as well
+  // The number of observations is given by the number of lines in the file
   static void ReadGravityDataFile(const std::string   & fileName,
                                   const std::string   & readReason,
-                                  int                   nObs,
                                   int                   nColumns,
                                   std::vector <float> & obs_loc_utmx,
                                   std::vector <float> & obs_loc_utmy,
                                   std::vector <float> & obs_loc_depth,
                                   std::vector <float> & gravity_response,
                                   std::vector <float> & gravity_std_dev,
-                                  bool                  failed,
+                                  bool                & failed,
                                   std::string         & errText);
 
 
@@ -85,15 +84,12 @@ private:
 
 
   FFTGrid * upscaling_kernel_;
-  std::vector<std::vector<std::vector<int> > > lag_index_;  // eller ha som klassevar i gravimetric inversion-klassen, hrer vel mer hjemme der.
 
   ModelGeneral * modelGeneral_;
 
   void MakeUpscalingKernel(ModelSettings * modelSettings,
                            const Simbox  * fullTimeSimbox);
 
-  void MakeLagIndex(int nx_upscaled, int ny_upscaled, int nz_upscaled);
-
   void SetUpscaledPaddingSize(const Simbox * fullTimeSimbox);
 
 };
@@ -207,6 +207,7 @@ ModelSettings::ModelSettings(void)
 
   seed_                    =        0;
   number_of_threads_       =        0;
+  max_interval_memory_     =      0.0;
 
   erosion_priority_top_surface_ = 1;
 
@@ -43,6 +43,7 @@ public:
   TraceHeaderFormat              * getTraceHeaderFormatBackground(int i)const { return traceHeaderFormatBackground_[i]            ;}
   TraceHeaderFormat              * getTraceHeaderFormat(int i, int j)   const { return timeLapseLocalTHF_[i][j]                   ;}
   int                              getNumberOfThreads(void)             const { return number_of_threads_                         ;}
+  float                            getMaxIntervalMemory(void)           const { return max_interval_memory_                       ;}
   int                              getNumberOfTraceHeaderFormats(int i) const { return static_cast<int>(timeLapseLocalTHF_[i].size());}
   int                              getKrigingParameter(void)            const { return krigingParameter_                          ;}
   float                            getConstBackValue(int i)             const { return constBackValue_[i]                         ;}
@@ -347,6 +348,7 @@ public:
   void addWellRelativeCoord(bool relative)                { wellRelativeCoord_.push_back(relative)               ;}
 
   void setNumberOfThreads(int n_threads)                  { number_of_threads_        = n_threads                ;}
+  void setMaxIntervalMemory(float max_memory)             { max_interval_memory_      = max_memory               ;}
   void setNumberOfWells(int nWells)                       { nWells_                   = nWells                   ;}
   void setNumberOfSimulations(int nSimulations)           { nSimulations_             = nSimulations             ;}
   void setVpMin(float vp_min)                             { vp_min_                   = vp_min                   ;}
@@ -703,6 +705,7 @@ private:
   std::map<std::string, std::map<std::string, float> > volumeFraction_;  ///< map interval map facies name
 
   int                               number_of_threads_;
+  float                             max_interval_memory_;         ///< Memory (MB) allowed for intervals set up concurrently. 0 = no limit.
   int                               nWells_;
   int                               nSimulations_;
 
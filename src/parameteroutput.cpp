@@ -638,18 +638,22 @@ ParameterOutput::WriteResampledStormCube(const StormContGrid * storm_grid,
 {
   // simbox is related to the cube we resample from. gridmapping contains simbox for the cube we resample to.
 
-  float time, kindex;
   StormContGrid *mapping = gridmapping->getMapping();
   StormContGrid *outgrid = new StormContGrid(*mapping);
 
-  double x,y;
-  int nz = static_cast<int>(mapping->GetNK());
-  for (int i = 0; i < static_cast<int>(storm_grid->GetNI()); i++) {
-    for (int j = 0; j < static_cast<int>(storm_grid->GetNJ()); j++) {
-      simbox->getXYCoord(i,j,x,y);
+  int    ni = static_cast<int>(storm_grid->GetNI());
+  int    nj = static_cast<int>(storm_grid->GetNJ());
+  int    nz = static_cast<int>(mapping->GetNK());
+  double dz = simbox->getdz();
+#ifdef PARALLEL
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(gridmapping->getNumberOfThreads())
+#endif
+  for (int i = 0; i < ni; i++) {
+    for (int j = 0; j < nj; j++) {
+      float top = static_cast<float>(simbox->getTop(i,j));
       for (int k = 0; k < nz; k++) {
-        time   = (*mapping)(i,j,k);
-        kindex = float((time - static_cast<float>(simbox->getTop(x,y)))/simbox->getdz());
+        float time   = (*mapping)(i,j,k);
+        float kindex = float((time - top)/dz);
 
         float value = storm_grid->GetValueInterpolated(i, j, kindex);
 
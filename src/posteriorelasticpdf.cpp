@@ -42,6 +42,20 @@ void PosteriorElasticPDF::CalculateTransform2D(const std::vector<double>
   }
 }
 
+void PosteriorElasticPDF::FindDensities(const PosteriorElasticPDF * const * pdfs,
+                                        int                                 n,
+                                        const double                      & vp,
+                                        const double                      & vs,
+                                        const double                      & rho,
+                                        const double                      & s1,
+                                        const double                      & s2,
+                                        const Simbox              * const   volume,
+                                        double                            * density) const
+{
+  for (int i = 0; i < n; i++)
+    density[i] = pdfs[i]->FindDensity(vp, vs, rho, s1, s2, volume);
+}
+
 void PosteriorElasticPDF::InvertSquareMatrix(NRLib::Matrix  & matrix,//double   ** matrix,
                                              NRLib::Matrix  & inv_matrix,//double   ** inv_matrix,
                                              int              n)
@@ -41,6 +41,19 @@ public:
                              const double & s2 = 0,
                              const Simbox * const volume = 0) const = 0;
 
+  // FindDensity for the n densities in pdfs at the same point. The densities must be of the
+  // same type and on the same grid as this one, as the facies densities are. Subclasses find
+  // the interpolation indexes and weights once and reuse them for all densities.
+  virtual void FindDensities(const PosteriorElasticPDF * const * pdfs,
+                             int                                 n,
+                             const double                      & vp,
+                             const double                      & vs,
+                             const double                      & rho,
+                             const double                      & s1,
+                             const double                      & s2,
+                             const Simbox              * const   volume,
+                             double                            * density) const;
+
   virtual void  ResampleAndWriteDensity(const std::string & fileName,
                                         const Simbox      * origVol,
                                         Simbox            * volume,
@@ -67,9 +80,9 @@ protected:
                             std::vector<std::vector<double> >        & x, // either 2 x 3 or 3 x 3
                             const NRLib::Matrix                      & v);
 
-  void InvertSquareMatrix(NRLib::Matrix               & matrix,     //matrix to be inverted
-                          NRLib::Matrix               & inv_matrix,  //inverted matrix
-                          int                           n);         // size
+  static void InvertSquareMatrix(NRLib::Matrix        & matrix,     //matrix to be inverted
+                                 NRLib::Matrix        & inv_matrix,  //inverted matrix
+                                 int                    n);         // size
 
   void SetupSmoothingGaussian2D(FFTGrid                   * smoother,
                                 const NRLib::Matrix       & sigma_inv,
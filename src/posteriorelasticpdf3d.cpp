@@ -21,7 +21,8 @@ PosteriorElasticPDF3D::PosteriorElasticPDF3D(const std::vector<double> & d1,
                  double                                                  d2_max,
                  double                                                  d3_min,
                  double                                                  d3_max,
-                 int                                                     ind)
+                 int                                                     ind,
+                 FFTGrid                                               * smoother)
                  :
 n1_(n1),
 n2_(n2),
@@ -39,102 +40,39 @@ z_max_(d3_max)
 
   int dim = static_cast<int>(d1.size());
 
-  histogram_ = new FFTGrid(n1_, n2_, n3_, n1_, n2_, n3_);
-  histogram_->createRealGrid(false);
-  int rnxp = histogram_->getRNxp();
-  histogram_->setType(FFTGrid::PARAMETER);
-  histogram_->setAccessMode(FFTGrid::WRITE);
-
-  for(int l=0;l<n3_;l++){
-    for(int k=0;k<n2_;k++){
-      for(int j=0;j<rnxp;j++)
-        histogram_->setNextReal(0.0f);
-    }
-  }
-  histogram_->endAccess();
-
   // Spacing variables in the density grid
   dx_ = (x_max_ - x_min_)/n1_;
   dy_ = (y_max_ - y_min_)/n2_;
   dz_ = (z_max_ - z_min_)/n3_;
 
   // Go through data points and place in bins in histogram
-
+  std::vector<int> i_ind(dim);
+  std::vector<int> j_ind(dim);
+  std::vector<int> k_ind(dim);
   for (int i = 0; i < dim; i++){
     //volume->getIndexes(d1[i], d2[i], d3[i], i_tmp, j_tmp, k_tmp);
-    int i_tmp = static_cast<int>(floor((d1[i]-x_min_)/dx_));
-    int j_tmp = static_cast<int>(floor((d2[i]-y_min_)/dy_));
-    int k_tmp = static_cast<int>(floor((d3[i]-z_min_)/dz_));
-    // Counting data points in index (i,j,k)
-    histogram_->setAccessMode(FFTGrid::RANDOMACCESS);
-    histogram_->setRealValue(i_tmp,j_tmp,k_tmp, histogram_->getRealValue(i_tmp,j_tmp,k_tmp) + 1.0f);
-    histogram_->endAccess();
+    i_ind[i] = static_cast<int>(floor((d1[i]-x_min_)/dx_));
+    j_ind[i] = static_cast<int>(floor((d2[i]-y_min_)/dy_));
+    k_ind[i] = static_cast<int>(floor((d3[i]-z_min_)/dz_));
   }
 
-  //multiply by normalizing constant for the PDF - dim is the total number of entries
-  histogram_->setAccessMode(FFTGrid::READANDWRITE);
-  histogram_->multiplyByScalar(float(1.0f/dim));
-  histogram_->endAccess();
-
-  if(ModelSettings::getDebugLevel() >= 1){
-    std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
-    std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
-    histogram_->writeAsciiFile(fileName);
-  }
+  MakeHistogram(i_ind, j_ind, k_ind, ind);
 
   histogram_->fftInPlace();
 
-  NRLib::Matrix sigma_tmp(3,3);
-
-  /*
-  double **sigma_tmp = new double *[3];
-  for (int i=0;i<3;i++){
-    sigma_tmp[i] = new double[3];
-  }
-  */
-  for(int i=0;i<3;i++){
-    for(int j=0; j<3; j++)
-      sigma_tmp(i,j) = sigma[i][j];
-    }
-  // Matrix inversion of the covariance matrix sigma
-  NRLib::Matrix sigma_inv;
-  /*
-  double **sigma_inv = new double *[3];
-  for(int i=0; i<3; i++)
-    sigma_inv[i] = new double [3];
-  */
-
-  InvertSquareMatrix(sigma_tmp,sigma_inv,3);
-
-  FFTGrid *smoother = new FFTGrid(n1, n2, n3, n1, n2, n3);
-
-  smoother->createRealGrid(false);
-  smoother->setType(FFTGrid::PARAMETER);
-  smoother->setAccessMode(FFTGrid::WRITE);
-  for(int l=0;l<n3_;l++){
-      for(int k=0;k<n2_;k++){
-        for(int j=0;j<static_cast<int>(smoother->getRNxp());j++)
-          smoother->setNextReal(0.0f);
-      }
-  }
-  smoother->endAccess();
-
-  SetupSmoothingGaussian3D(smoother, sigma_inv);
-
-  if(ModelSettings::getDebugLevel() >= 1) {
-    std::string baseName = "Smoother" + IO::SuffixAsciiFiles();
-    std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
-    smoother->writeAsciiFile(fileName);
+  FFTGrid * own_smoother = NULL;
+  if (smoother == NULL) {
+    own_smoother = MakeSmoother3D(sigma, n1_, n2_, n3_, x_min_, x_max_, y_min_, y_max_, z_min_, z_max_);
+    smoother     = own_smoother;
   }
 
   // Carry out multiplication of the smoother with the density grid (histogram) in the Fourier domain
-  smoother->fftInPlace();
   histogram_->multiply(smoother);
   histogram_->invFFTInPlace();
   histogram_->multiplyByScalar(sqrt(float(n1_*n2_*n3_)));
   histogram_->endAccess();
 
-  delete smoother;
+  delete own_smoother;
 }
 
 PosteriorElasticPDF3D::PosteriorElasticPDF3D(const std::vector<double>               & d1,        // first dimension of data points
@@ -186,48 +124,21 @@ PosteriorElasticPDF3D::PosteriorElasticPDF3D(const std::vector<double>
   //computes x and y from d1, d2 and d3
   CalculateTransform2D(d1, d2, d3, x, v);
 
-  histogram_ = new FFTGrid(n1_, n2_, n3_, n1_, n2_, n3_);
-  histogram_->createRealGrid(false);
-  int rnxp = histogram_->getRNxp();
-  histogram_->setType(FFTGrid::PARAMETER);
-  histogram_->setAccessMode(FFTGrid::WRITE);
-
-  for(int l=0;l<n3_;l++){
-    for(int k=0;k<n2_;k++){
-      for(int j=0;j<rnxp;j++)
-        histogram_->setNextReal(0.0f);
-    }
-  }
-  histogram_->endAccess();
-
   // Spacing variables in the density grid
   dx_ = (x_max_ - x_min_)/n1_;
   dy_ = (y_max_ - y_min_)/n2_;
   dz_ = (z_max_ - z_min_)/n3_;
 
   // Go through data points and place in bins in histogram
-
+  std::vector<int> i_ind(dim);
+  std::vector<int> j_ind(dim);
   for (int i = 0; i < dim; i++){
     //volume->getIndexes(d1[i], d2[i], d3[i], i_tmp, j_tmp, k_tmp);
-    int i_tmp = static_cast<int>(floor((x[0][i]-x_min_)/dx_));
-    int j_tmp = static_cast<int>(floor((x[1][i]-y_min_)/dy_));
-    int k_tmp = t1[i];
-    // Counting data points in index (i,j,k)
-    histogram_->setAccessMode(FFTGrid::RANDOMACCESS);
-    histogram_->setRealValue(i_tmp, j_tmp, k_tmp, histogram_->getRealValue(i_tmp,j_tmp,k_tmp) + 1.0f);
-    histogram_->endAccess();
+    i_ind[i] = static_cast<int>(floor((x[0][i]-x_min_)/dx_));
+    j_ind[i] = static_cast<int>(floor((x[1][i]-y_min_)/dy_));
   }
 
-  //multiply by normalizing constant for the PDF - dim is the total number of entries
-  histogram_->setAccessMode(FFTGrid::READANDWRITE);
-  histogram_->multiplyByScalar(float(1.0f/dim));
-  histogram_->endAccess();
-
-  if(ModelSettings::getDebugLevel() >= 1){
-    std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
-    std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
-    histogram_->writeAsciiFile(fileName);
-  }
+  MakeHistogram(i_ind, j_ind, t1, ind);
 
   histogram_->fftInPlace();
 
@@ -361,53 +272,139 @@ void PosteriorElasticPDF3D::ResampleAndWriteDensity(const std::string & fileName
                     TraceHeaderFormat(TraceHeaderFormat::SEISWORKS), false, scientific_format, header_lines);
 }
 
+FFTGrid * PosteriorElasticPDF3D::MakeSmoother3D(const double *const*const sigma,
+                                                int                       n1,
+                                                int                       n2,
+                                                int                       n3,
+                                                double                    d1_min,
+                                                double                    d1_max,
+                                                double                    d2_min,
+                                                double                    d2_max,
+                                                double                    d3_min,
+                                                double                    d3_max)
+{
+  NRLib::Matrix sigma_tmp(3,3);
+  for(int i=0;i<3;i++){
+    for(int j=0; j<3; j++)
+      sigma_tmp(i,j) = sigma[i][j];
+  }
+
+  // Matrix inversion of the covariance matrix sigma
+  NRLib::Matrix sigma_inv;
+  InvertSquareMatrix(sigma_tmp,sigma_inv,3);
+
+  FFTGrid *smoother = new FFTGrid(n1, n2, n3, n1, n2, n3);
+  smoother->createRealGrid(false);
+  smoother->setType(FFTGrid::PARAMETER);
+
+  SetupSmoothingGaussian3D(smoother, sigma_inv, n1, n2, n3,
+                           (d1_max - d1_min)/n1, (d2_max - d2_min)/n2, (d3_max - d3_min)/n3);
+
+  if(ModelSettings::getDebugLevel() >= 1) {
+    std::string baseName = "Smoother" + IO::SuffixAsciiFiles();
+    std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
+    smoother->writeAsciiFile(fileName);
+  }
+
+  smoother->fftInPlace();
+
+  return smoother;
+}
+
+void PosteriorElasticPDF3D::MakeHistogram(const std::vector<int> & i_ind,
+                                          const std::vector<int> & j_ind,
+                                          const std::vector<int> & k_ind,
+                                          int                      ind)
+{
+  int dim = static_cast<int>(i_ind.size());
+
+  // Count the data points in a plain array, as indexes outside the grid are skipped
+  std::vector<float> count(n1_*n2_*n3_, 0.0f);
+  for (int i = 0; i < dim; i++) {
+    if (i_ind[i] >= 0 && i_ind[i] < n1_ && j_ind[i] >= 0 && j_ind[i] < n2_ && k_ind[i] >= 0 && k_ind[i] < n3_)
+      count[i_ind[i] + j_ind[i]*n1_ + k_ind[i]*n1_*n2_] += 1.0f;
+  }
+
+  //multiply by normalizing constant for the PDF - dim is the total number of entries
+  float scale = float(1.0f/dim);
+
+  histogram_ = new FFTGrid(n1_, n2_, n3_, n1_, n2_, n3_);
+  histogram_->createRealGrid(false);
+  int rnxp = histogram_->getRNxp();
+  histogram_->setType(FFTGrid::PARAMETER);
+  histogram_->setAccessMode(FFTGrid::WRITE);
+  for(int l=0;l<n3_;l++){
+    for(int k=0;k<n2_;k++){
+      for(int j=0;j<rnxp;j++) {
+        if (j < n1_)
+          histogram_->setNextReal(count[j + k*n1_ + l*n1_*n2_]*scale);
+        else
+          histogram_->setNextReal(0.0f);
+      }
+    }
+  }
+  histogram_->endAccess();
+
+  if(ModelSettings::getDebugLevel() >= 1){
+    std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
+    std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
+    histogram_->writeAsciiFile(fileName);
+  }
+}
+
 void PosteriorElasticPDF3D::SetupSmoothingGaussian3D(FFTGrid              * smoother,
-                                                     const NRLib::Matrix  & sigma_inv)
+                                                     const NRLib::Matrix  & sigma_inv,
+                                                     int                    n1,
+                                                     int                    n2,
+                                                     int                    n3,
+                                                     double                 dx,
+                                                     double                 dy,
+                                                     double                 dz)
 {
-  float *smooth = new float[n1_*n2_*n3_];
+  float *smooth = new float[n1*n2*n3];
   int j,k,l,jj,jjj,kk,kkk,ll,lll;
   lll=2;
 
   float sum = 0.0f;
-  for(l=0; l<n3_; l++) {
+  for(l=0; l<n3; l++) {
     kkk=2;
-    if(l<=n3_/2)
+    if(l<=n3/2)
       ll = l;
     else {
       ll = -(l-lll);
       lll+=2;
     }
-    for(k=0; k<n2_; k++) {
+    for(k=0; k<n2; k++) {
       jjj=2;
-      if(k<=n2_/2)
+      if(k<=n2/2)
         kk=k;
       else {
         kk = -(k-kkk);
         kkk+=2;
       }
-      for(j=0; j<n1_; j++) {
-        if(j<=n1_/2)
+      for(j=0; j<n1; j++) {
+        if(j<=n1/2)
           jj=j;
         else {
           jj = -(j-jjj);
           jjj+=2;
         }
-        smooth[j+k*n1_+l*n1_*n2_] = float(exp(-0.5f*(jj*dx_*jj*dx_*sigma_inv(0,0)
-                                                   +kk*dy_*kk*dy_*sigma_inv(1,1)
-                                                   +ll*dz_*ll*dz_*sigma_inv(2,2)
-                                                   +2*jj*dx_*kk*dy_*sigma_inv(1,0)
-                                                   +2*jj*dx_*ll*dz_*sigma_inv(2,0)
-                                                   +2*kk*dy_*ll*dz_*sigma_inv(2,1))));
-        sum += smooth[j+k*n1_+l*n1_*n2_];
+        smooth[j+k*n1+l*n1*n2] = float(exp(-0.5f*(jj*dx*jj*dx*sigma_inv(0,0)
+                                                +kk*dy*kk*dy*sigma_inv(1,1)
+                                                +ll*dz*ll*dz*sigma_inv(2,2)
+                                                +2*jj*dx*kk*dy*sigma_inv(1,0)
+                                                +2*jj*dx*ll*dz*sigma_inv(2,0)
+                                                +2*kk*dy*ll*dz*sigma_inv(2,1))));
+        sum += smooth[j+k*n1+l*n1*n2];
       }
     }
   }
 
   // normalize smoother
-  for(l=0;l<n3_;l++)
-    for(k=0;k<n2_;k++)
-      for(j=0;j<n1_;j++)
-        smooth[j+k*n1_+l*n1_*n2_]/=sum;
+  for(l=0;l<n3;l++)
+    for(k=0;k<n2;k++)
+      for(j=0;j<n1;j++)
+        smooth[j+k*n1+l*n1*n2]/=sum;
 
   smoother->fillInFromArray(smooth); //No mode/randomaccess
   //normalizing constant for the smoother
@@ -519,12 +516,45 @@ double PosteriorElasticPDF3D::FindDensity(const double & vp,
                                           const double & s2,
                                           const Simbox * const volume) const
 {
-  double value = 0.0;
+  const PosteriorElasticPDF * pdf = this;
+  double value;
+  FindDensities(&pdf, 1, vp, vs, rho, s1, s2, volume, &value);
+  return value;
+}
+
+void PosteriorElasticPDF3D::FindDensities(const PosteriorElasticPDF * const * pdfs,
+                                          int                                 n,
+                                          const double                      & vp,
+                                          const double                      & vs,
+                                          const double                      & rho,
+                                          const double                      & s1,
+                                          const double                      & s2,
+                                          const Simbox              * const   volume,
+                                          double                            * density) const
+{
+  (void) s2;
   // if the size of v1 and v2 > 0 the PDF has been constructed with dimension reduction and one trend value
   if (v1_.size()>0 && v2_.size()>0){
-    value = Density(vp, vs, rho, s1, s2);
-    if (value == RMISSING)
-      value = 0.0;
+    assert (v1_.size() == 3);
+
+    // Transform the elastic variables to 2D
+    double x = vp*v1_[0] + vs*v1_[1] + rho*v1_[2];
+    double y = vp*v2_[0] + vp*v2_[1] + rho*v2_[2];
+
+    int    index[8];
+    double weight[8];
+    int    n_corners;
+    bool   inside = histogram_->FindInterpolationWeights(x_min_, x_max_, y_min_, y_max_, z_min_, z_max_,
+                                                         x, y, s1, index, weight, n_corners);
+    for (int i = 0; i < n; i++) {
+      if (inside) {
+        const PosteriorElasticPDF3D * pdf = static_cast<const PosteriorElasticPDF3D *>(pdfs[i]);
+        assert (pdf->n1_ == n1_ && pdf->n2_ == n2_ && pdf->n3_ == n3_);
+        density[i] = pdf->histogram_->InterpolateWithWeights(index, weight, n_corners);
+      }
+      else
+        density[i] = 0.0;
+    }
   }
   else{
     double jFull, kFull, lFull;
@@ -582,18 +612,20 @@ double PosteriorElasticPDF3D::FindDensity(const double & vp,
       wl = static_cast<float>(lFull-l1);
     }
 
+    // The histograms are only read, so no access mode is set
+    for (int i = 0; i < n; i++) {
+      const FFTGrid * histogram = static_cast<const PosteriorElasticPDF3D *>(pdfs[i])->histogram_;
 
-      histogram_->setAccessMode(FFTGrid::RANDOMACCESS);
-      float value1 = std::max<float>(0,histogram_->getRealValue(j1,k1,l1));
-      float value2 = std::max<float>(0,histogram_->getRealValue(j1,k1,l2));
-      float value3 = std::max<float>(0,histogram_->getRealValue(j1,k2,l1));
-      float value4 = std::max<float>(0,histogram_->getRealValue(j1,k2,l2));
-      float value5 = std::max<float>(0,histogram_->getRealValue(j2,k1,l1));
-      float value6 = std::max<float>(0,histogram_->getRealValue(j2,k1,l2));
-      float value7 = std::max<float>(0,histogram_->getRealValue(j2,k2,l1));
-      float value8 = std::max<float>(0,histogram_->getRealValue(j2,k2,l2));
-      histogram_->endAccess();
+      float value1 = std::max<float>(0,histogram->getRealValue(j1,k1,l1));
+      float value2 = std::max<float>(0,histogram->getRealValue(j1,k1,l2));
+      float value3 = std::max<float>(0,histogram->getRealValue(j1,k2,l1));
+      float value4 = std::max<float>(0,histogram->getRealValue(j1,k2,l2));
+      float value5 = std::max<float>(0,histogram->getRealValue(j2,k1,l1));
+      float value6 = std::max<float>(0,histogram->getRealValue(j2,k1,l2));
+      float value7 = std::max<float>(0,histogram->getRealValue(j2,k2,l1));
+      float value8 = std::max<float>(0,histogram->getRealValue(j2,k2,l2));
 
+      double value = 0.0;
       value += (1.0f-wj)*(1.0f-wk)*(1.0f-wl)*value1;
       value += (1.0f-wj)*(1.0f-wk)*(     wl)*value2;
       value += (1.0f-wj)*(     wk)*(1.0f-wl)*value3;
@@ -602,7 +634,8 @@ double PosteriorElasticPDF3D::FindDensity(const double & vp,
       value += (     wj)*(1.0f-wk)*(     wl)*value6;
       value += (     wj)*(     wk)*(1.0f-wl)*value7;
       value += (     wj)*(     wk)*(     wl)*value8;
-  }
 
-  return value;
+      density[i] = value;
+    }
+  }
 }
@@ -28,7 +28,8 @@ public:
                         double                                        d2_max,
                         double                                        d3_min,
                         double                                        d3_max,
-                        int                                           ind = 0);
+                        int                                           ind = 0,
+                        FFTGrid                                     * smoother = NULL); // Transformed kernel from MakeSmoother3D, made here if NULL
 
   // (ii) Constructor with dimension reduction: input: three elastic parameters and one trend variable
   PosteriorElasticPDF3D(const std::vector<double>                   & d1, // first dimension of data points
@@ -80,8 +81,31 @@ public:
                              const double & s2 = 0,
                              const Simbox * const volume = 0) const;
 
+  virtual void FindDensities(const PosteriorElasticPDF * const * pdfs,
+                             int                                 n,
+                             const double                      & vp,
+                             const double                      & vs,
+                             const double                      & rho,
+                             const double                      & s1,
+                             const double                      & s2,
+                             const Simbox              * const   volume,
+                             double                            * density) const;
+
   //virtual void WriteAsciiFile(std::string filename) const;
 
+  // Fourier transform of the Gaussian smoothing kernel used by constructor (i). Densities
+  // on the same grid and with the same kernel can share it. The caller owns the grid.
+  static FFTGrid * MakeSmoother3D(const double *const*const smoothvar,
+                                  int                       n1,
+                                  int                       n2,
+                                  int                       n3,
+                                  double                    d1_min,
+                                  double                    d1_max,
+                                  double                    d2_min,
+                                  double                    d2_max,
+                                  double                    d3_min,
+                                  double                    d3_max);
+
   virtual void ResampleAndWriteDensity(const std::string & fileName,
                                        const Simbox      * origVol,
                                        Simbox            * volume,
@@ -119,8 +143,19 @@ private:
   double z_max_;
   double dz_;
 
-  void SetupSmoothingGaussian3D(FFTGrid                 * smoother,
-                                const NRLib::Matrix     & sigmainv);
+  void MakeHistogram(const std::vector<int> & i_ind,
+                     const std::vector<int> & j_ind,
+                     const std::vector<int> & k_ind,
+                     int                      ind);
+
+  static void SetupSmoothingGaussian3D(FFTGrid                 * smoother,
+                                       const NRLib::Matrix     & sigmainv,
+                                       int                       n1,
+                                       int                       n2,
+                                       int                       n3,
+                                       double                    dx,
+                                       double                    dy,
+                                       double                    dz);
 
   void SetupSmoothingGaussian2D(FFTGrid    * smoother,
                                 double    ** sigmainv,
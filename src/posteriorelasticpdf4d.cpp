@@ -250,8 +250,49 @@ double PosteriorElasticPDF4D::FindDensity(const double & vp,
                                           const double & rho,
                                           const double & s1,
                                           const double & s2,
-                                          const Simbox * const /*volume*/) const{
-  return Density(vp, vs, rho, s1, s2);
+                                          const Simbox * const volume) const{
+  const PosteriorElasticPDF * pdf = this;
+  double value;
+  FindDensities(&pdf, 1, vp, vs, rho, s1, s2, volume, &value);
+  return value;
+}
+
+void PosteriorElasticPDF4D::FindDensities(const PosteriorElasticPDF * const * pdfs,
+                                          int                                 n,
+                                          const double                      & vp,
+                                          const double                      & vs,
+                                          const double                      & rho,
+                                          const double                      & s1,
+                                          const double                      & s2,
+                                          const Simbox              * const   /*volume*/,
+                                          double                            * density) const
+{
+  for (int i = 0; i < n; i++)
+    density[i] = 0.0;
+
+  // If the trend values are outside the grid, the probability is 0
+  if (s1<t1_min_ || s1> t1_max_ || s2<t2_min_ || s2>t2_max_)
+    return;
+
+  double x = vp*v1_[0] + vs*v1_[1] + rho*v1_[2];
+  double y = vp*v2_[0] + vp*v2_[1] + rho*v2_[2];
+
+  int i_t1 = static_cast<int>(floor((s1-t1_min_)/dt1_));
+  int j_t2 = static_cast<int>(floor((s2-t2_min_)/dt2_));
+
+  // All densities share grid, so the weights are found from this one
+  int    index[8];
+  double weight[8];
+  int    n_corners;
+  if (histogram_(i_t1,j_t2)->FindInterpolationWeights(x_min_, x_max_, y_min_, y_max_, 0, 0,
+                                                      x, y, 0, index, weight, n_corners) == false)
+    return;
+
+  for (int i = 0; i < n; i++) {
+    const PosteriorElasticPDF4D * pdf = static_cast<const PosteriorElasticPDF4D *>(pdfs[i]);
+    assert (pdf->nx_ == nx_ && pdf->ny_ == ny_);
+    density[i] = pdf->histogram_(i_t1,j_t2)->InterpolateWithWeights(index, weight, n_corners);
+  }
 }
 
 void PosteriorElasticPDF4D::ResampleAndWriteDensity(const std::string & /*fileName*/,
@@ -74,6 +74,16 @@ public:
                              const double & s2 = 0,
                              const Simbox * const volume = 0) const;
 
+  virtual void FindDensities(const PosteriorElasticPDF * const * pdfs,
+                             int                                 n,
+                             const double                      & vp,
+                             const double                      & vs,
+                             const double                      & rho,
+                             const double                      & s1,
+                             const double                      & s2,
+                             const Simbox              * const   volume,
+                             double                            * density) const;
+
   void WriteAsciiFile(std::string filename,
                       int         i,
                       int         j) const;
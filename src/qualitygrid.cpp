@@ -92,7 +92,12 @@ void QualityGrid::generateProbField(FFTGrid                                   *&
 
   const bool isFile = model_settings->getFileGrid();
 
-  makeKrigedProbField(krigingData, grid, simbox, cov, isFile);
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(model_settings->getNumberOfThreads(), 1);
+#endif
+
+  makeKrigedProbField(krigingData, grid, simbox, cov, isFile, n_threads);
 
   delete &cov;
 }
@@ -132,7 +137,8 @@ void QualityGrid::makeKrigedProbField(std::vector<KrigingData2D> & krigingData,
                                       FFTGrid                   *& grid,
                                       const Simbox               * simbox,
                                       const CovGrid2D            & cov,
-                                      const bool                   isFile) const
+                                      const bool                   isFile,
+                                      int                          n_threads) const
 {
   std::string text = "\nBuilding seismic quality grid:";
   LogKit::LogFormatted(LogKit::Low, text);
@@ -152,9 +158,24 @@ void QualityGrid::makeKrigedProbField(std::vector<KrigingData2D> & krigingData,
   const double ly = simbox->getly();
 
   //
-  // Template surface to be kriged
+  // The layers are kriged in blocks of consecutive layers. Layers in a block
+  // with data at the same locations share one kriging factorisation. Each
+  // block is kriged by one thread into its own surfaces, and written to the
+  // grid in layer order. Blocks hold at most a few layers, so at most a few
+  // surfaces per thread are kept in memory, whatever nz is. A longer run of
+  // shared locations only costs one extra factorisation per block.
   //
-  NRLib::RegularSurface<double> surface(x0, y0, lx, ly, nx, ny, RMISSING);
+  const int blockSize = 8;
+
+  std::vector<int> blockStart(1, 0);
+  for (int k=1; k<nzp; k++) {
+    bool sameLocations = krigingData[k].getIndexI() == krigingData[k-1].getIndexI()
+                      && krigingData[k].getIndexJ() == krigingData[k-1].getIndexJ();
+    if (!sameLocations || k - blockStart.back() == blockSize)
+      blockStart.push_back(k);
+  }
+  blockStart.push_back(nzp);
+  const int nBlocks = static_cast<int>(blockStart.size()) - 1;
 
   const float monitorSize = std::max(1.0f, static_cast<float>(nz)*0.02f);
   float nextMonitor = monitorSize;
@@ -168,30 +189,48 @@ void QualityGrid::makeKrigedProbField(std::vector<KrigingData2D> & krigingData,
   grid->setType(FFTGrid::PARAMETER);
   grid->setAccessMode(FFTGrid::WRITE);
 
-  for (int k=0; k<nzp; k++)
+#ifdef PARALLEL
+#pragma omp parallel for ordered schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (int b=0; b<nBlocks; b++)
   {
-    // Set constant value for layer
-    surface.Assign(value_);
-
-    // Kriging of layer
-    Kriging2D::krigSurface(surface, krigingData[k], cov);
-
-    // Set layer in probability field from surface
-    for (int j=0; j<nyp; j++){
-      for (int i=0; i<rnxp; i++){
-        if (i<nxp)
-          grid->setNextReal(float(surface(i,j)));
-        else
-          grid->setNextReal(0); // Dummy in padding
-      }
-    }
+    const int kStart = blockStart[b];
+    const int kEnd   = blockStart[b+1];
 
-    // Log process
-    if (k+1 >= static_cast<int>(nextMonitor))
+    // Set constant value for the layers of this block, and krige them
+    std::vector<NRLib::RegularSurface<double> > surfaces(kEnd - kStart, NRLib::RegularSurface<double>(x0, y0, lx, ly, nx, ny, value_));
+    std::vector<Grid2D *>                       trends(kEnd - kStart);
+    for (int k=kStart; k<kEnd; k++)
+      trends[k-kStart] = &surfaces[k-kStart];
+
+    std::vector<KrigingData2D> blockData(krigingData.begin() + kStart, krigingData.begin() + kEnd);
+    Kriging2D::krigSurfaces(trends, blockData, cov);
+
+#ifdef PARALLEL
+#pragma omp ordered
+#endif
     {
-      nextMonitor += monitorSize;
-      std::cout << "^";
-      fflush(stdout);
+      for (int k=kStart; k<kEnd; k++)
+      {
+        // Set layer in probability field from surface
+        const NRLib::RegularSurface<double> & surface = surfaces[k-kStart];
+        for (int j=0; j<nyp; j++){
+          for (int i=0; i<rnxp; i++){
+            if (i<nxp)
+              grid->setNextReal(float(surface(i,j)));
+            else
+              grid->setNextReal(0); // Dummy in padding
+          }
+        }
+
+        // Log process
+        if (k+1 >= static_cast<int>(nextMonitor))
+        {
+          nextMonitor += monitorSize;
+          std::cout << "^";
+          fflush(stdout);
+        }
+      }
     }
   }
 
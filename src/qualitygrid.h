@@ -43,7 +43,8 @@ private:
                            FFTGrid                   *& grid,
                            const Simbox               * simbox,
                            const CovGrid2D            & cov,
-                           const bool                   isFile) const;
+                           const bool                   isFile,
+                           int                          n_threads) const;
 
   CovGrid2D & MakeCovGrid2D(const Simbox * simbox,
                             Vario  * vario) const;
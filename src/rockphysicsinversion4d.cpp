@@ -3,8 +3,14 @@
 #include "src/fftgrid.h"
 #include "lib/lib_matr.h"
 #include <vector>
+#include <algorithm>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
 
 RockPhysicsInversion4D::RockPhysicsInversion4D()
+: n_threads_(1)
 {
 
 }
@@ -14,20 +20,16 @@ RockPhysicsInversion4D::~RockPhysicsInversion4D()
  for(int i =0;i<4;i++)
    fftw_free(smoothingFilter_[i]);
 
- for(int i=0; i<2; i++){
-    for (int j=0; j<nf_[0]; j++){
-      delete meanRockPrediction_(i,j);
-    }
-  }
-
  fftwnd_destroy_plan(fftplan1_);
  fftwnd_destroy_plan(fftplan2_);
 }
 
-RockPhysicsInversion4D::RockPhysicsInversion4D(NRLib::Vector                      priorMean,
-                                               NRLib::Matrix                      priorCov,
-                                               NRLib::Matrix                      posteriorCov,
-                                               std::vector<std::vector<double> >  mSamp)
+RockPhysicsInversion4D::RockPhysicsInversion4D(NRLib::Vector                              priorMean,
+                                               NRLib::Matrix                              priorCov,
+                                               NRLib::Matrix                              posteriorCov,
+                                               const std::vector<std::vector<double> >  & mSamp,
+                                               int                                        n_threads)
+: n_threads_(std::max(n_threads, 1))
 {
   nf_.resize(4);
   nf_[0] = 60;
@@ -36,8 +38,15 @@ RockPhysicsInversion4D::RockPhysicsInversion4D(NRLib::Vector
   nf_[3] = 60;
   nfp_= 135;
 
-  fftplan1_ = rfftwnd_create_plan(1, &nfp_, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
-  fftplan2_ = rfftwnd_create_plan(1, &nfp_, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
+  // The plans are shared by the threads smoothing the tables. FFTW_THREADSAFE
+  // makes them read-only, so they can be executed by several threads at once.
+#ifdef PARALLEL
+#pragma omp critical (fftw_plan)
+#endif
+  {
+    fftplan1_ = rfftwnd_create_plan(1, &nfp_, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
+    fftplan2_ = rfftwnd_create_plan(1, &nfp_, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
+  }
 
   v_.resize(4,6);
   SolveGEVProblem(priorCov,posteriorCov, v_);
@@ -102,7 +111,7 @@ RockPhysicsInversion4D::RockPhysicsInversion4D(NRLib::Vector
 }
 
 void
-RockPhysicsInversion4D::makeNewPredictionTable(std::vector<std::vector<double> >  mSamp,std::vector<double>   rSamp)
+RockPhysicsInversion4D::makeNewPredictionTable(const std::vector<std::vector<double> >  & mSamp,const std::vector<double>   & rSamp)
 {
   ClearContentInPredictionTable( );
   fillInTable( mSamp,rSamp,1);
@@ -112,29 +121,17 @@ RockPhysicsInversion4D::makeNewPredictionTable(std::vector<std::vector<double> >
 void
 RockPhysicsInversion4D::allocatePredictionTables( )
 {
-   meanRockPrediction_.Resize(2,nf_[0],NULL);
-
-  for(int i=0; i<2; i++){
-    for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(i,j) = new FFTGrid(nf_[1], nf_[2], nf_[3], nf_[1], nf_[2], nf_[3]);
-      meanRockPrediction_(i,j)->setType(FFTGrid::PARAMETER);
-      meanRockPrediction_(i,j)->setAccessMode(FFTGrid::WRITE);
-      meanRockPrediction_(i,j)->fillInConstant(0.0, false);
-      meanRockPrediction_(i,j)->endAccess();
-    }
-  }
+  size_t table_size = static_cast<size_t>(nf_[0])*nf_[1]*nf_[2]*nf_[3];
 
+  meanRockPrediction_.resize(2);
+  for(int i=0; i<2; i++)
+    meanRockPrediction_[i].assign(table_size, 0.0f);
 }
 
 void
 RockPhysicsInversion4D::ClearContentInPredictionTable( )
 {
-  for (int j=0; j<nf_[0]; j++){
-    meanRockPrediction_(1,j)->setAccessMode(FFTGrid::WRITE);
-    meanRockPrediction_(1,j)->fillInConstant(0.0);
-    meanRockPrediction_(1,j)->endAccess();
-  }
-
+  std::fill(meanRockPrediction_[1].begin(), meanRockPrediction_[1].end(), 0.0f);
 }
 
 FFTGrid *
@@ -157,30 +154,37 @@ RockPhysicsInversion4D::makePredictions(std::vector<FFTGrid *> mu_static_,
 
   for(int i=0;i<3;i++)
   {
-    mu_static_[i]->setAccessMode(FFTGrid::READ);
-    mu_dynamic_[i]->setAccessMode(FFTGrid::READ);
+    mu_static_[i]->setAccessMode(FFTGrid::RANDOMACCESS);
+    mu_dynamic_[i]->setAccessMode(FFTGrid::RANDOMACCESS);
   }
 
-  prediction->setAccessMode(FFTGrid::WRITE);
-
-  NRLib::Vector m(6);
+  prediction->setAccessMode(FFTGrid::RANDOMACCESS);
 
+  // Each layer is independent. The padding at the end of the FFT rows holds no values.
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads_)
+#endif
   for(int k=0;k<nzp;k++)
+  {
+    double m[6];
+    double f[4];
     for(int j=0;j<nyp;j++)
-      for(int i=0;i<rnxp;i++)
+    {
+      for(int i=0;i<nxp;i++)
       {
-        m(0)=mu_static_[0]->getNextReal();
-        m(1)=mu_static_[1]->getNextReal();
-        m(2)=mu_static_[2]->getNextReal();
-        m(3)=mu_dynamic_[0]->getNextReal();
-        m(4)=mu_dynamic_[1]->getNextReal();
-        m(5)=mu_dynamic_[2]->getNextReal();
-        float value;
-        NRLib::Vector f;
-        f=m*v_;
-        value = float( getPredictedValue(f) );
-        prediction->setNextReal(value);
+        m[0]=mu_static_[0]->getRealValue(i,j,k,true);
+        m[1]=mu_static_[1]->getRealValue(i,j,k,true);
+        m[2]=mu_static_[2]->getRealValue(i,j,k,true);
+        m[3]=mu_dynamic_[0]->getRealValue(i,j,k,true);
+        m[4]=mu_dynamic_[1]->getRealValue(i,j,k,true);
+        m[5]=mu_dynamic_[2]->getRealValue(i,j,k,true);
+        TransformToFactors(m, f);
+        prediction->setRealValue(i,j,k,float( getPredictedValue(f) ),true);
       }
+      for(int i=nxp;i<rnxp;i++)
+        prediction->setRealValue(i,j,k,0.0f,true);
+    }
+  }
 
   for(int i=0;i<3;i++)
   {
@@ -195,7 +199,7 @@ RockPhysicsInversion4D::makePredictions(std::vector<FFTGrid *> mu_static_,
 
 
 void
-RockPhysicsInversion4D::GetLowerIndexAndW(double minValue,double maxValue,int nValue,double valueIn,int& index, double& w)
+RockPhysicsInversion4D::GetLowerIndexAndW(double minValue,double maxValue,int nValue,double valueIn,int& index, double& w) const
 {
   double dx    = (maxValue-minValue)/float(nValue);
   double value=valueIn+dx/2; // value of cell center NBNB OK check
@@ -218,7 +222,7 @@ RockPhysicsInversion4D::GetLowerIndexAndW(double minValue,double maxValue,int nV
 }
 
 int
-RockPhysicsInversion4D::GetLowerIndex(double minValue,double maxValue,int nValue,double value)
+RockPhysicsInversion4D::GetLowerIndex(double minValue,double maxValue,int nValue,double value) const
 {
   double dx    = (maxValue-minValue)/float(nValue);
   int index = int(floor((value-minValue)/dx)); // bin number cell center
@@ -232,72 +236,64 @@ RockPhysicsInversion4D::GetLowerIndex(double minValue,double maxValue,int nValue
   return index;
 }
 
+void
+RockPhysicsInversion4D::TransformToFactors(const double * m, double * f) const
+{
+  for(int k=0;k<4;k++)
+  {
+    f[k]=0.0;
+    for(int l=0;l<6;l++)
+      f[k]+=m[l]*v_(l,k);
+  }
+}
 
 double
 RockPhysicsInversion4D::getPredictedValue(NRLib::Vector f)
+{
+  double fv[4];
+  for(int k=0;k<4;k++)
+    fv[k]=f(k);
+  return getPredictedValue(fv);
+}
+
+double
+RockPhysicsInversion4D::getPredictedValue(const double * f) const
 {
   //interploates in a 4D table
-  double value;
-  std::vector<std::vector<int> > indLoHi(2,std::vector<int>(4));
-  std::vector<std::vector<double> > wLoHi(2,std::vector<double>(4));
+  int    indLoHi[2][4];
+  double wLoHi[2][4];
   double w;
   int index;
-  GetLowerIndexAndW(minf_(0),maxf_(0),nf_[0],f(0),index, w);
-  wLoHi[0][0]=1-w;
-  wLoHi[1][0]=w;
-  indLoHi[0][0]=index;
-  indLoHi[1][0]=std::min(nf_[0]-1,index+1);
-
-  GetLowerIndexAndW(minf_(1),maxf_(1),nf_[1],f(1),index, w);
-  wLoHi[0][1]=1-w;
-  wLoHi[1][1]=w;
-  indLoHi[0][1]=index;
-  indLoHi[1][1]=std::min(nf_[1]-1,index+1);
-
-  GetLowerIndexAndW(minf_(2),maxf_(2),nf_[2],f(2),index, w);
-  wLoHi[0][2]=1-w;
-  wLoHi[1][2]=w;
-  indLoHi[0][2]=index;
-  indLoHi[1][2]=std::min(nf_[2]-1,index+1);
-
-  GetLowerIndexAndW(minf_(3),maxf_(3),nf_[3],f(3),index, w);
-  wLoHi[0][3]=1-w;
-  wLoHi[1][3]=w;
-  indLoHi[0][3]=index;
-  indLoHi[1][3]=std::min(nf_[3]-1,index+1);
-
-  value=0.0;
+  for(int d=0;d<4;d++)
+  {
+    GetLowerIndexAndW(minf_(d),maxf_(d),nf_[d],f[d],index, w);
+    wLoHi[0][d]=1-w;
+    wLoHi[1][d]=w;
+    indLoHi[0][d]=index;
+    indLoHi[1][d]=std::min(nf_[d]-1,index+1);
+  }
+
+  const std::vector<float> & table = meanRockPrediction_[1];
+
+  double value=0.0;
   for(int i0=0;i0<2;i0++)
     for(int i1=0;i1<2;i1++)
       for(int i2=0;i2<2;i2++)
         for(int i3=0;i3<2;i3++)
         {
           w=wLoHi[i0][0]*wLoHi[i1][1]*wLoHi[i2][2]*wLoHi[i3][3];
-          value+=w*GetGridValue(1,indLoHi[i0][0],indLoHi[i1][1],indLoHi[i2][2],indLoHi[i3][3]);
+          value+=w*table[GetTableIndex(indLoHi[i0][0],indLoHi[i1][1],indLoHi[i2][2],indLoHi[i3][3])];
         }
-return value;
-}
-
-double
-RockPhysicsInversion4D::GetGridValue(int TableNr,int i0,int i1,int i2,int i3)
-{
-  return meanRockPrediction_(TableNr,i0)->getRealValue(i1,i2,i3);
-}
-
-void
-RockPhysicsInversion4D::SetGridValue(int TableNr,int i0,int i1,int i2,int i3,double value)
-{
-  meanRockPrediction_(TableNr,i0)->setRealValue(i1,i2,i3,float(value));
+  return value;
 }
 
 void
 RockPhysicsInversion4D::AddToGridValue(int TableNr,int i0,int i1,int i2,int i3,double value)
 {
-  double newValue=meanRockPrediction_(TableNr,i0)->getRealValue(i1,i2,i3)+value;
-  meanRockPrediction_(TableNr,i0)->setRealValue(i1,i2,i3,float(newValue));
+  float & cell = meanRockPrediction_[TableNr][GetTableIndex(i0,i1,i2,i3)];
+  cell = float(cell+value);
 }
 
-
 void
 RockPhysicsInversion4D::SolveGEVProblem(NRLib::Matrix sigma_prior,
                                         NRLib::Matrix sigma_posterior,
@@ -407,31 +403,25 @@ RockPhysicsInversion4D::MakeSmoothingFilter(double posteriorVariance,double  df)
 
 
 void
-RockPhysicsInversion4D::fillInTable( std::vector<std::vector<double> >  mSamp,std::vector<double>   rSamp,int tableInd)
+RockPhysicsInversion4D::fillInTable(const std::vector<std::vector<double> >  & mSamp,const std::vector<double>   & rSamp,int tableInd)
 {
   int nSamp = static_cast<int>(mSamp[0].size());
 
-    for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(tableInd,j)->setAccessMode(FFTGrid::RANDOMACCESS);
-    }
+  std::vector<float> & table = meanRockPrediction_[tableInd];
 
+  double m[6];
+  double f[4];
   for(int i=0;i<nSamp;i++)
   {
-    NRLib::Vector m(6);
-    NRLib::Vector f;
     for(int k=0;k<6;k++)
-      m(k)=mSamp[k][i];
-    f=m*v_;
-    int i0 = GetLowerIndex(minf_(0),maxf_(0),nf_[0],f(0));
-    int i1 = GetLowerIndex(minf_(1),maxf_(1),nf_[1],f(1));
-    int i2 = GetLowerIndex(minf_(2),maxf_(2),nf_[2],f(2));
-    int i3 = GetLowerIndex(minf_(3),maxf_(3),nf_[3],f(3));
-    AddToGridValue(tableInd,i0,i1,i2,i3,rSamp[i]);
-  }
-
-
-  for (int j=0; j<nf_[0]; j++){
-    meanRockPrediction_(tableInd,j)->endAccess();
+      m[k]=mSamp[k][i];
+    TransformToFactors(m, f);
+    int i0 = GetLowerIndex(minf_(0),maxf_(0),nf_[0],f[0]);
+    int i1 = GetLowerIndex(minf_(1),maxf_(1),nf_[1],f[1]);
+    int i2 = GetLowerIndex(minf_(2),maxf_(2),nf_[2],f[2]);
+    int i3 = GetLowerIndex(minf_(3),maxf_(3),nf_[3],f[3]);
+    float & cell = table[GetTableIndex(i0,i1,i2,i3)];
+    cell = float(cell+rSamp[i]);
   }
 }
 
@@ -440,216 +430,117 @@ RockPhysicsInversion4D::smoothAllDirectionsAndNormalize()
 {
   DivideAndSmoothTable(1,priorDistribution_,smoothingFilter_);
 
-  for(int i=0;i<2;i++)
-  for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(i,j)->setAccessMode(FFTGrid::RANDOMACCESS);
-   }
+  std::vector<float>       & numbers     = meanRockPrediction_[1];
+  const std::vector<float> & normalizers = meanRockPrediction_[0];
+  int table_size = static_cast<int>(numbers.size());
 
-  for(int i0=0;i0<nf_[0];i0++)
-     for(int i1=0;i1<nf_[1];i1++)
-        for(int i2=0;i2<nf_[2];i2++)
-           for(int i3=0;i3<nf_[3];i3++)
-           {
-             double number = GetGridValue(1,i0,i1,i2,i3);
-             double normalizing =GetGridValue(0,i0,i1,i2,i3);
-             double value;
-             if(normalizing<1e-5)
-               value=RMISSING;
-             else;
-               value=number/normalizing;
-
-             SetGridValue(1,i0,i1,i2,i3,value);
-           }
-
-
-  for(int i=0;i<2;i++)
-    for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(i,j)->endAccess();
-    }
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(n_threads_)
+#endif
+  for(int i=0;i<table_size;i++)
+  {
+    double number = numbers[i];
+    double normalizing = normalizers[i];
+    double value;
+    if(normalizing<1e-5)
+      value=RMISSING;
+    else;
+      value=number/normalizing;
+
+    numbers[i]=float(value);
+  }
+}
+
+void
+RockPhysicsInversion4D::DivideAndSmoothTable(int tableInd,const std::vector<std::vector<double> > & priorDistribution, const std::vector<fftw_complex*> & smoothingFilter)
+{
+  for(int dir=0;dir<4;dir++)
+  {
+    if(dir<3)
+      LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing direction %d of 4\n",dir+1);
+    else
+      LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing last direction \n");
 
+    DivideAndSmoothDirection(meanRockPrediction_[tableInd], dir, priorDistribution[dir], smoothingFilter[dir]);
+  }
 }
 
 void
-RockPhysicsInversion4D::DivideAndSmoothTable(int tableInd,std::vector<std::vector<double> > priorDistribution, std::vector<fftw_complex*> smoothingFilter)
+RockPhysicsInversion4D::DivideAndSmoothDirection(std::vector<float>        & table,
+                                                 int                         dir,
+                                                 const std::vector<double> & priorDistribution,
+                                                 const fftw_complex        * smoothingFilter)
 {
-  for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(tableInd,j)->setAccessMode(FFTGrid::RANDOMACCESS);
-   }
+  // The table lines along dir are independent. A line starts at
+  // outer*n*stride + inner and has its elements stride apart.
+  int n      = nf_[dir];
+  int stride = 1;
+  for(int d=dir+1;d<4;d++)
+    stride *= nf_[d];
+  int nLines = static_cast<int>(table.size())/n;
 
   int cnfp=nfp_/2+1;
   int rnfp=2*cnfp;
 
-  fftw_real*    rTemp = static_cast<fftw_real*>(fftw_malloc(sizeof(float)*rnfp));
-  fftw_complex* cTemp = reinterpret_cast<fftw_complex*>(rTemp);
-
   double minDivisor = 1e-3;
 
-  LogKit::LogFormatted(LogKit::Low,"\n Smoothing direction 1 of 4\n");
-  float monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  float nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
-
-  // divide and smooth direction1
-  for(int i1=0;i1<nf_[1];i1++)
-    for(int i2=0;i2<nf_[2];i2++)
-      for(int i3=0;i3<nf_[3];i3++)
-      {
-        for(int i0=0;i0<nf_[0];i0++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[0][i0]);
-          rTemp[i0]=float(GetGridValue(tableInd,i0,i1,i2,i3)/ divisor);
-        }
-        for(int i0=nf_[0];i0<nfp_;i0++)
-          rTemp[i0]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
-
-        for(int i0=0;i0<cnfp;i0++)
-        {
-          cTemp[i0].re=cTemp[i0].re*smoothingFilter[0][i0].re;
-          cTemp[i0].im=cTemp[i0].im*smoothingFilter[0][i0].re;
-        }
+  std::vector<double> divisor(n);
+  for(int i=0;i<n;i++)
+    divisor[i]=std::max(minDivisor,priorDistribution[i]);
 
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i0=0;i0<nf_[0];i0++)
-        {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i0]);
-          if ( i1*nf_[2]*nf_[3]*nf_[0] +i2*nf_[3]*nf_[0]+ i3*nf_[0] + i0 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
-        }
-      }
-
-  LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing direction 2 of 4\n");
-  monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  nextMonitor = monitorSize;
   std::cout
     << "\n  0%       20%       40%       60%       80%      100%"
     << "\n  |    |    |    |    |    |    |    |    |    |    |  "
     << "\n  ^";
 
-  // divide and smoothdirection2
-  for(int i0=0;i0<nf_[0];i0++)
-    for(int i2=0;i2<nf_[2];i2++)
-      for(int i3=0;i3<nf_[3];i3++)
-      {
-        for(int i1=0;i1<nf_[1];i1++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[1][i1]);
-          rTemp[i1]=float(GetGridValue(tableInd,i0,i1,i2,i3)/divisor);
-        }
-        for(int i1=nf_[1];i1<nfp_;i1++)
-          rTemp[i1]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
-
-        for(int i1=0;i1<cnfp;i1++)
-        {
-          cTemp[i1].re=cTemp[i1].re*smoothingFilter[1][i1].re;
-          cTemp[i1].im=cTemp[i1].im*smoothingFilter[1][i1].re;
-        }
+  int nBlocks    = 50;
+  int blockSize  = (nLines + nBlocks - 1)/nBlocks;
 
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i1=0;i1<nf_[1];i1++)
-        {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i1]);
-          if ( i0*nf_[2]*nf_[3]*nf_[1] +i2*nf_[3]*nf_[1]+ i3*nf_[1] + i1 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
-        }
-      }
+  for(int block=0;block<nBlocks;block++)
+  {
+    int firstLine = block*blockSize;
+    int endLine   = std::min(nLines, firstLine + blockSize);
 
-  LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing direction 3 of 4\n");
-  monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
+#ifdef PARALLEL
+#pragma omp parallel num_threads(n_threads_)
+#endif
+    {
+      fftw_real*    rTemp = static_cast<fftw_real*>(fftw_malloc(sizeof(float)*rnfp));
+      fftw_complex* cTemp = reinterpret_cast<fftw_complex*>(rTemp);
 
-  //  divide and smoothdirection 3
-  for(int i0=0;i0<nf_[0];i0++)
-    for(int i1=0;i1<nf_[1];i1++)
-      for(int i3=0;i3<nf_[3];i3++)
+#ifdef PARALLEL
+#pragma omp for schedule(static)
+#endif
+      for(int line=firstLine;line<endLine;line++)
       {
-        for(int i2=0;i2<nf_[2];i2++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[2][i2]);
-          rTemp[i2]=float(GetGridValue(tableInd,i0,i1,i2,i3)/divisor);
+        int    start = (line/stride)*n*stride + line%stride;
+        float* value = &table[start];
 
-        }
-        for(int i2=nf_[2];i2<nfp_;i2++)
-          rTemp[i2]=0.0f;
+        for(int i=0;i<n;i++)
+          rTemp[i]=float(value[i*stride]/divisor[i]);
+        for(int i=n;i<nfp_;i++)
+          rTemp[i]=0.0f;
 
         rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
 
-        for(int i2=0;i2<cnfp;i2++)
+        for(int i=0;i<cnfp;i++)
         {
-          cTemp[i2].re=cTemp[i2].re*smoothingFilter[2][i2].re;
-          cTemp[i2].im=cTemp[i2].im*smoothingFilter[2][i2].re;
+          cTemp[i].re=cTemp[i].re*smoothingFilter[i].re;
+          cTemp[i].im=cTemp[i].im*smoothingFilter[i].re;
         }
 
         rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i2=0;i2<nf_[2];i2++)
-        {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i2]);
-          if ( i0*nf_[1]*nf_[3]*nf_[2] +i1*nf_[3]*nf_[2]+ i3*nf_[2] + i2 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
-        }
-      }
 
-  LogKit::LogFormatted(LogKit::Low,"\n Smoothing last direction \n");
-  monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
- //  divide and smoothdirection 4
-   for(int i0=0;i0<nf_[0];i0++)
-    for(int i1=0;i1<nf_[1];i1++)
-      for(int i2=0;i2<nf_[2];i2++)
-      {
-        for(int i3=0;i3<nf_[3];i3++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[3][i3]);
-          rTemp[i3]=float(GetGridValue(tableInd,i0,i1,i2,i3)/divisor);
-        }
-        for(int i3=nf_[3];i3<nfp_;i3++)
-          rTemp[i3]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
-
-        for(int i3=0;i3<cnfp;i3++)
-        {
-          cTemp[i3].re=cTemp[i3].re*smoothingFilter[3][i3].re;
-          cTemp[i3].im=cTemp[i3].im*smoothingFilter[3][i3].re;
-        }
-
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i3=0;i3<nf_[3];i3++)
-        {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i3]);
-          if ( i0*nf_[1]*nf_[2]*nf_[3] +i1*nf_[2]*nf_[3]+ i2*nf_[3] + i3 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
-        }
+        for(int i=0;i<n;i++)
+          value[i*stride]=rTemp[i];
       }
 
-  for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(tableInd,j)->endAccess();
-  }
-
-  fftw_free(rTemp);
+      fftw_free(rTemp);
+    }
 
+    if(endLine > firstLine)
+      std::cout << "^";
+  }
 }
 
 void
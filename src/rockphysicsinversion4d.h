@@ -18,22 +18,24 @@ class RockPhysicsInversion4D
 {
 public:
   RockPhysicsInversion4D();
-  RockPhysicsInversion4D(NRLib::Vector                      priorMean,
-                         NRLib::Matrix                      priorCov,
-                         NRLib::Matrix                      posteriorCov,
-                         std::vector<std::vector<double> >  mSamp);
+  RockPhysicsInversion4D(NRLib::Vector                              priorMean,
+                         NRLib::Matrix                              priorCov,
+                         NRLib::Matrix                              posteriorCov,
+                         const std::vector<std::vector<double> >  & mSamp,
+                         int                                        n_threads = 1);
 
   ~RockPhysicsInversion4D();
-  void     makeNewPredictionTable(std::vector<std::vector<double> >  mSamp,std::vector<double>   rSamp);
+  void     makeNewPredictionTable(const std::vector<std::vector<double> >  & mSamp,const std::vector<double>   & rSamp);
   FFTGrid* makePredictions(std::vector<FFTGrid *> mu_static_,
                          std::vector<FFTGrid *> mu_dynamic_ );
 
   double   getPredictedValue(NRLib::Vector f);
+  double   getPredictedValue(const double * f) const; // f has length 4
 
   void     allocatePredictionTables( );
-  void     fillInTable( std::vector<std::vector<double> >  mSamp,std::vector<double>   rSamp,int tableInd);
+  void     fillInTable(const std::vector<std::vector<double> >  & mSamp,const std::vector<double>   & rSamp,int tableInd);
   void     smoothAllDirectionsAndNormalize();
-  void     DivideAndSmoothTable(int tableInd,std::vector<std::vector<double> > priorDistribution, std::vector<fftw_complex*> smoothingFilter);
+  void     DivideAndSmoothTable(int tableInd,const std::vector<std::vector<double> > & priorDistribution, const std::vector<fftw_complex*> & smoothingFilter);
   fftw_complex*        MakeSmoothingFilter(double posteriorVariance,double  df);
   std::vector<double>  MakeGaussKernel(double mean, double variance, double minf, double  df,int nf);
   // another option is to use data reference
@@ -42,18 +44,32 @@ public:
   void     SolveGEVProblem( NRLib::Matrix sigma_prior,
                             NRLib::Matrix sigma_posterior,
                             NRLib::Matrix & v);
-  double   GetGridValue(int TableNr,int i1,int i2,int i3,int i4);
-  void     SetGridValue(int TableNr,int i1,int i2,int i3,int i4,double value);
+  double   GetGridValue(int TableNr,int i1,int i2,int i3,int i4) const { return meanRockPrediction_[TableNr][GetTableIndex(i1,i2,i3,i4)]; }
+  void     SetGridValue(int TableNr,int i1,int i2,int i3,int i4,double value) { meanRockPrediction_[TableNr][GetTableIndex(i1,i2,i3,i4)] = float(value); }
   void     AddToGridValue(int TableNr, int i1,int i2,int i3,int i4,double value);
   void     writeTableTofile(std::string fileName);
 
 private:
 
-  void GetLowerIndexAndW(double minValue,double maxValue,int nValue,double value,int& index, double& w);
-  int GetLowerIndex(double minValue,double maxValue,int nValue,double value);
+  void GetLowerIndexAndW(double minValue,double maxValue,int nValue,double value,int& index, double& w) const;
+  int GetLowerIndex(double minValue,double maxValue,int nValue,double value) const;
+
+  // Transforms m (length 6) to f (length 4), f = m*v_
+  void TransformToFactors(const double * m, double * f) const;
+
+  // Divides by the prior and smooths all table lines along direction dir.
+  void DivideAndSmoothDirection(std::vector<float>        & table,
+                                int                         dir,
+                                const std::vector<double> & priorDistribution,
+                                const fftw_complex        * smoothingFilter);
+
+  int  GetTableIndex(int i0,int i1,int i2,int i3) const { return ((i0*nf_[1] + i1)*nf_[2] + i2)*nf_[3] + i3; }
 
   void ClearContentInPredictionTable( );
-  NRLib::Grid2D<FFTGrid *> meanRockPrediction_;
+
+  // Two 4D tables stored with the last index running fastest.
+  // Table 0 is the prior sample density, table 1 the rock property sum.
+  std::vector<std::vector<float> > meanRockPrediction_;
 
   std::vector<fftw_complex*> smoothingFilter_; // all have length nfp_/2+1
   std::vector<std::vector<double> > priorDistribution_;
@@ -71,6 +87,8 @@ private:
   rfftwnd_plan fftplan1_;
   rfftwnd_plan fftplan2_;
 
+  int n_threads_;
+
 };
 #endif
 
@@ -8,11 +8,15 @@
 #include <math.h>
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <algorithm>
 
 #include "src/seismicstorage.h"
 #include "src/fftgrid.h"
 #include "src/simbox.h"
 
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+
 SeismicStorage::SeismicStorage()
 {
 }
@@ -182,11 +186,9 @@ SeismicStorage::GetSparseTraceData(std::vector<std::vector<float> > & trace_data
       NRLib::SegYTrace * segy_tmp = segy_->getTrace(trace_index);
 
       if (segy_tmp != NULL) {
-        size_t start = segy_tmp->GetStart();
-        size_t end = segy_tmp->GetEnd();
-        for (size_t j = start; j < end; j++)
-          trace_data[i].push_back(segy_tmp->GetValue(j));
-
+        const std::vector<float> & values = segy_tmp->GetTrace();
+        size_t n_values = segy_tmp->GetEnd() - segy_tmp->GetStart();
+        trace_data[i].assign(values.begin(), values.begin() + n_values);
       }
     }
   }
@@ -201,6 +203,10 @@ SeismicStorage::GetSparseTraceData(std::vector<std::vector<float> > & trace_data
     int    trace_index = 0;
 
     int n_elements = static_cast<int>(std::sqrt(static_cast<double>(n)));
+    size_t nk      = storm_grid_->GetNK();
+
+    trace_data.resize(std::max(static_cast<int>(trace_data.size()), n_elements*n_elements));
+    trace_length.resize(n_elements*n_elements);
 
     for (int i = 0; i < n_elements; i++) {
 
@@ -214,15 +220,17 @@ SeismicStorage::GetSparseTraceData(std::vector<std::vector<float> > & trace_data
         if (index_j >= storm_grid_->GetNJ())
           index_j = storm_grid_->GetNJ()-1;
 
-        for (size_t k = 0; k < storm_grid_->GetNK(); k++) {
-          storm_grid_->FindCenterOfCell(index_i, index_j, k, x_tmp, y_tmp, z_tmp);
-          trace_data[trace_index].push_back(storm_grid_->GetValueClosestInZ(x_tmp, y_tmp, z_tmp));
-        }
+        //Cell centres of a trace lie in the cells themselves, so the values are read by index.
+        std::vector<float> & trace = trace_data[trace_index];
+        trace.resize(nk);
+        for (size_t k = 0; k < nk; k++)
+          trace[k] = (*storm_grid_)(index_i, index_j, k);
 
         //Store length
+        storm_grid_->FindCenterOfCell(index_i, index_j, 0, x_tmp, y_tmp, z_tmp);
         double top = storm_grid_->GetTopSurface().GetZ(x_tmp, y_tmp);
         double bot = storm_grid_->GetBotSurface().GetZ(x_tmp, y_tmp);
-        trace_length.push_back(std::abs(static_cast<float>(bot-top)));
+        trace_length[trace_index] = std::abs(static_cast<float>(bot-top));
 
         trace_index++;
       }
@@ -407,3 +415,36 @@ SeismicStorage::EndAccess()
   if(seismic_type_ == FFTGRID)
     fft_grid_->endAccess();
 }
+
+SeismicTraceCache::SeismicTraceCache(const std::vector<SeismicStorage *> & seismic_data,
+                                     const Simbox                        * estimation_simbox,
+                                     const std::vector<int>              & columns)
+ : nx_(estimation_simbox->getnx()),
+   traces_(seismic_data.size())
+{
+  std::vector<int> keys(columns);
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  for (size_t l = 0; l < seismic_data.size(); l++) {
+    seismic_data[l]->SetRandomAccess();
+    for (size_t c = 0; c < keys.size(); c++) {
+      int i = keys[c] % nx_;
+      int j = keys[c] / nx_;
+      traces_[l][keys[c]] = seismic_data[l]->GetRealTrace(estimation_simbox, i, j);
+    }
+    seismic_data[l]->EndAccess();
+  }
+}
+
+const std::vector<float> &
+SeismicTraceCache::GetTrace(int angle,
+                            int i,
+                            int j) const
+{
+  std::map<int, std::vector<float> >::const_iterator it = traces_[angle].find(i + j*nx_);
+  if (it == traces_[angle].end())
+    throw NRLib::Exception("Seismic trace (" + NRLib::ToString(i) + "," + NRLib::ToString(j) + ") was not read into the trace cache.");
+
+  return it->second;
+}
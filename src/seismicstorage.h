@@ -7,6 +7,8 @@
 
 #include <math.h>
 #include <string>
+#include <map>
+#include <vector>
 
 #include "nrlib/segy/segy.hpp"
 #include "src/definitions.h"
@@ -97,4 +99,23 @@ private:
 
 };
 
+//Traces of a set of angle stacks for given (i, j) columns. All traces are read
+//in the constructor, one angle stack at a time, so at most one stack is in
+//random access mode. GetTrace only reads, and may be called from several threads.
+class SeismicTraceCache
+{
+public:
+  SeismicTraceCache(const std::vector<SeismicStorage *> & seismic_data,
+                    const Simbox                        * estimation_simbox,
+                    const std::vector<int>              & columns);          ///< Keys i + j*nx, may repeat
+
+  const std::vector<float> & GetTrace(int angle,
+                                      int i,
+                                      int j) const;
+
+private:
+  int                                                 nx_;
+  std::vector<std::map<int, std::vector<float> > >    traces_;          ///< One map per angle, key i + j*nx
+};
+
 #endif
@@ -635,6 +635,11 @@ Simbox & Simbox::operator=(const Simbox   & rhs)
   grad_x_         = 0;
   grad_y_         = 0;
 
+  // The lateral geometry was only completed by the swaps above
+  ClearColumnCache();
+  if(status_ == BOXOK)
+    CreateColumnCache();
+
   return *this;
 }
 
@@ -710,6 +715,79 @@ Simbox::getIndexes(double x, double y, double z, int & xInd, int & yInd, int & z
   }
 }
 
+void
+Simbox::getIndexes(const std::vector<double> & x,
+                   const std::vector<double> & y,
+                   const std::vector<double> & z,
+                   std::vector<int>          & xInd,
+                   std::vector<int>          & yInd,
+                   std::vector<int>          & zInd,
+                   bool                        visible_only) const
+{
+  //
+  // Gives the same indices as calling getIndexes() for each point, but the
+  // surfaces are only evaluated when (x,y) changes. Vertical well sections
+  // and traces therefore cost one surface lookup.
+  //
+  size_t n = x.size();
+  xInd.resize(n);
+  yInd.resize(n);
+  zInd.resize(n);
+
+  bool   have_xy      = false;
+  bool   have_visible = false;
+  double x_prev       = 0.0;
+  double y_prev       = 0.0;
+  double zTop         = 0.0;
+  double zBot         = 0.0;
+  double ztv          = 0.0;
+  double zbv          = 0.0;
+
+  for(size_t m = 0 ; m < n ; m++)
+  {
+    xInd[m] = IMISSING;
+    yInd[m] = IMISSING;
+    zInd[m] = IMISSING;
+    double rx =  (x[m]-GetXMin())*cosrot_ + (y[m]-GetYMin())*sinrot_;
+    double ry = -(x[m]-GetXMin())*sinrot_ + (y[m]-GetYMin())*cosrot_;
+    if(rx >= 0 && rx <= GetLX() && ry >= 0 && ry <= GetLY())
+    {
+      if(have_xy == false || x[m] != x_prev || y[m] != y_prev)
+      {
+        zTop         = GetTopSurface().GetZ(x[m],y[m]);
+        zBot         = GetBotSurface().GetZ(x[m],y[m]);
+        x_prev       = x[m];
+        y_prev       = y[m];
+        have_xy      = true;
+        have_visible = false;
+      }
+      if(GetTopSurface().IsMissing(zTop) == false &&
+         GetBotSurface().IsMissing(zBot) == false && z[m] > zTop && z[m] < zBot)
+      {
+        bool visibility_ok = true;
+        if(visible_only == true) {
+          if(have_visible == false) {
+            ztv          = top_eroded_surface_->GetZ(x[m],y[m]);
+            zbv          = base_eroded_surface_->GetZ(x[m],y[m]);
+            have_visible = true;
+          }
+          if(z[m] < ztv || z[m] > zbv)
+            visibility_ok = false;
+        }
+        if(visibility_ok == true) {
+          xInd[m] = int(floor(rx/dx_));
+          if(xInd[m] > nx_-1)
+            xInd[m] = nx_-1;
+          yInd[m] = int(floor(ry/dy_));
+          if(yInd[m] > ny_-1)
+            yInd[m] = ny_-1;
+          zInd[m] = int(floor(static_cast<double>(nz_)*(z[m]-zTop)/(zBot-zTop)));
+        }
+      }
+    }
+  }
+}
+
 void
 Simbox::getIndexes(double x, double y, int & xInd, int & yInd) const
 {
@@ -814,7 +892,19 @@ void
 Simbox::getCoord(int xInd, int yInd, int zInd, double &x, double &y, double &z) const
 {
   getXYCoord(xInd, yInd, x, y);
-  getZCoord(zInd, x, y, z);
+  if(HasColumn(xInd, yInd))
+  {
+    z = RMISSING;
+    double zTop = column_top_[xInd+yInd*nx_];
+    double zBot = column_bot_[xInd+yInd*nx_];
+    if(GetTopSurface().IsMissing(zTop) == false && GetBotSurface().IsMissing(zBot) == false)
+    {
+      double dz = (zBot-zTop)/static_cast<double>(nz_);
+      z = zTop + (static_cast<double>(zInd) + 0.5)*dz;
+    }
+  }
+  else
+    getZCoord(zInd, x, y, z);
 }
 
 void
@@ -939,9 +1029,14 @@ Simbox::insideRectangle(const SegyGeometry *  geometry) const
 double
 Simbox::getTop(int i, int j) const
 {
-  double x, y;
-  getXYCoord(i,j,x,y);
-  double zTop = GetTopSurface().GetZ(x, y);
+  double zTop;
+  if(HasColumn(i,j))
+    zTop = column_top_[i+j*nx_];
+  else {
+    double x, y;
+    getXYCoord(i,j,x,y);
+    zTop = GetTopSurface().GetZ(x, y);
+  }
   if(GetTopSurface().IsMissing(zTop))
     zTop = RMISSING;
   return(zTop);
@@ -959,9 +1054,14 @@ Simbox::getTop(double x, double y) const
 double
 Simbox::getBot(int i, int j) const
 {
-  double x, y;
-  getXYCoord(i,j,x,y);
-  double zBot = GetBotSurface().GetZ(x, y);
+  double zBot;
+  if(HasColumn(i,j))
+    zBot = column_bot_[i+j*nx_];
+  else {
+    double x, y;
+    getXYCoord(i,j,x,y);
+    zBot = GetBotSurface().GetZ(x, y);
+  }
   if(GetBotSurface().IsMissing(zBot))
     zBot = RMISSING;
   return(zBot);
@@ -977,9 +1077,14 @@ Simbox::getBot(double x, double y) const
 }
 
 double  Simbox::GetTopErodedSurface(int i, int j) const{
-  double x, y;
-  getXYCoord(i,j,x,y);
-  double z_top = GetTopErodedSurface().GetZ(x,y);
+  double z_top;
+  if(HasErodedColumn(i,j))
+    z_top = column_top_eroded_[i+j*nx_];
+  else {
+    double x, y;
+    getXYCoord(i,j,x,y);
+    z_top = GetTopErodedSurface().GetZ(x,y);
+  }
   if(GetTopErodedSurface().IsMissing(z_top))
     z_top = RMISSING;
   return z_top;
@@ -993,9 +1098,14 @@ double  Simbox::GetTopErodedSurface(double x, double y) const{
 }
 
 double  Simbox::GetBotErodedSurface(int i, int j) const{
-  double x, y;
-  getXYCoord(i,j,x,y);
-  double z_base = GetBaseErodedSurface().GetZ(x,y);
+  double z_base;
+  if(HasErodedColumn(i,j))
+    z_base = column_bot_eroded_[i+j*nx_];
+  else {
+    double x, y;
+    getXYCoord(i,j,x,y);
+    z_base = GetBaseErodedSurface().GetZ(x,y);
+  }
   if(GetTopErodedSurface().IsMissing(z_base))
     z_base = RMISSING;
   return z_base;
@@ -1154,6 +1264,8 @@ Simbox::calculateDz(double lzLimit, std::string & errText)
       }
     }
   }
+  if(status_ == BOXOK)
+    CreateColumnCache();
   return(status_);
 }
 
@@ -1171,6 +1283,8 @@ Simbox::setArea(const SegyGeometry * geometry, std::string & errText)
 
   bool failed = false;
 
+  ClearColumnCache();
+
   try
   {
     SetDimensions(x0,y0,lx,ly);
@@ -1234,6 +1348,8 @@ Simbox::setArea(const NRLib::Volume * volume, int nx, int ny, std::string & errT
 
   bool failed = false;
 
+  ClearColumnCache();
+
   try
   {
     SetDimensions(x0,y0,lx,ly);
@@ -1395,6 +1511,16 @@ Simbox::getAvgRelThick(void) const
 double
 Simbox::getRelThick(int i, int j) const
 {
+  if(HasColumn(i,j))
+  {
+    double relThick = 1; //Default value to be used outside grid.
+    double zTop = column_top_[i+j*nx_];
+    double zBot = column_bot_[i+j*nx_];
+    if(GetTopSurface().IsMissing(zTop) == false &&
+       GetBotSurface().IsMissing(zBot) == false)
+      relThick = (zBot-zTop)/GetLZ();
+    return(relThick);
+  }
   double rx = (static_cast<double>(i) + 0.5)*dx_;
   double ry = (static_cast<double>(j) + 0.5)*dy_;
   double x = rx*cosrot_-ry*sinrot_ + GetXMin();
@@ -1504,6 +1630,59 @@ void Simbox::SetErodedSurfaces(const NRLib::Surface<double> & top_surf,
     CheckErodedSurfaces();
 
   lz_eroded_ = RecalculateErodedLZ();
+
+  if (!column_top_.empty())
+    CreateErodedColumnCache();
+}
+
+void Simbox::SetSurfaces(const NRLib::Surface<double> & top_surf,
+                         const NRLib::Surface<double> & bot_surf,
+                         bool  skip_check)
+{
+  ClearColumnCache();
+  Volume::SetSurfaces(top_surf, bot_surf, skip_check);
+}
+
+void Simbox::CreateColumnCache()
+{
+  column_top_.resize(nx_*ny_);
+  column_bot_.resize(nx_*ny_);
+  for (int j = 0; j < ny_; j++) {
+    for (int i = 0; i < nx_; i++) {
+      double x, y;
+      getXYCoord(i, j, x, y);
+      column_top_[i+j*nx_] = GetTopSurface().GetZ(x, y);
+      column_bot_[i+j*nx_] = GetBotSurface().GetZ(x, y);
+    }
+  }
+  CreateErodedColumnCache();
+}
+
+void Simbox::CreateErodedColumnCache()
+{
+  column_top_eroded_.clear();
+  column_bot_eroded_.clear();
+  if (top_eroded_surface_ == NULL || base_eroded_surface_ == NULL)
+    return;
+
+  column_top_eroded_.resize(nx_*ny_);
+  column_bot_eroded_.resize(nx_*ny_);
+  for (int j = 0; j < ny_; j++) {
+    for (int i = 0; i < nx_; i++) {
+      double x, y;
+      getXYCoord(i, j, x, y);
+      column_top_eroded_[i+j*nx_] = top_eroded_surface_->GetZ(x, y);
+      column_bot_eroded_[i+j*nx_] = base_eroded_surface_->GetZ(x, y);
+    }
+  }
+}
+
+void Simbox::ClearColumnCache()
+{
+  column_top_.clear();
+  column_bot_.clear();
+  column_top_eroded_.clear();
+  column_bot_eroded_.clear();
 }
 
 bool Simbox::CheckErodedSurfaces() const
@@ -6,6 +6,7 @@
 #define SIMBOX_H
 
 #include <string.h>
+#include <vector>
 
 #include "nrlib/volume/volume.hpp"
 #include "nrlib/surface/regularsurface.hpp"
@@ -87,6 +88,13 @@ public:
   int            getClosestZIndex(double x, double y, double z);
   void           getIndexes(double x, double y, int & xInd, int & yInd) const;
   void           getIndexes(double x, double y, double z, int & xInd, int & yInd, int & zInd, bool visible_only = false) const;
+  void           getIndexes(const std::vector<double> & x,
+                            const std::vector<double> & y,
+                            const std::vector<double> & z,
+                            std::vector<int>          & xInd,
+                            std::vector<int>          & yInd,
+                            std::vector<int>          & zInd,
+                            bool                        visible_only = false) const; // Point list version, e.g. for well logs
   void           getIndexesFull(double x, double y, double z, int & xInd, int & yInd, int & zInd) const;
   void           getZInterpolation(double x, double y, double z,
                                    int & index1, int & index2, double & t) const;
@@ -163,6 +171,7 @@ public:
   void           SetTopBaseErodedNames(const std::string & topname, const std::string & botname, int outputFormat);
   void           setTopBotName(const std::string & topname, const std::string & botname, int outputFormat);
   void           SetErodedSurfaces(const NRLib::Surface<double> & top_surf, const NRLib::Surface<double> & bot_surf, bool  skip_check = true);
+  void           SetSurfaces(const NRLib::Surface<double> & top_surf, const NRLib::Surface<double> & bot_surf, bool  skip_check = true);
   bool           setArea(const SegyGeometry * geometry, std::string & errText);
   bool           setArea(const NRLib::Volume * volume, int ni, int nj, std::string & errText, bool scale = false);
   void           setILXL(const SegyGeometry * geometry);
@@ -209,6 +218,12 @@ private:
   bool           CheckErodedSurfaces() const;
   double         RecalculateErodedLZ() const;
 
+  void           CreateColumnCache();
+  void           CreateErodedColumnCache();
+  void           ClearColumnCache();
+  bool           HasColumn(int i, int j)         const { return !column_top_.empty() && i >= 0 && i < nx_ && j >= 0 && j < ny_ ;}
+  bool           HasErodedColumn(int i, int j)   const { return !column_top_eroded_.empty() && HasColumn(i, j)                  ;}
+
   int            nx_pad_;                      ///< Number of cells to pad in x direction
   int            ny_pad_;
   int            nz_pad_;
@@ -238,5 +253,13 @@ private:
 
   bool           constThick_;
   double         minRelThick_;
+
+  // Surface values in the lateral cell centres, index i+j*nx_. The cache is made when the
+  // simbox is complete (calculateDz) and is cleared whenever the area or surfaces change.
+  // Empty vectors mean that the surfaces must be evaluated.
+  std::vector<double> column_top_;
+  std::vector<double> column_bot_;
+  std::vector<double> column_top_eroded_;
+  std::vector<double> column_bot_eroded_;
 };
 #endif
@@ -1083,7 +1083,8 @@ State4D::iFFTCov()
 std::vector<FFTGrid*>
 State4D::doRockPhysicsInversion(TimeLine                               & time_line,
                                 const std::vector<DistributionsRock *>   rock_distributions,
-                                TimeEvolution                          & timeEvolution)
+                                TimeEvolution                          & timeEvolution,
+                                int                                      n_threads)
 {
   LogKit::WriteHeader("Start 4D rock physics inversion");
   bool debug=true; // triggers printouts
@@ -1152,7 +1153,7 @@ State4D::doRockPhysicsInversion(TimeLine                               & time_li
 
   LogKit::LogFormatted(LogKit::Low,"\nMaking rock-physics lookup tables, table 1 of %d\n",nRockProperties+1);
 
-  RockPhysicsInversion4D* rockPhysicsInv = new RockPhysicsInversion4D(fullPriorMean,fullPriorCov,fullPosteriorCov,mSamp);
+  RockPhysicsInversion4D* rockPhysicsInv = new RockPhysicsInversion4D(fullPriorMean,fullPriorCov,fullPosteriorCov,mSamp,n_threads);
   //LogKit::LogFormatted(LogKit::Low,"done\n\n");
 
   std::vector<FFTGrid*> prediction(nRockProperties);
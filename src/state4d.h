@@ -52,7 +52,8 @@ public:
   void   evolve(int time_step, const TimeEvolution & timeEvolution );
   std::vector<FFTGrid*> doRockPhysicsInversion(TimeLine                               & time_line,
                                                const std::vector<DistributionsRock *>   rock_distributions,
-                                               TimeEvolution                          & timeEvolution);
+                                               TimeEvolution                          & timeEvolution,
+                                               int                                      n_threads = 1);
 
 
   bool   isActive() const {return(mu_static_.size() > 0);}
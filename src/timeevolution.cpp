@@ -16,7 +16,9 @@
 
 TimeEvolution::TimeEvolution(int                                     i_max,
                              TimeLine                              & time_line,
-                             const std::vector<DistributionsRock*> & dist_rock)
+                             const std::vector<DistributionsRock*> & dist_rock,
+                             int                                     n_threads)
+: n_threads_(n_threads)
 {
   LogKit::WriteHeader("Setting up matrices for time evolution");
   std::list<int> time;
@@ -32,7 +34,7 @@ std::vector<std::vector<std::vector<double> > >
                                         TimeLine                                  & time_line,
                                         const std::vector<DistributionsRock*>     & dist_rock)
 {
-  CorrelatedRockSamples correlated_rock_samples;
+  CorrelatedRockSamples correlated_rock_samples(n_threads_);
   std::vector<std::vector<std::vector<double> > > sample= correlated_rock_samples.CreateSamplesExtended(i_max, time_line, dist_rock);
   // The dimension of m_ik[k][i] is expected to be equal to 3, in other words we do not return samples splitted into dynamic and static parts.
   return sample;
@@ -61,7 +63,7 @@ void TimeEvolution::SetUpEvolutionMatrices(std::vector< NRLib::Matrix>
   // Cov_mkm1_mkm1: Denotes the covariance of m_{k-1} and m_{k-1}, Cov(m_{k-1}, m_{k-1})
   double adjustment_factor=1e-6;
 
-  CorrelatedRockSamples correlated_rock_samples;
+  CorrelatedRockSamples correlated_rock_samples(n_threads_);
   std::vector<std::vector<std::vector<double> > > m_ik = correlated_rock_samples.CreateSamples(i_max, time_line, dist_rock);
 
   //write seismic parameters to check ok
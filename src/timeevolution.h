@@ -15,10 +15,11 @@ class FFTGrid;
 class TimeEvolution
 {
 public:
-  TimeEvolution() {}
+  TimeEvolution() : n_threads_(1) {}
   TimeEvolution(int                                     i_max,
                 TimeLine                              & time_line,
-                const std::vector<DistributionsRock*> & dist_rock);
+                const std::vector<DistributionsRock*> & dist_rock,
+                int                                     n_threads = 1);
   //void Split(const SeismicParametersHolder &m_combined, State4D & state4D);
   //void Evolve(int time_step, State4D & state4D);
   //void Merge(const State4D & state4D, SeismicParametersHolder &m_combined);
@@ -37,6 +38,7 @@ public:
 
 private:
   int number_of_timesteps_;
+  int n_threads_;           // Threads used when sampling the rock physics model.
 
   NRLib::Matrix initial_cov_;
   NRLib::Vector initial_mean_;
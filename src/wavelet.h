@@ -167,6 +167,8 @@ public:
   float          findNorm() const;
   void           SetReflectionCoeffs(const NRLib::Matrix & reflCoef, int i);
   bool           getInFFTOrder()     const { return inFFTorder_ ;}
+  float          getLocalTimeshift(int i, int j) const;
+  float          getLocalGainFactor(int i, int j) const;
   //Grid2D       * getGainGrid()       const { return gainGrid_   ;}
   //Grid2D       * getShiftGrid()      const { return shiftGrid_  ;}
 
@@ -179,12 +181,6 @@ protected:
                                         int                   i,
                                         int                   j);
 
-  float          getLocalTimeshift(int                          i,
-                                   int                          j) const;
-
-  float          getLocalGainFactor(int                         i,
-                                    int                         j) const;
-
   float          findWaveletLength(float                        minRelativeAmp,float minimumLength);
 
   void           convolve(fftw_complex                       * var1_c,
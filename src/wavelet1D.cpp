@@ -122,6 +122,20 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
   std::vector<int>   sampleStart(nWells,0);   // Needed to block syntSeis
   std::vector<int>   sampleStop(nWells,0);    // Needed to block syntSeis
   std::vector<float> wellWeight(nWells,0.0f);
+
+  std::vector<BlockedLogsCommon *>   blockedLogs(nWells, NULL);
+  std::vector<std::vector<double> >  seisDataWell(nWells);
+  std::vector<bool>                  useWell(nWells, false);
+
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+
+  // The debug vectors are written to files with fixed names, so the well
+  // loops below are only run in parallel when no debug output is made.
+  bool debugOutput = ModelSettings::getDebugLevel() > 0;
+#endif
+
   //
   // Loop over wells and create a blocked well and blocked seismic
   //
@@ -131,6 +145,7 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
   for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
     std::map<std::string, BlockedLogsCommon *>::const_iterator iter = mapped_blocked_logs.find(it->first);
     BlockedLogsCommon * blocked_log = iter->second;
+    blockedLogs[w] = blocked_log;
 
     if(blocked_log->GetUseForWaveletEstimation()) {
       if (writing)
@@ -176,7 +191,8 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
       blocked_log->GetVerticalTrend(blocked_log->GetVsBlocked(), vs);
       std::vector<double> rho(nz_);
       blocked_log->GetVerticalTrend(blocked_log->GetRhoBlocked(), rho);
-      std::vector<double> seisData(nz_);
+      std::vector<double> & seisData = seisDataWell[w];
+      seisData.resize(nz_);
       blocked_log->GetVerticalTrend(seisLog, seisData);
       std::vector<bool> hasData(nz_);
       for (int k = 0 ; k < nz_ ; k++)
@@ -188,27 +204,8 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
       blocked_log->FindContinuousPartOfData(hasData, nz_, start, length);
 
       if(length*dz_ > waveletTaperLength ) { // must have enough data
-        bool shift = true;
-        if(seismic_data->GetSeismicType() == SeismicStorage::SEGY)
-          shift = false;
         nUsedWells++;
-        blocked_log->FillInCpp(coeff_, start, length, cpp_r[w], nzp_);
-        fileName = "cpp_1";
-        printVecToFile(fileName, cpp_r[w], nzp_);  // Debug
-        blocked_log->FillInSeismic(seisData, start, length, seis_r[w], nzp_, shift);
-        fileName = "seis_1";
-        printVecToFile(fileName, seis_r[w], nzp_); // Debug
-        Utils::fft(cpp_r[w], cpp_c[w], nzp_);
-        Utils::fft(seis_r[w], seis_c[w], nzp_);
-        blocked_log->EstimateCor(cpp_c[w], cpp_c[w], cor_cpp_c[w], cnzp_);
-        Utils::fftInv(cor_cpp_c[w], cor_cpp_r[w], nzp_);
-        blocked_log->EstimateCor(cpp_c[w], seis_c[w], ccor_seis_cpp_c[w], cnzp_);
-        Utils::fftInv(ccor_seis_cpp_c[w], ccor_seis_cpp_r[w], nzp_);
-        Utils::fftInv(cpp_c[w], cpp_r[w], nzp_);
-        Utils::fftInv(seis_c[w], seis_r[w], nzp_);
-        wellWeight[w] = length*dzWell[w]*(cor_cpp_r[w][0]+cor_cpp_r[w][1]);// Gives most weight to long datasets with
-                                                                           // large reflection coefficients
-        z0[w] = static_cast<float> (blocked_log->GetZposBlocked()[0]);
+        useWell[w]     = true;
         sampleStart[w] = start;
         sampleStop[w]  = start + length;
       }
@@ -225,6 +222,41 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
     w++;
   }
 
+  //
+  // Correlate reflection coefficients and seismic in the wells used. Each
+  // well only touches its own buffers.
+  //
+  bool shift = true;
+  if(seismic_data->GetSeismicType() == SeismicStorage::SEGY)
+    shift = false;
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads) if(!debugOutput)
+#endif
+  for (int w = 0 ; w < nWells ; w++) {
+    if (useWell[w]) {
+      const BlockedLogsCommon * blocked_log = blockedLogs[w];
+      int start  = sampleStart[w];
+      int length = sampleStop[w] - sampleStart[w];
+
+      blocked_log->FillInCpp(coeff_, start, length, cpp_r[w], nzp_);
+      printVecToFile("cpp_1", cpp_r[w], nzp_);  // Debug
+      blocked_log->FillInSeismic(seisDataWell[w], start, length, seis_r[w], nzp_, shift);
+      printVecToFile("seis_1", seis_r[w], nzp_); // Debug
+      Utils::fft(cpp_r[w], cpp_c[w], nzp_);
+      Utils::fft(seis_r[w], seis_c[w], nzp_);
+      blocked_log->EstimateCor(cpp_c[w], cpp_c[w], cor_cpp_c[w], cnzp_);
+      Utils::fftInv(cor_cpp_c[w], cor_cpp_r[w], nzp_);
+      blocked_log->EstimateCor(cpp_c[w], seis_c[w], ccor_seis_cpp_c[w], cnzp_);
+      Utils::fftInv(ccor_seis_cpp_c[w], ccor_seis_cpp_r[w], nzp_);
+      Utils::fftInv(cpp_c[w], cpp_r[w], nzp_);
+      Utils::fftInv(seis_c[w], seis_r[w], nzp_);
+      wellWeight[w] = length*dzWell[w]*(cor_cpp_r[w][0]+cor_cpp_r[w][1]);// Gives most weight to long datasets with
+                                                                         // large reflection coefficients
+      z0[w] = static_cast<float> (blocked_log->GetZposBlocked()[0]);
+    }
+  }
+
   if(nUsedWells == 0) {
     errCode = 1;
     errTxt  += "No wells left for wavelet estimation.\n";
@@ -274,28 +306,25 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
 
     // gets syntetic seismic with estimated wavelet
     well_wavelet.resize(nWells);
-    int w = 0;
-    for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads) if(!debugOutput)
+#endif
+    for(int w = 0 ; w < nWells ; w++) {
       fillInnWavelet(wavelet_r[w], nzp_, dzWell[w]);
       shiftReal(shiftWell[w]/dzWell[w], wavelet_r[w], nzp_);
       well_wavelet[w] = new Wavelet1D(wavelet_r[w], nz_, nzp_, dzWell[w], true);
       well_wavelet[w]->shiftFromFFTOrder();
-      fileName = "waveletShift";
-      printVecToFile(fileName, wavelet_r[w], nzp_);
+      printVecToFile("waveletShift", wavelet_r[w], nzp_);
       Utils::fft(wavelet_r[w], wavelet_c[w], nzp_);
-      fileName = "cpp";
-      printVecToFile(fileName, cpp_r[w], nzp_);
+      printVecToFile("cpp", cpp_r[w], nzp_);
       Utils::fft(cpp_r[w], cpp_c[w], nzp_);
       convolve(cpp_c[w], wavelet_c[w], synt_seis_c[w], cnzp_);
       Utils::fftInv(synt_seis_c[w], synt_seis_r[w], nzp_); //
-      fileName = "syntSeis";
-      printVecToFile(fileName, synt_seis_r[w], nzp_);
-      fileName = "seis";
-      printVecToFile(fileName, seis_r[w], nzp_);
-      w++;
+      printVecToFile("syntSeis", synt_seis_r[w], nzp_);
+      printVecToFile("seis", seis_r[w], nzp_);
     }
 
-    float scaleOpt = findOptimalWaveletScale(synt_seis_r, seis_r, nWells, nzp_, wellWeight);
+    float scaleOpt = findOptimalWaveletScale(synt_seis_r, seis_r, nWells, nzp_, wellWeight, n_threads);
 
     shiftAndScale(shiftAvg, scaleOpt);//shifts wavelet average from wells
     invFFT1DInPlace();
@@ -326,10 +355,8 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
     rAmp_               = static_cast<fftw_real*>(fftw_malloc(rnzp_*sizeof(fftw_real)));
     cAmp_               = reinterpret_cast<fftw_complex *>(rAmp_);
 
-    w = 0;
-    for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
-      std::map<std::string, BlockedLogsCommon *>::const_iterator iter = mapped_blocked_logs.find(it->first);
-      const BlockedLogsCommon * blocked_log = iter->second;
+    for(int w = 0 ; w < nWells ; w++) {
+      const BlockedLogsCommon * blocked_log = blockedLogs[w];
 
       if(blocked_log->GetUseForWaveletEstimation() &&
         ((modelSettings->getWaveletOutputFlag() & IO::WELL_WAVELETS)>0 || modelSettings->getEstimationMode())) {
@@ -344,7 +371,6 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
         if (writing)
           writeWaveletToFile(fileName, 1.0f,true);
       }
-      w++;
     }
 
     fftw_free(rAmp_);
@@ -888,12 +914,17 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
   std::vector<float> errWellOptScale(nWells);
   std::vector<float> errWell(nWells);
   float errOptScale = 1.0;
+
+  int n_threads = 1;
+#ifdef PARALLEL
+  n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
   //Estimate global scale, local scale and error.
   //If global scale given, do not use return value. Do kriging with global scale as mean.
   //If local scale given, run separate routine to find local noise if wanted.
   float optScale;
   if (doEstimateLocalScale || doEstimateGlobalScale) {
-    optScale = findOptimalWaveletScale(synt_r, seis_r, nWells, nzp_, dataVarWell, errOptScale, errWell, scaleOptWell, errWellOptScale);
+    optScale = findOptimalWaveletScale(synt_r, seis_r, nWells, nzp_, dataVarWell, errOptScale, errWell, scaleOptWell, errWellOptScale, n_threads);
 
     if (!doEstimateGlobalScale)
       optScale = globalScale;
@@ -911,7 +942,7 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
   else {
     optScale = globalScale;
     // only for loging
-    findOptimalWaveletScale(synt_r, seis_r, nWells, nzp_, dataVarWell, errOptScale, errWell, scaleOptWell, errWellOptScale);
+    findOptimalWaveletScale(synt_r, seis_r, nWells, nzp_, dataVarWell, errOptScale, errWell, scaleOptWell, errWellOptScale, n_threads);
   }
 
   if (optScale == RMISSING) {
@@ -1047,11 +1078,14 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
       cov.writeToFile(fileName);
     }
 
+    std::vector<Grid2D *>      localMaps;
+    std::vector<KrigingData2D> localData;
+
     if (doEstimateLocalShift)
-      estimateLocalShift(cov, shiftGrid, shiftWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+      estimateLocalShift(shiftGrid, shiftWell, nActiveData, inversion_simbox, mapped_blocked_logs, localMaps, localData);
 
     if (doEstimateLocalScale)
-      estimateLocalGain(cov, gainGrid, scaleOptWell, 1.0, nActiveData, inversion_simbox, mapped_blocked_logs);
+      estimateLocalGain(gainGrid, scaleOptWell, 1.0, nActiveData, inversion_simbox, mapped_blocked_logs, localMaps, localData);
 
     if (doEstimateLocalNoise) {
       float errStdLN;
@@ -1062,13 +1096,19 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
       if(gainGrid == NULL && doEstimateLocalScale==false && doEstimateGlobalScale==false) { // No local wavelet scale
         for(int w=0 ; w < nWells ; w++)
           errVarWell[w] = sqrt(errVarWell[w]);
-        estimateLocalNoise(cov, noiseScaled, errStdLN, errVarWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+        estimateLocalNoise(noiseScaled, errStdLN, errVarWell, nActiveData, inversion_simbox, mapped_blocked_logs, localMaps, localData);
       }
       else if (doEstimateGlobalScale==true && doEstimateLocalScale==false) // global wavelet scale
-        estimateLocalNoise(cov, noiseScaled, errStdLN,errWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+        estimateLocalNoise(noiseScaled, errStdLN,errWell, nActiveData, inversion_simbox, mapped_blocked_logs, localMaps, localData);
       else
-        estimateLocalNoise(cov, noiseScaled, errStdLN, errWellOptScale, nActiveData, inversion_simbox, mapped_blocked_logs);
+        estimateLocalNoise(noiseScaled, errStdLN, errWellOptScale, nActiveData, inversion_simbox, mapped_blocked_logs, localMaps, localData);
     }
+
+    //
+    // The shift, gain and noise maps have data in the same wells, so
+    // they share one kriging system.
+    //
+    Kriging2D::krigSurfaces(localMaps, localData, cov, n_threads);
   }
 
   float empSNRatio = dataVar/(errStd*errStd);
@@ -1124,7 +1164,8 @@ Wavelet1D::findOptimalWaveletScale(fftw_real               ** synt_seis_r,
                                    float                    & err, // NBNB-PAL: Det er uheldig å returnere err slik
                                    std::vector<float>       & errWell,
                                    std::vector<float>       & scaleOptWell,
-                                   std::vector<float>       & errWellOptScale) const
+                                   std::vector<float>       & errWellOptScale,
+                                   int                        n_threads) const
 {
   float   optScale   = 1.0f;
   float   scaleLimit = 5.0f; // Increased from 3.0 to 5.0. See Jira issue CRA-684 why
@@ -1149,6 +1190,11 @@ Wavelet1D::findOptimalWaveletScale(fftw_real               ** synt_seis_r,
   float minSeisAmp = static_cast<float> (1e-7);
   int totCount=0;
 
+  // The residual norms of each well are independent. They are summed over
+  // wells afterwards, in well order, to keep the result reproducible.
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
   for(int i=0;i<nWells;i++) {
     counter[i]=0;
     if(wellWeight[i]>0) {
@@ -1156,7 +1202,6 @@ Wavelet1D::findOptimalWaveletScale(fftw_real               ** synt_seis_r,
       for(int k=0;k<nzp;k++)
         if(fabs(seis_r[i][k]) > minSeisAmp)
           counter[i]++;
-      totCount+=counter[i];
 
       for (int j=0;j<nScales;j++) {
         resNorm[i][j]=0.0;
@@ -1168,11 +1213,18 @@ Wavelet1D::findOptimalWaveletScale(fftw_real               ** synt_seis_r,
 
           }
         }
-        error[j] += resNorm[i][j];
       }
     }//if
   }
 
+  for(int i=0;i<nWells;i++) {
+    if(wellWeight[i]>0) {
+      totCount+=counter[i];
+      for (int j=0;j<nScales;j++)
+        error[j] += resNorm[i][j];
+    }
+  }
+
   int   optInd=0;
   float optValue=error[0];
   for(int i=1;i<nScales;i++) {
@@ -1233,14 +1285,15 @@ Wavelet1D::findOptimalWaveletScale(fftw_real                ** synt_seis_r,
                                    fftw_real                ** seis_r,
                                    int                         nWells,
                                    int                         nzp,
-                                   const std::vector<float>  & wellWeight) const
+                                   const std::vector<float>  & wellWeight,
+                                   int                         n_threads) const
 {
   //Wrapper used when we don't need err, errWell, scaleOptWell and errWellOptScale later. Used in first constructor
   float err;
   std::vector<float> scaleOptWell(nWells);
   std::vector<float> errWellOptScale(nWells);
   std::vector<float> errWell(nWells);
-  float scaleOpt = findOptimalWaveletScale(synt_seis_r, seis_r, nWells, nzp, wellWeight, err, errWell, scaleOptWell, errWellOptScale);
+  float scaleOpt = findOptimalWaveletScale(synt_seis_r, seis_r, nWells, nzp, wellWeight, err, errWell, scaleOptWell, errWellOptScale, n_threads);
   return scaleOpt;
 }
 
@@ -1331,12 +1384,13 @@ Wavelet1D::findLocalNoiseWithGainGiven(fftw_real
 }
 
 void
-Wavelet1D::estimateLocalShift(const CovGrid2D                                  & cov,
-                              Grid2D                                          *& shift,
+Wavelet1D::estimateLocalShift(Grid2D                                          *& shift,
                               const std::vector<float>                         & shiftWell,
                               const std::vector<int>                           & nActiveData,
                               const Simbox                                     * simbox,
-                              const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs)
+                              const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                              std::vector<Grid2D *>                            & localMaps,
+                              std::vector<KrigingData2D>                       & localData)
 {
   //
   // NBNB-PAL: Since slightly deviated wells are accepted, we should
@@ -1370,25 +1424,27 @@ Wavelet1D::estimateLocalShift(const CovGrid2D                                  &
   shiftData.findMeanValues();
 
   //
-  // Perform kriging
+  // Kriging is done by the caller
   //
   if(shift==NULL) {
     shift = new Grid2D(simbox->getnx(),
                        simbox->getny(),
                        0.0f);
-    Kriging2D::krigSurface(*shift, shiftData, cov);
+    localMaps.push_back(shift);
+    localData.push_back(shiftData);
   }
 
 }
 
 void
-Wavelet1D::estimateLocalGain(const CovGrid2D                                  & cov,
-                             Grid2D                                          *& gain,
+Wavelet1D::estimateLocalGain(Grid2D                                          *& gain,
                              const std::vector<float>                         & scaleOptWell,
                              float                                              globalScale,
                              const std::vector<int>                           & nActiveData,
                              const Simbox                                     * simbox,
-                             const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs)
+                             const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                             std::vector<Grid2D *>                            & localMaps,
+                             std::vector<KrigingData2D>                       & localData)
 {
   //
   // Collect data for kriging
@@ -1416,25 +1472,27 @@ Wavelet1D::estimateLocalGain(const CovGrid2D                                  &
   gainData.findMeanValues();
 
   //
-  // Perform kriging
+  // Kriging is done by the caller
   //
   if(gain==NULL) {
     gain = new Grid2D(simbox->getnx(),
                        simbox->getny(),
                        globalScale);
-    Kriging2D::krigSurface(*gain, gainData, cov);
+    localMaps.push_back(gain);
+    localData.push_back(gainData);
   }
 }
 
 // Estimate local scaled noise
 void
-Wavelet1D::estimateLocalNoise(const CovGrid2D                                  & cov,
-                              Grid2D                                          *& noiseScaled,
+Wavelet1D::estimateLocalNoise(Grid2D                                          *& noiseScaled,
                               float                                              globalNoise,
                               const std::vector<float>                         & errWellOptScale,
                               const std::vector<int>                           & nActiveData,
                               const Simbox                                     * simbox,
-                              const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs)
+                              const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                              std::vector<Grid2D *>                            & localMaps,
+                              std::vector<KrigingData2D>                       & localData)
 {
   //
   // Collect data for kriging
@@ -1462,13 +1520,14 @@ Wavelet1D::estimateLocalNoise(const CovGrid2D                                  &
   noiseData.findMeanValues();
 
   //
-  // Perform kriging
+  // Kriging is done by the caller
   //
   if(noiseScaled==NULL) {
     noiseScaled = new Grid2D(simbox->getnx(),
                              simbox->getny(),
                              1.0);
-    Kriging2D::krigSurface(*noiseScaled, noiseData, cov);
+    localMaps.push_back(noiseScaled);
+    localData.push_back(noiseData);
   }
 }
 
@@ -12,7 +12,7 @@
 #include "src/seismicstorage.h"
 #include "src/blockedlogscommon.h"
 
-class CovGrid2D;
+class KrigingData2D;
 
 class Wavelet1D : public Wavelet {
 public:
@@ -108,13 +108,15 @@ private:
                                         float                    & err,
                                         std::vector<float>       & errWell,
                                         std::vector<float>       & scaleOptWell,
-                                        std::vector<float>       & errWellOptScale)   const;
+                                        std::vector<float>       & errWellOptScale,
+                                        int                        n_threads)   const;
 
   float         findOptimalWaveletScale(fftw_real               ** synt_seis_r,
                                         fftw_real               ** seis_r,
                                         int                        nWells,
                                         int                        nzp,
-                                        const std::vector<float> & wellWeight)   const;
+                                        const std::vector<float> & wellWeight,
+                                        int                        n_threads)   const;
 
   void          findLocalNoiseWithGainGiven(fftw_real                                       ** synt_r,
                                             fftw_real                                       ** seis_r,
@@ -129,28 +131,34 @@ private:
                                             const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
                                             const Simbox                                     * simbox)       const;
 
-  void          estimateLocalGain(const CovGrid2D                                  & cov,
-                                  Grid2D                                          *& gain,
+  // The local map estimators collect the well data for kriging. New maps
+  // and their data are appended to localMaps and localData, and are kriged
+  // together by the caller.
+  void          estimateLocalGain(Grid2D                                          *& gain,
                                   const std::vector<float>                         & scaleOptWell,
                                   float                                              globalScale,
                                   const std::vector<int>                           & nActiveData,
                                   const Simbox                                     * simbox,
-                                  const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs);
+                                  const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                                  std::vector<Grid2D *>                            & localMaps,
+                                  std::vector<KrigingData2D>                       & localData);
 
-  void          estimateLocalShift(const CovGrid2D                                  & cov,
-                                   Grid2D                                          *& shift,
+  void          estimateLocalShift(Grid2D                                          *& shift,
                                    const std::vector<float>                         & shiftWell,
                                    const std::vector<int>                           & nActiveData,
                                    const Simbox                                     * simbox,
-                                   const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs);
+                                   const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                                   std::vector<Grid2D *>                            & localMaps,
+                                   std::vector<KrigingData2D>                       & localData);
 
-  void          estimateLocalNoise(const CovGrid2D                                  & cov,
-                                   Grid2D                                          *& noiseScaled,
+  void          estimateLocalNoise(Grid2D                                          *& noiseScaled,
                                    float                                              globalNoise,
                                    const std::vector<float>                         & errWellOptScale,
                                    const std::vector<int>                           & nActiveData,
                                    const Simbox                                     * simbox,
-                                   const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs);
+                                   const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                                   std::vector<Grid2D *>                            & localMaps,
+                                   std::vector<KrigingData2D>                       & localData);
 
   float         shiftOptimal(fftw_real                ** ccor_seis_cpp_r,
                              const std::vector<float>  & wellWeight,
@@ -7,6 +7,7 @@
 
 #include <string.h>
 #include <assert.h>
+#include <new>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
@@ -80,10 +81,32 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
   std::vector<float>                   wellWeight(nWells, 0.0);
   std::vector<float>                   dzWell(nWells, 0.0);
 
+  std::vector<BlockedLogsCommon *>                  blockedLogs(nWells, NULL);
+  std::vector<bool>                                 useWell(nWells, false);
+  std::vector<int>                                  startWell(nWells, 0);
+  std::vector<int>                                  lengthWell(nWells, 0);
+  std::vector<std::vector<double> >                 azWell(nWells);
+  std::vector<std::vector<double> >                 bzWell(nWells);
+  std::vector<std::vector<double> >                 at0Well(nWells);
+  std::vector<std::vector<double> >                 bt0Well(nWells);
+  std::vector<std::vector<std::vector<double> > >   seisDataWell(nWells);
+
+  int nTracesX = static_cast<int> (modelSettings->getEstRangeX(angle_index) / dx);
+  int nTracesY = static_cast<int> (modelSettings->getEstRangeY(angle_index) / dy);
+
+#ifdef PARALLEL
+  int n_threads = std::max(modelSettings->getNumberOfThreads(), 1);
+#endif
+
+  //
+  // Find the data interval of each well and read the seismic traces around it.
+  // Logging and SeismicStorage access are kept in this serial pass.
+  //
   int w = 0;
   for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
     std::map<std::string, BlockedLogsCommon *>::const_iterator iter = mapped_blocked_logs.find(it->first);
     BlockedLogsCommon * blocked_log = iter->second;
+    blockedLogs[w] = blocked_log;
 
     if(blocked_log->GetUseForWaveletEstimation()) {
       LogKit::LogFormatted(LogKit::Medium, "  Well :  %s\n", blocked_log->GetWellName().c_str());
@@ -91,10 +114,10 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
       const std::vector<int> & iPos = blocked_log->GetIposVector();
       const std::vector<int> & jPos = blocked_log->GetJposVector();
 
-      std::vector<double> az(nz_);
-      std::vector<double> bz(nz_);
-      std::vector<double> at0(nz_);
-      std::vector<double> bt0(nz_);
+      azWell[w].resize(nz_);
+      bzWell[w].resize(nz_);
+      at0Well[w].resize(nz_);
+      bt0Well[w].resize(nz_);
       unsigned int nBlocks = blocked_log->GetNumberOfBlocks();
 
       calculateGradients(blocked_log,
@@ -105,18 +128,18 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
                          tGradX[w],
                          tGradY[w],
                          v0,
-                         az,
-                         bz,
-                         at0,
-                         bt0);
+                         azWell[w],
+                         bzWell[w],
+                         at0Well[w],
+                         bt0Well[w]);
 
       std::vector<bool> hasWellData(nz_);
       findLayersWithData(estimInterval,
                          blocked_log,
                          seismic_data,
                          simBox,
-                         az,
-                         bz,
+                         azWell[w],
+                         bzWell[w],
                          hasWellData);
 
       int start, length;
@@ -127,6 +150,59 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
 
       dzWell[w]          = static_cast<float>(simBox->getRelThick(iPos[0],jPos[0]) * dz_);
       if (length > nWl) {
+        useWell[w]    = true;
+        startWell[w]  = start;
+        lengthWell[w] = length;
+
+        std::vector<std::vector<double> > & seisData = seisDataWell[w];
+        seisData.resize((2*nTracesX + 1)*(2*nTracesY + 1), std::vector<double>(nz_));
+        int tr = 0;
+        for (int xTr = -nTracesX; xTr <= nTracesX; xTr++) {
+          for (int yTr = -nTracesY; yTr <= nTracesY; yTr++) {
+            std::vector<double> seis_log(nBlocks);
+            blocked_log->GetBlockedGrid(seismic_data, simBox, seis_log, xTr, yTr);
+            blocked_log->GetVerticalTrend(seis_log, seisData[tr]);
+            tr++;
+          }
+        }
+      } //if (length > nWl)
+      else {
+        LogKit::LogFormatted(LogKit::Medium,"     No enough data for 3D wavelet estimation in well %s\n", blocked_log->GetWellName().c_str());
+      }
+    } // if(wells->getUseForEstimation)
+    w++;
+  } // for (w=0...nWells)
+
+  //
+  // The prior on the wavelet coefficients only depends on the wavelet length,
+  // so it is set up once and shared by all wells.
+  //
+  std::vector<double> priorPrecision = calculatePriorPrecision(nWl, nhalfWl);
+
+  //
+  // Set up the linearised forward model G for each well, and solve for the
+  // well wavelet. The wells only share read-only data.
+  //
+  std::vector<std::string> errWell(nWells, "");
+  std::vector<int>         outOfMemory(nWells, 0);
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (int w = 0; w < static_cast<int>(nWells); w++) {
+    if (useWell[w]) {
+      try {
+        BlockedLogsCommon        * blocked_log = blockedLogs[w];
+        const std::vector<int>   & iPos        = blocked_log->GetIposVector();
+        const std::vector<int>   & jPos        = blocked_log->GetJposVector();
+        std::vector<double>       & az         = azWell[w];
+        std::vector<double>       & bz         = bzWell[w];
+        const std::vector<double> & at0        = at0Well[w];
+        const std::vector<double> & bt0        = bt0Well[w];
+        unsigned int nBlocks                   = blocked_log->GetNumberOfBlocks();
+        int start                              = startWell[w];
+        int length                             = lengthWell[w];
+
         std::string wellname(blocked_log->GetWellName());
         NRLib::Substitute(wellname,"/","_");
         NRLib::Substitute(wellname," ","_");
@@ -162,33 +238,31 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
         std::vector<double> z_pos_well(nz_);
         blocked_log->GetVerticalTrend(z_log, z_pos_well);
 
-        int nTracesX    = static_cast<int> (modelSettings->getEstRangeX(angle_index) / dx);
-        int nTracesY    = static_cast<int> (modelSettings->getEstRangeY(angle_index) / dy);
+        // The trace positions are taken along the well path, so they are the same for all traces
+        for (unsigned int b=0; b<nBlocks; b++) {
+          float zTop     = static_cast<float> (simBox->getTop(iPos[b], jPos[b]));
+//          zLog[b]         = static_cast<float> (zTop + b * simBox->getRelThick(xIndex, yIndex) * dz_);
+          z_log[b]         = static_cast<float> (zTop + b * dzWell[w]);
+        }
+        std::vector<double> z_pos_trace(nz_);
+        blocked_log->GetVerticalTrend(z_log, z_pos_trace);
 
-        std::vector<std::vector<float> > gMat;
+        // Rows of G are collected in one contiguous buffer, nWl values per data point
+        std::vector<float> gRows;
         std::vector<float> dVec;
+        std::vector<float> lambda(length*nWl);
         int nPoints = 0;
+        int tr      = 0;
         for (int xTr = -nTracesX; xTr <= nTracesX; xTr++) {
           for (int yTr = -nTracesY; yTr <= nTracesY; yTr++) {
-            std::vector<double> seis_log(nBlocks);
-            blocked_log->GetBlockedGrid(seismic_data, simBox, seis_log, xTr, yTr);
-            std::vector<double> seis_data(nz_);
-            blocked_log->GetVerticalTrend(seis_log, seis_data);
-            for (unsigned int b=0; b<nBlocks; b++) {
-              //int xIndex      = iPos[b] + xTr; //NBNB Frode: Gir warning fordi den ikkje blir brukt. Slett om du ikkje skal bruka.
-              //int yIndex      = jPos[b] + yTr; //NBNB Frode: Gir warning fordi den ikkje blir brukt. Slett om du ikkje skal bruka.
-              float zTop     = static_cast<float> (simBox->getTop(iPos[b], jPos[b]));
-//              zLog[b]         = static_cast<float> (zTop + b * simBox->getRelThick(xIndex, yIndex) * dz_);
-              z_log[b]         = static_cast<float> (zTop + b * dzWell[w]);
-            }
-            std::vector<double> z_pos_trace(nz_);
-            blocked_log->GetVerticalTrend(z_log, z_pos_trace);
+            const std::vector<double> & seis_data = seisDataWell[w][tr++];
             for (int t=start; t < start+length; t++) {
               if (seis_data[t] != RMISSING) {
                 dVec.push_back(static_cast<float>(seis_data[t]));
-                std::vector<std::vector<float> > lambda(length, std::vector<float>(nWl,0.0)); //NBNB-Frode: Br denne deklareres utenfor?
+                std::fill(lambda.begin(), lambda.end(), 0.0f);
                 for (int tau = start; tau < start+length; tau++) {
                   //Hva gjr vi hvis zData[t] er RMISSING. Kan det skje?
+                  float * lambdaTau = &lambda[(tau-start)*nWl];
                   double at = at0[tau] + 2.0f*az[tau]/v0;
                   double bt = bt0[tau] + 2.0f*bz[tau]/v0;
                   double time_scale = cos(theta_)/sqrt(1+az[tau]*az[tau]+bz[tau]*bz[tau]);
@@ -202,7 +276,7 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
                       if(i > nhalfWl)
                         indexPlace -=nWl;
                       float v = u - static_cast<float>(indexPlace*dzWell[w]*time_scale);
-                      lambda[tau-start][i] =  std::min(1.0f,static_cast<float> (2*h*dzWell[w]*1e-3 / (NRLib::Pi*(h*h + 4*v*v*1e-6)))); // invers fouriertransform of exp(-pi*h*Omega*v)
+                      lambdaTau[i] =  std::min(1.0f,static_cast<float> (2*h*dzWell[w]*1e-3 / (NRLib::Pi*(h*h + 4*v*v*1e-6)))); // invers fouriertransform of exp(-pi*h*Omega*v)
                       // the minimum of 1 and the value isto avoid problem when halpha is very small i.e. 0.0005
                     }
                   }
@@ -212,31 +286,37 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
                     float lambdaValue = static_cast<float>(u/(dzWell[w]*time_scale)) - static_cast<float> (tLow);
                     if ((tLow >= -nhalfWl) && (tHigh <= nhalfWl)) {
                       if (tLow >= 0)
-                        lambda[tau-start][tLow] = 1-lambdaValue;
+                        lambdaTau[tLow] = 1-lambdaValue;
                       else
-                        lambda[tau-start][tLow+nWl] = 1-lambdaValue;
+                        lambdaTau[tLow+nWl] = 1-lambdaValue;
                       if (tHigh < 0)
-                        lambda[tau-start][tHigh+nWl] = lambdaValue;
+                        lambdaTau[tHigh+nWl] = lambdaValue;
                       else
-                        lambda[tau-start][tHigh] = lambdaValue;
+                        lambdaTau[tHigh] = lambdaValue;
                     }
                   } // else
                 } // for (tau=start...start+length)
-                std::vector<float> gVec(nWl);
                 for (int i=0; i<nWl; i++) {
-                  gVec[i] = 0.0f;
+                  float g = 0.0f;
                   for (int j=0; j<length; j++)
-                    gVec[i] += cppAdj[j] * lambda[j][i];
+                    g += cppAdj[j] * lambda[j*nWl + i];
+                  gRows.push_back(g);
                 }
-                gMat.push_back(gVec);
                 nPoints++;
               } //if (seisData[t] != RMISSING)
             }
           }
         }
 
+        NRLib::Matrix gMat(nPoints, nWl);
+        for (int i=0; i<nPoints; i++) {
+          for (int j=0; j<nWl; j++)
+            gMat(i,j) = gRows[i*nWl + j];
+        }
+
         wellWavelets[w] = calculateWellWavelet(gMat,
                                                dVec,
+                                               priorPrecision,
                                                modelSettings->getWavelet3DTuningFactor(),
                                                nWl,
                                                nhalfWl,
@@ -252,13 +332,25 @@ Wavelet3D::Wavelet3D(const std::string                          & filterFile,
                                             gMat,
                                             wellWavelets[w],
                                             dVec);
-      } //if (length > nWl)
-      else {
-        LogKit::LogFormatted(LogKit::Medium,"     No enough data for 3D wavelet estimation in well %s\n", blocked_log->GetWellName().c_str());
       }
-    } // if(wells->getUseForEstimation)
-    w++;
-  } // for (w=0...nWells)
+      catch (NRLib::Exception & e) {
+        errWell[w] = e.what();
+      }
+      catch (std::bad_alloc &) {
+        outOfMemory[w] = 1;
+      }
+      catch (std::exception & e) {
+        errWell[w] = e.what();
+      }
+    }
+  }
+
+  for (w = 0; w < static_cast<int>(nWells); w++) {
+    if (outOfMemory[w] == 1)
+      throw std::bad_alloc();
+    if (errWell[w] != "")
+      throw NRLib::Exception(errWell[w]);
+  }
 
   rAmp_ = averageWavelets(wellWavelets, nWells, nzp_, wellWeight, dzWell, dz_);
   cAmp_ = reinterpret_cast<fftw_complex*>(rAmp_);
@@ -963,49 +1055,59 @@ Wavelet3D::calculateGradients(BlockedLogsCommon          * blocked_log,
 }
 
 
+std::vector<double>
+Wavelet3D::calculatePriorPrecision(int nWl,
+                                   int nhalfWl) const
+{
+  std::vector<double> priorPrecision(nWl);
+
+  double alpha = 4.0;
+  double beta  = 0.5;
+
+  for (int i=0; i<nWl; i++) {
+    double a;
+    if (i <= nhalfWl)
+      a = static_cast<double> (i)/ static_cast<double> (nhalfWl);
+    else
+      a = static_cast<double> (nWl-i)/ static_cast<double> (nhalfWl);
+    priorPrecision[i] = exp(alpha*a*a) / (beta * beta);
+  }
+
+  return priorPrecision;
+}
+
 std::vector<fftw_real>
-Wavelet3D::calculateWellWavelet(const std::vector<std::vector<float> > & gMat,
-                                const std::vector<float>               & dVec,
-                                double                                   SNR,
-                                int                                      nWl,
-                                int                                      nhalfWl,
-                                int                                      nPoints) const
+Wavelet3D::calculateWellWavelet(const NRLib::Matrix       & gMat,
+                                const std::vector<float>  & dVec,
+                                const std::vector<double> & priorPrecision,
+                                double                      SNR,
+                                int                         nWl,
+                                int                         nhalfWl,
+                                int                         nPoints) const
 {
   std::vector<fftw_real> wellWavelet(rnzp_, 0.0);
 
   double maxG = 0.0;
-  for (int i=0; i<nPoints; i++) {
-    for (int j=0; j<nWl; j++)
-      maxG = std::max(maxG, static_cast<double> (fabs(gMat[i][j])));
+  for (int j=0; j<nWl; j++) {
+    for (int i=0; i<nPoints; i++)
+      maxG = std::max(maxG, std::abs(gMat(i,j)));
   }
 
   //double wScale = maxD/maxG;
 
-  NRLib::SymmetricMatrix gTrg = NRLib::SymmetricZeroMatrix(nWl);
-
-  for (int i=0; i<nWl; i++) {
-    for (int j=0; j<=i; j++) {
-      for (int k=0; k<nPoints; k++)
-        gTrg(j,i) += gMat[k][i]*gMat[k][j];
-    }
-  }
+  NRLib::Vector d(nPoints);
+  for (int i=0; i<nPoints; i++)
+    d(i) = dVec[i];
 
-  NRLib::Vector gTrd = NRLib::ZeroVector(nWl);
+  NRLib::Matrix gTg  = NRLib::transpose(gMat)*gMat;
+  NRLib::Vector gTrd = NRLib::transpose(gMat)*d;
   NRLib::Vector x(nWl);
 
-  double alpha = 4.0;
-  double beta  = 0.5;
-
+  NRLib::SymmetricMatrix gTrg = NRLib::SymmetricZeroMatrix(nWl);
   for (int i=0; i<nWl; i++) {
-    double a;
-    if (i <= nhalfWl)
-      a = static_cast<double> (i)/ static_cast<double> (nhalfWl);
-    else
-      a = static_cast<double> (nWl-i)/ static_cast<double> (nhalfWl);
-    gTrg(i,i) += maxG * maxG * exp(alpha*a*a) / (SNR * beta * beta); //( GTG+ (maxG/maxD)^2*(Noise)^2*priorCov^-1)=( GTG+ maxG^2/SN*(priorCov^-1)
-
-    for (int j=0; j<nPoints; j++)
-      gTrd(i) += gMat[j][i] * dVec[j];
+    for (int j=i; j<nWl; j++)
+      gTrg(i,j) = gTg(i,j);
+    gTrg(i,i) += maxG * maxG * priorPrecision[i] / SNR; //( GTG+ (maxG/maxD)^2*(Noise)^2*priorCov^-1)=( GTG+ maxG^2/SN*(priorCov^-1)
   }
 
   NRLib::CholeskySolve(gTrg, gTrd, x);
@@ -1026,16 +1128,19 @@ Wavelet3D::calculateWellWavelet(const std::vector<std::vector<float> > & gMat,
 float
 Wavelet3D::calculateWellWeight(int nWl,
                                int nPoints,
-                               const std::vector<std::vector<float> > & gMat,
-                               const std::vector<float>               & wellWavelet,
-                               const std::vector<float>               & dVec) const
+                               const NRLib::Matrix      & gMat,
+                               const std::vector<float> & wellWavelet,
+                               const std::vector<float> & dVec) const
 {
+  NRLib::Vector wavelet(nWl);
+  for (int j=0; j<nWl; j++)
+    wavelet(j) = wellWavelet[j];
+
+  NRLib::Vector prod = gMat*wavelet;
+
   double s2 = 0.0;
   for (int i=0; i<nPoints; i++) {
-    double prod = 0.0;
-    for (int j=0; j<nWl; j++)
-      prod += static_cast<double> (gMat[i][j]*wellWavelet[j]);
-    double residual = prod - dVec[i];
+    double residual = prod(i) - dVec[i];
     s2 += residual * residual;
   }
   float weight = static_cast<float> (1/s2);
@@ -1043,10 +1148,10 @@ Wavelet3D::calculateWellWeight(int nWl,
 }
 
 void
-Wavelet3D::printMatToFile(const std::string                       & fileName,
-                          const std::vector<std::vector<float> >  & mat,
-                          int                                       n,
-                          int                                       m) const
+Wavelet3D::printMatToFile(const std::string   & fileName,
+                          const NRLib::Matrix & mat,
+                          int                   n,
+                          int                   m) const
 {
   if( ModelSettings::getDebugLevel() > 0) {
     std::string fName = fileName + IO::SuffixGeneralData();
@@ -1055,7 +1160,7 @@ Wavelet3D::printMatToFile(const std::string                       & fileName,
     NRLib::OpenWrite(file,fName);
     for(int i = 0; i < n; i++) {
       for (int j = 0; j < m; j++)
-        file << mat[i][j] << " ";
+        file << mat(i,j) << " ";
       file << "\n";
     }
     file.close();
@@ -8,6 +8,7 @@
 #include "fftw.h"
 
 #include "nrlib/surface/regularsurfacerotated.hpp"
+#include "nrlib/flens/nrlib_flens.hpp"
 
 #include "src/wavelet.h"
 #include "src/waveletfilter.h"
@@ -100,11 +101,11 @@ private:
 
   fftw_complex           findWLvalue(float omega) const;
 
-  float                  calculateWellWeight(int                                      nWl,
-                                             int                                      nPoints,
-                                             const std::vector<std::vector<float> > & gMat,
-                                             const std::vector<float>               & wellWavelet,
-                                             const std::vector<float>               & dVec) const;
+  float                  calculateWellWeight(int                        nWl,
+                                             int                        nPoints,
+                                             const NRLib::Matrix      & gMat,
+                                             const std::vector<float> & wellWavelet,
+                                             const std::vector<float> & dVec) const;
 
   std::vector<fftw_real> adjustCpp(BlockedLogsCommon         * blocked_log,
                                    const std::vector<double> & az,
@@ -130,17 +131,21 @@ private:
 
 
 
-  std::vector<fftw_real> calculateWellWavelet(const std::vector<std::vector<float> > & gMat,
-                                              const std::vector<float>               & dVec,
-                                              double                                   SNR,
-                                              int                                      nWl,
-                                              int                                      nhalfWl,
-                                              int                                      nPoints) const;
+  std::vector<double>    calculatePriorPrecision(int nWl,
+                                                 int nhalfWl) const;
 
-  void                   printMatToFile(const std::string                       & fileName,
-                                        const std::vector<std::vector<float> >  & mat,
-                                        int                                       n,
-                                        int                                       m) const;
+  std::vector<fftw_real> calculateWellWavelet(const NRLib::Matrix       & gMat,
+                                              const std::vector<float>  & dVec,
+                                              const std::vector<double> & priorPrecision,
+                                              double                      SNR,
+                                              int                         nWl,
+                                              int                         nhalfWl,
+                                              int                         nPoints) const;
+
+  void                   printMatToFile(const std::string   & fileName,
+                                        const NRLib::Matrix & mat,
+                                        int                   n,
+                                        int                   m) const;
 
   WaveletFilter                  filter_;
   Wavelet1D                    * averageWavelet_;
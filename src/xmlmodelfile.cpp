@@ -5582,6 +5582,7 @@ XmlModelFile::parseAdvancedSettings(TiXmlNode * node, std::string & errTxt)
   std::vector<std::string> legalCommands;
 #ifdef PARALLEL
   legalCommands.push_back("number-of-threads");
+  legalCommands.push_back("maximum-interval-memory");
 #endif
   legalCommands.push_back("fft-grid-padding");
   legalCommands.push_back("vp-vs-ratio");
@@ -5612,6 +5613,14 @@ XmlModelFile::parseAdvancedSettings(TiXmlNode * node, std::string & errTxt)
   int n_thread = 0;
   if (parseValue(root, "number-of-threads", n_thread, errTxt) == true)
     modelSettings_->setNumberOfThreads(n_thread);
+
+  float max_memory = 0.0f;
+  if (parseValue(root, "maximum-interval-memory", max_memory, errTxt) == true) {
+    if (max_memory < 0.0f)
+      errTxt += "The value given in command <maximum-interval-memory> must be non-negative, found "+NRLib::ToString(max_memory)+".\n";
+    else
+      modelSettings_->setMaxIntervalMemory(max_memory);
+  }
 #endif
 
   parseFFTGridPadding(root, errTxt);